@@ -9,3 +9,83 @@
 #define WIFI_CONNECT_MAX_RETRIES 10
 
 #define API_BASE_URL "https://<API_URL>/api/v1"
+
+#define SNTP_SERVER "pool.ntp.org"
+
+// offline buffer for sensor samples that could not be uploaded yet
+#define SAMPLE_BUFFER_CAPACITY 360
+#define SAMPLE_BUFFER_DROP_POLICY DROP_OLDEST
+#define SAMPLE_DRAIN_MAX_PER_CYCLE 6
+
+// samples per upload request and the maximum time a sample waits for its
+// batch, a batch size of 1 uploads every sample as single json object
+#define UPLOAD_BATCH_SIZE 6
+#define UPLOAD_BATCH_MAX_DELAY_S 60
+
+// upload and download the air quality data as CBOR instead of json, falls back
+// to json if the backend does not support it
+#define PAYLOAD_CBOR_ENABLED 1
+
+// flash backed sample store, keeps the backlog across reboots
+#define SAMPLE_STORAGE_ENABLED 1
+#define SAMPLE_STORAGE_PARTITION "samples"
+
+// samples measured before the clock is synchronized keep the boot and the
+// uptime of the measurement, the unix time of the last boots converts them
+#define KEY_BOOTID "bootid"
+#define KEY_TIMEANCHORS "timeanchors"
+#define TIME_ANCHOR_COUNT 8
+
+// downloaded air quality data, maximum number of devices and the size of the
+// table of their ids and names
+#define AIR_QUALITY_STORE_CAPACITY 16
+#define AIR_QUALITY_NAME_TABLE_SIZE 1024
+
+// run the BSEC library for the indoor air quality index, its sample rate, the
+// self heating of the board in degrees celsius and the number of samples
+// between two persisted library states (about one hour in low power mode)
+#define BSEC_ENABLED 1
+#define BSEC_SAMPLE_RATE BSEC_SAMPLE_RATE_LP
+#define BSEC_TEMPERATURE_OFFSET 0.0f
+#define BSEC_STATE_SAVE_INTERVAL 1200
+#define KEY_BSECSTATE "bsecstate"
+
+// enter light sleep while all tasks are blocked, needs CONFIG_PM_ENABLE and
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE, and the number of gestures between two
+// reports of the gesture to screen latency
+#define LIGHT_SLEEP_ENABLED 1
+#define GESTURE_LATENCY_REPORT_INTERVAL 10
+
+// gesture classification, datasets with a channel at or below the noise level
+// are ignored and a movement needs a change of the U/D or L/R ratio by the
+// sensitivity in percent. Both axes change for a diagonal gesture, the smaller
+// change by at least the diagonal ratio of the larger one in percent.
+#define GESTURE_NOISE_THRESHOLD 13
+#define GESTURE_SENSITIVITY 50
+#define GESTURE_DIAGONAL_RATIO 50
+#define GESTURE_NEAR_FAR_INTENSITY 100
+#define GESTURE_MIN_DATASETS 4
+#define GESTURE_POLL_INTERVAL_MS 20
+#define GESTURE_TIMEOUT_MS 2000
+// log the FIFO datasets of every gesture as a trace for the host test of the
+// classifier, see test/gesture_classifier_test.cpp
+#define GESTURE_TRACE_ENABLED 0
+
+// I2C clock of devices without a configuration and of the sensors, which
+// support fast mode, and the timeout of a sensor transaction
+#define I2C_DEFAULT_CLOCK_SPEED 100000
+#define I2C_FAST_MODE_CLOCK_SPEED 400000
+#define I2C_SENSOR_TIMEOUT_MS 50
+
+// e-ink command channel, number of frames sent before the display
+// acknowledged the first one, the time to wait for an acknowledgement (longer
+// for the slow screen refresh and bitmap loading) and the retransmissions of a
+// frame before it is dropped
+#define EINK_WINDOW_SIZE 4
+#define EINK_ACK_TIMEOUT_MS 2000
+#define EINK_SLOW_ACK_TIMEOUT_MS 10000
+#define EINK_MAX_RETRANSMISSIONS 2
+
+// maximum number of changed texts the e-ink driver redraws in place of the
+// whole screen
+#define EINK_PARTIAL_MAX_REGIONS 8
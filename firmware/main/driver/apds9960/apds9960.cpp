@@ -14,10 +14,20 @@ https://github.com/adafruit/Adafruit_APDS9960
 #include <string>
 
 #include "esp_timer.h"
+#include "main/config.h"
 #include "main/hal/timer/timer.h"
 #include "main/logger/logger.h"
 
-APDS9960::APDS9960(I2C *i2c) : m_i2c(i2c), m_is_connected(false) { init(); }
+APDS9960::APDS9960(I2C *i2c)
+    : m_i2c(i2c),
+      m_classifier({.noise = GESTURE_NOISE_THRESHOLD,
+                    .sensitivity = GESTURE_SENSITIVITY,
+                    .diagonal_ratio = GESTURE_DIAGONAL_RATIO,
+                    .near_far_intensity = GESTURE_NEAR_FAR_INTENSITY,
+                    .min_datasets = GESTURE_MIN_DATASETS}),
+      m_is_connected(false) {
+  init();
+}
 
 APDS9960::~APDS9960() {}
 
@@ -29,8 +39,8 @@ void APDS9960::init(uint16_t iTimeMS, apds9960AGain_t aGain, uint8_t addr) {
   Logger::info("Initializing APDS9960");
   // check if apds9960 is available by reading the ID register
   uint8_t id = 0;
-  m_i2c->read(APDS9960_ADDRESS, APDS9960_ID, &id);
-  if (id != 0xAB) {
+  if (m_i2c->read(APDS9960_ADDRESS, APDS9960_ID, &id) != ESP_OK ||
+      id != 0xAB) {
     Logger::error("APDS9960 ID not found: " + std::to_string(id));
     return;
   } else {
@@ -226,79 +236,73 @@ void APDS9960::enableGesture(bool enable) {
   resetCounts();
 }
 
-void APDS9960::resetCounts() {
-  gestCnt = 0;
-  UCount = 0;
-  DCount = 0;
-  LCount = 0;
-  RCount = 0;
+void APDS9960::enableGestureInterrupt(bool enable) {
+  // keep the current gesture mode, writing it would enter or exit a gesture
+  uint8_t ret;
+  m_i2c->read(APDS9960_ADDRESS, APDS9960_GCONF4, &ret);
+  _gconf4.set(ret);
+  _gconf4.GIEN = enable;
+  m_i2c->write(APDS9960_ADDRESS, APDS9960_GCONF4, _gconf4.get());
 }
 
-uint8_t APDS9960::readGesture() {
-  uint8_t toRead;
-  uint8_t buf[256];
-  unsigned long t = 0;
-  uint8_t gestureReceived;
-  while (1) {
-    int up_down_diff = 0;
-    int left_right_diff = 0;
-    gestureReceived = 0;
-    if (!gestureValid()) {
-      return 0;
-    }
-    Timer::sleepMS(30);
-
-    m_i2c->read(APDS9960_ADDRESS, APDS9960_GFLVL, &toRead);
-
-    // produces sideffects needed for readGesture to work
-    m_i2c->read(APDS9960_ADDRESS, APDS9960_GFIFO_U, buf, toRead);
-
-    if (abs((int)buf[0] - (int)buf[1]) > 13)
-      up_down_diff += (int)buf[0] - (int)buf[1];
+void APDS9960::setGestureThresholds(const GestureThresholds &thresholds) {
+  m_classifier.setThresholds(thresholds);
+}
 
-    if (abs((int)buf[2] - (int)buf[3]) > 13)
-      left_right_diff += (int)buf[2] - (int)buf[3];
+void APDS9960::resetCounts() { m_classifier.reset(); }
 
-    if (up_down_diff != 0) {
-      if (up_down_diff < 0) {
-        if (DCount > 0) {
-          gestureReceived = APDS9960_UP;
-        } else {
-          UCount++;
-        }
+uint8_t APDS9960::readGesture() {
+  if (!gestureValid()) {
+    return 0;
+  }
 
-      } else if (up_down_diff > 0) {
-        if (UCount > 0) {
-          gestureReceived = APDS9960_DOWN;
-        } else {
-          DCount++;
-        }
-      }
+  resetCounts();
+#if GESTURE_TRACE_ENABLED
+  std::string trace;
+#endif
+  const int64_t start = esp_timer_get_time();
+  while (true) {
+    uint8_t level = 0;
+    m_i2c->read(APDS9960_ADDRESS, APDS9960_GFLVL, &level);
+    if (level > APDS9960_FIFO_SIZE) {
+      level = APDS9960_FIFO_SIZE;
     }
 
-    if (left_right_diff != 0) {
-      if (left_right_diff < 0) {
-        if (RCount > 0) {
-          gestureReceived = APDS9960_LEFT;
-        } else {
-          LCount++;
-        }
-      } else if (left_right_diff > 0) {
-        if (LCount > 0) {
-          gestureReceived = APDS9960_RIGHT;
-        } else {
-          RCount++;
-        }
+    if (level > 0) {
+      // the FIFO address wraps from GFIFO_R to GFIFO_U, so all datasets are
+      // read in one burst of 4 bytes each
+      m_i2c->read(APDS9960_ADDRESS, APDS9960_GFIFO_U, m_fifo, level * 4);
+      m_classifier.addDatasets(m_fifo, level);
+#if GESTURE_TRACE_ENABLED
+      for (size_t i = 0; i < level * 4; i++) {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", m_fifo[i]);
+        trace += hex;
+      }
+#endif
+    } else {
+      // the gesture is complete once the state machine left the gesture mode
+      // and the FIFO is empty
+      uint8_t ret;
+      m_i2c->read(APDS9960_ADDRESS, APDS9960_GCONF4, &ret);
+      _gconf4.set(ret);
+      if (!_gconf4.GMODE) {
+        break;
       }
     }
 
-    if (up_down_diff != 0 || left_right_diff != 0) t = xTaskGetTickCount();
-
-    if (gestureReceived || xTaskGetTickCount() - t > 300) {
-      resetCounts();
-      return gestureReceived;
+    // a hand held above the sensor keeps the gesture mode active
+    if (esp_timer_get_time() - start > GESTURE_TIMEOUT_MS * 1000) {
+      break;
     }
+    Timer::sleepMS(GESTURE_POLL_INTERVAL_MS);
   }
+
+  const uint8_t gesture = m_classifier.classify();
+#if GESTURE_TRACE_ENABLED
+  Logger::info("gesture_trace " + std::to_string(gesture) + " " + trace);
+#endif
+  return gesture;
 }
 
 void APDS9960::setLED(apds9960LedDrive_t drive, apds9960LedBoost_t boost) {
@@ -11,10 +11,14 @@ https://github.com/adafruit/Adafruit_APDS9960
 
 #include <stdint.h>
 
+#include "main/driver/apds9960/gesture_classifier.h"
 #include "main/hal/i2c/i2c.h"
 
 #define APDS9960_ADDRESS (0x39)
 
+//! @brief Number of UDLR datasets the gesture FIFO holds
+#define APDS9960_FIFO_SIZE 32
+
 //! @brief APDS9960 register addresses
 enum {
   APDS9960_RAM = 0x00,
@@ -140,11 +144,6 @@ enum {
   APDS9960_GPULSE_32US = 0x03,  // Pulse 32us
 };
 
-#define APDS9960_UP 0x01     // Gesture Up
-#define APDS9960_DOWN 0x02   // Gesture Down
-#define APDS9960_LEFT 0x03   // Gesture Left
-#define APDS9960_RIGHT 0x04  // Gesture Right
-
 class APDS9960 {
  public:
   //! @brief Constructor
@@ -232,6 +231,12 @@ class APDS9960 {
   //! @param[in] enable True to enable gesture detection, false to disable.
   void enableGesture(bool enable = true);
 
+  //! @brief Enable the gesture interrupt.
+  //! @note The INT pin is pulled low while the gesture FIFO holds more
+  //! datasets than the FIFO threshold and released once it is read empty.
+  //! @param[in] enable True to enable the gesture interrupt, false to disable.
+  void enableGestureInterrupt(bool enable = true);
+
   //! @brief Check if the gesture data is valid.
   //! @return True if the gesture data is valid, false otherwise.
   bool gestureValid();
@@ -260,12 +265,19 @@ class APDS9960 {
   void setGestureOffset(uint8_t offset_up, uint8_t offset_down,
                         uint8_t offset_left, uint8_t offset_right);
 
+  //! @brief Set the thresholds of the gesture classification.
+  //! @param[in] thresholds The thresholds.
+  void setGestureThresholds(const GestureThresholds &thresholds);
+
   //! @brief Read the gesture data.
+  //! @note The FIFO is read completely until the gesture state machine exits,
+  //! all datasets of the gesture are classified.
   //! @return The gesture data @see APDS9960_UP, @see APDS9960_DOWN, @see
-  //! APDS9960_LEFT, @see APDS9960_RIGHT
+  //! APDS9960_LEFT, @see APDS9960_RIGHT, @see APDS9960_NEAR, @see
+  //! APDS9960_FAR and the diagonal gestures, 0 if no gesture was recognized
   uint8_t readGesture();
 
-  //! @brief Reset the gesture counts.
+  //! @brief Reset the gesture classification.
   void resetCounts();
 
   //! @brief Enable color reading
@@ -323,13 +335,11 @@ class APDS9960 {
  private:
   I2C *m_i2c;
 
-  uint8_t gestCnt;
-
-  uint8_t UCount;
-  uint8_t DCount;
+  //! @brief Classifier of the gesture FIFO datasets.
+  GestureClassifier m_classifier;
 
-  uint8_t LCount;
-  uint8_t RCount;
+  //! @brief Buffer for the datasets of a complete FIFO.
+  uint8_t m_fifo[APDS9960_FIFO_SIZE * 4];
 
   struct enable {
     // power on
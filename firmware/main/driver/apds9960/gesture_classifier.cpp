@@ -0,0 +1,110 @@
+#include "main/driver/apds9960/gesture_classifier.h"
+
+#include <cstdlib>
+
+GestureClassifier::GestureClassifier(const GestureThresholds& thresholds)
+    : m_thresholds(thresholds) {
+  reset();
+}
+
+void GestureClassifier::setThresholds(const GestureThresholds& thresholds) {
+  m_thresholds = thresholds;
+}
+
+void GestureClassifier::reset() {
+  m_count = 0;
+  m_sum_w = 0;
+  m_sum_wx = 0;
+  m_sum_wxx = 0;
+  m_sum_w_up_down = 0;
+  m_sum_wx_up_down = 0;
+  m_sum_w_left_right = 0;
+  m_sum_wx_left_right = 0;
+  m_peak_intensity = 0;
+}
+
+void GestureClassifier::addDatasets(const uint8_t* data, size_t count) {
+  for (size_t i = 0; i < count; i++, data += 4) {
+    const int up = data[0];
+    const int down = data[1];
+    const int left = data[2];
+    const int right = data[3];
+
+    // the ratios of datasets without a hand above the sensor are noise
+    if (up <= m_thresholds.noise || down <= m_thresholds.noise ||
+        left <= m_thresholds.noise || right <= m_thresholds.noise) {
+      continue;
+    }
+
+    const int64_t x = m_count;
+    const int up_down = (up - down) * 100 / (up + down);
+    const int left_right = (left - right) * 100 / (left + right);
+    const uint8_t intensity = (up + down + left + right) / 4;
+    m_sum_w += intensity;
+    m_sum_wx += intensity * x;
+    m_sum_wxx += intensity * x * x;
+    m_sum_w_up_down += intensity * up_down;
+    m_sum_wx_up_down += intensity * x * up_down;
+    m_sum_w_left_right += intensity * left_right;
+    m_sum_wx_left_right += intensity * x * left_right;
+    if (intensity > m_peak_intensity) {
+      m_peak_intensity = intensity;
+    }
+    m_count++;
+  }
+}
+
+int64_t GestureClassifier::getChange(int64_t sum_y, int64_t sum_xy) const {
+  const int64_t denominator = m_sum_w * m_sum_wxx - m_sum_wx * m_sum_wx;
+  if (denominator == 0) {
+    return 0;
+  }
+  // the scaling by the length of a long gesture would overflow the integers
+  const int64_t numerator = m_sum_w * sum_xy - m_sum_wx * sum_y;
+  return (float)numerator / denominator * (m_count - 1);
+}
+
+uint8_t GestureClassifier::classify() const {
+  if (m_count < m_thresholds.min_datasets || m_count < 2) {
+    return 0;
+  }
+
+  // the side the hand enters from dominates the start of the gesture, the
+  // side it leaves to the end
+  const int64_t up_down = getChange(m_sum_w_up_down, m_sum_wx_up_down);
+  const int64_t left_right =
+      getChange(m_sum_w_left_right, m_sum_wx_left_right);
+  const int64_t up_down_abs = std::llabs(up_down);
+  const int64_t left_right_abs = std::llabs(left_right);
+  const bool vertical = up_down_abs >= m_thresholds.sensitivity;
+  const bool horizontal = left_right_abs >= m_thresholds.sensitivity;
+
+  if (vertical && horizontal) {
+    const int64_t smaller = up_down_abs < left_right_abs ? up_down_abs
+                                                          : left_right_abs;
+    const int64_t larger = up_down_abs < left_right_abs ? left_right_abs
+                                                         : up_down_abs;
+    if (smaller * 100 >= larger * m_thresholds.diagonal_ratio) {
+      if (up_down < 0) {
+        return left_right < 0 ? APDS9960_UP_LEFT : APDS9960_UP_RIGHT;
+      }
+      return left_right < 0 ? APDS9960_DOWN_LEFT : APDS9960_DOWN_RIGHT;
+    }
+  }
+
+  if (vertical && up_down_abs >= left_right_abs) {
+    return up_down < 0 ? APDS9960_UP : APDS9960_DOWN;
+  }
+  if (horizontal) {
+    return left_right < 0 ? APDS9960_LEFT : APDS9960_RIGHT;
+  }
+
+  // without a movement the reflection of a hand approaching the sensor grows
+  // over the gesture, so most of the intensity falls into its second half,
+  // the one of a hand moving away fades
+  if (m_peak_intensity < m_thresholds.near_far_intensity) {
+    return 0;
+  }
+  return m_sum_wx * 2 >= m_sum_w * (m_count - 1) ? APDS9960_NEAR
+                                                 : APDS9960_FAR;
+}
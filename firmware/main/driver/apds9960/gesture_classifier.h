@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#define APDS9960_UP 0x01          // Gesture Up
+#define APDS9960_DOWN 0x02        // Gesture Down
+#define APDS9960_LEFT 0x03        // Gesture Left
+#define APDS9960_RIGHT 0x04       // Gesture Right
+#define APDS9960_NEAR 0x05        // Gesture Near
+#define APDS9960_FAR 0x06         // Gesture Far
+#define APDS9960_UP_LEFT 0x07     // Gesture Up Left
+#define APDS9960_UP_RIGHT 0x08    // Gesture Up Right
+#define APDS9960_DOWN_LEFT 0x09   // Gesture Down Left
+#define APDS9960_DOWN_RIGHT 0x0A  // Gesture Down Right
+
+//! @brief Thresholds of the gesture classification
+struct GestureThresholds {
+  //! @brief Datasets with a channel at or below this value are ignored
+  uint8_t noise;
+  //! @brief Minimum change of the U/D or L/R ratio in percent for a movement
+  uint8_t sensitivity;
+  //! @brief Minimum ratio of the smaller to the larger axis change in percent
+  //! for a diagonal gesture
+  uint8_t diagonal_ratio;
+  //! @brief Minimum mean channel value for a near or far gesture
+  uint8_t near_far_intensity;
+  //! @brief Minimum number of valid datasets of a gesture
+  uint8_t min_datasets;
+};
+
+//! @brief Classifier of the UDLR datasets of the gesture FIFO
+//! @note The datasets are processed as they are read, only the sums of a
+//! least squares fit over all valid datasets are kept. A movement is the
+//! change of the U/D and L/R ratios along the fitted line over the whole
+//! gesture, the ratios do not depend on the distance of the hand. Every
+//! dataset is weighted with its intensity, so the dim datasets of a hand
+//! entering or the wrist leaving hardly move the fit. Without a movement the
+//! intensity centroid decides between near and far.
+class GestureClassifier {
+ public:
+  //! @brief Constructor
+  //! @param thresholds The thresholds of the classification
+  GestureClassifier(const GestureThresholds& thresholds);
+
+  //! @brief Set the thresholds of the classification
+  //! @param thresholds The thresholds
+  void setThresholds(const GestureThresholds& thresholds);
+
+  //! @brief Start a new gesture
+  void reset();
+
+  //! @brief Add the datasets read from the FIFO
+  //! @param data The datasets, 4 bytes in the order U, D, L, R each
+  //! @param count The number of datasets
+  void addDatasets(const uint8_t* data, size_t count);
+
+  //! @brief Classify the datasets added since the last reset
+  //! @return The gesture, 0 if no gesture was recognized
+  uint8_t classify() const;
+
+ private:
+  //! @brief The thresholds of the classification
+  GestureThresholds m_thresholds;
+
+  //! @brief Change of a value along its weighted least squares line over the
+  //! valid datasets
+  //! @param sum_y Sum of the weighted values
+  //! @param sum_xy Sum of the weighted values times their dataset index
+  //! @return The change from the first to the last valid dataset
+  int64_t getChange(int64_t sum_y, int64_t sum_xy) const;
+
+  //! @brief Number of valid datasets
+  uint32_t m_count;
+
+  //! @brief Sum of the weights, the intensities of the valid datasets
+  int64_t m_sum_w;
+
+  //! @brief Sum of the weights times the dataset index
+  int64_t m_sum_wx;
+
+  //! @brief Sum of the weights times the squared dataset index
+  int64_t m_sum_wxx;
+
+  //! @brief Sum of the weighted U/D ratios in percent
+  int64_t m_sum_w_up_down;
+
+  //! @brief Sum of the weighted U/D ratios in percent times the dataset index
+  int64_t m_sum_wx_up_down;
+
+  //! @brief Sum of the weighted L/R ratios in percent
+  int64_t m_sum_w_left_right;
+
+  //! @brief Sum of the weighted L/R ratios in percent times the dataset index
+  int64_t m_sum_wx_left_right;
+
+  //! @brief Highest mean channel value of a valid dataset
+  uint8_t m_peak_intensity;
+};
@@ -11,6 +11,8 @@ https://github.com/adafruit/Adafruit_BME680
 
 #include <math.h>
 
+#include <algorithm>
+
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "main/hal/timer/timer.h"
@@ -18,9 +20,17 @@ https://github.com/adafruit/Adafruit_BME680
 
 BME680::BME680(I2C *i2c)
     : m_i2c(i2c),
-      m_meas_start(0),
-      m_meas_period(0),
-      m_i2c_addr(0x77),
+      m_meas_deadline(0),
+      m_steps_read(0),
+      m_op_mode(BME68X_FORCED_MODE),
+      m_heater_steps(1),
+      m_i2c_addr(BME68X_DEFAULT_ADDRESS),
+      temperature(0),
+      pressure(0),
+      humidity(0),
+      gas_resistance(0),
+      gas_resistances{},
+      m_reading_gas_resistances{},
       m_mutex(xSemaphoreCreateMutex()) {
   init();
 }
@@ -31,7 +41,8 @@ bool BME680::init() {
   Logger::info("Initializing BME680");
   gas_sensor.chip_id = m_i2c_addr;
   gas_sensor.intf = BME68X_I2C_INTF;
-  gas_sensor.intf_ptr = (void *)m_i2c;
+  // the callbacks get the driver, so they use its bus and address
+  gas_sensor.intf_ptr = (void *)this;
   gas_sensor.read = &readI2C;
   gas_sensor.write = &writeI2C;
   gas_sensor.amb_temp = 25;
@@ -104,83 +115,260 @@ uint32_t BME680::getGas(void) {
   return 0;
 }
 
+size_t BME680::getGasResistances(uint32_t *resistances, size_t max_steps) {
+  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
+    const size_t steps = std::min<size_t>(m_heater_steps, max_steps);
+    std::copy_n(gas_resistances, steps, resistances);
+    xSemaphoreGive(m_mutex);
+    return steps;
+  }
+
+  Logger::error("BME680: Failed to take mutex lock for reading gas");
+  return 0;
+}
+
 float BME680::getAltitude(float seaLevel) {
   float atmospheric = getPressure() / 100.0F;
   return 44330.0 * (1.0 - pow(atmospheric / seaLevel, 0.1903));
 }
 
-bool BME680::readData() { return endReading(); }
-
-uint32_t BME680::beginReading(void) {
-  if (m_meas_start != 0) {
-    /* A measurement is already in progress */
-    return m_meas_start + m_meas_period;
+bool BME680::readData() {
+  if (beginReading() == 0) {
+    return false;
   }
 
-  int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &gas_sensor);
-  if (rslt != BME68X_OK) return false;
+  while (true) {
+    const int remaining_millis = remainingReadingMillis();
+    if (remaining_millis > 0) {
+      Timer::sleepMS(remaining_millis);
+    }
 
-  /* Calculate delay period in microseconds */
-  uint32_t delayus_period = (uint32_t)bme68x_get_meas_dur(
-                                BME68X_FORCED_MODE, &gas_conf, &gas_sensor) +
-                            ((uint32_t)gas_heatr_conf.heatr_dur * 1000);
+    const ReadingState state = pollReading();
+    if (state != READING_PENDING) {
+      return state == READING_DONE;
+    }
 
-  m_meas_start = esp_timer_get_time();
-  m_meas_period = delayus_period / 1000;
+    // the conversion took longer than calculated, check again shortly
+    Timer::sleepMS(10);
+  }
+}
 
-  return m_meas_start + m_meas_period;
+bool BME680::setOversampling(uint8_t temperature, uint8_t pressure,
+                             uint8_t humidity) {
+  if (temperature > BME68X_OS_16X || pressure > BME68X_OS_16X ||
+      humidity > BME68X_OS_16X) {
+    return false;
+  }
+
+  gas_conf.os_temp = temperature;
+  gas_conf.os_pres = pressure;
+  gas_conf.os_hum = humidity;
+
+  int8_t rslt = bme68x_set_conf(&gas_conf, &gas_sensor);
+  return rslt == 0;
 }
 
-bool BME680::endReading(void) {
-  uint32_t meas_end = beginReading();
+bool BME680::setHeaterProfile(uint8_t op_mode, const uint16_t *temperatures,
+                              const uint16_t *durations, uint8_t length,
+                              uint16_t shared_duration) {
+  if (m_meas_deadline != 0) {
+    Logger::error("BME680: Can not change heater profile while measuring");
+    return false;
+  }
+  if (length == 0 || length > BME680_HEATER_PROFILE_MAX_STEPS ||
+      (op_mode != BME68X_FORCED_MODE && op_mode != BME68X_PARALLEL_MODE &&
+       op_mode != BME68X_SEQUENTIAL_MODE)) {
+    Logger::error("BME680: Invalid heater profile");
+    return false;
+  }
+  if (op_mode == BME68X_FORCED_MODE) {
+    length = 1;
+  }
 
-  if (meas_end == 0) {
+  for (uint8_t step = 0; step < length; step++) {
+    m_heater_temperatures[step] = temperatures[step];
+    m_heater_durations[step] = durations[step];
+  }
+
+  // like setGasHeater, a forced mode step without temperature or duration
+  // disables the heater
+  const bool heater_disabled =
+      op_mode == BME68X_FORCED_MODE &&
+      (m_heater_temperatures[0] == 0 || m_heater_durations[0] == 0);
+  gas_heatr_conf.enable = heater_disabled ? BME68X_DISABLE : BME68X_ENABLE;
+  gas_heatr_conf.heatr_temp = m_heater_temperatures[0];
+  gas_heatr_conf.heatr_dur = m_heater_durations[0];
+  gas_heatr_conf.heatr_temp_prof = m_heater_temperatures;
+  gas_heatr_conf.heatr_dur_prof = m_heater_durations;
+  gas_heatr_conf.profile_len = length;
+  gas_heatr_conf.shared_heatr_dur = shared_duration;
+
+  int8_t rslt = bme68x_set_heatr_conf(op_mode, &gas_heatr_conf, &gas_sensor);
+  if (rslt != BME68X_OK) {
+    Logger::error("BME680: Failed to set heater profile");
     return false;
   }
 
-  int remaining_millis = remainingReadingMillis();
+  m_op_mode = op_mode;
+  m_heater_steps = length;
+  return true;
+}
 
+int64_t BME680::beginReading(void) {
+  if (m_meas_deadline != 0) {
+    /* A measurement is already in progress */
+    return m_meas_deadline;
+  }
+
+  int8_t rslt = bme68x_set_op_mode(m_op_mode, &gas_sensor);
+  if (rslt != BME68X_OK) {
+    Logger::error("BME680: Failed to start measurement");
+    return 0;
+  }
+
+  /* The steps of the heater profile run back to back */
+  int64_t deadline = esp_timer_get_time();
+  for (uint8_t step = 0; step < m_heater_steps; step++) {
+    deadline += getStepDuration(step);
+    m_step_deadlines[step] = deadline;
+    m_reading_gas_resistances[step] = 0;
+  }
+  m_steps_read = 0;
+  m_meas_deadline = deadline;
+  return m_meas_deadline;
+}
+
+BME680::ReadingState BME680::pollReading(void) {
+  const int remaining_millis = remainingReadingMillis();
+  if (remaining_millis == reading_not_started) {
+    return READING_FAILED;
+  }
   if (remaining_millis > 0) {
-    Timer::sleepMS(remaining_millis * 2);
-    /* Delay till the measurement is ready */
+    return READING_PENDING;
   }
-  m_meas_start = 0; /* Allow new measurement to begin */
-  m_meas_period = 0;
 
-  struct bme68x_data data;
+  ReadingState state = endReading();
+  if (state == READING_PENDING &&
+      esp_timer_get_time() - m_meas_deadline <
+          BME680_READING_TIMEOUT_MS * 1000) {
+    return READING_PENDING;
+  }
+
+  m_meas_deadline = 0; /* Allow new measurement to begin */
+  if (m_op_mode != BME68X_FORCED_MODE) {
+    /* Parallel and sequential mode keep measuring until stopped */
+    bme68x_set_op_mode(BME68X_SLEEP_MODE, &gas_sensor);
+  }
+
+  if (state == READING_PENDING) {
+    if (m_steps_read == 0) {
+      Logger::error("BME680: Measurement timed out");
+      return READING_FAILED;
+    }
+
+    /* Steps that were overwritten before they were read are reported as 0 */
+    Logger::warn("BME680: Missed steps of the heater profile");
+    state = READING_DONE;
+  }
+  if (state == READING_DONE && xSemaphoreTake(m_mutex, (TickType_t)10) ==
+                                   pdTRUE) {
+    for (uint8_t step = 0; step < m_heater_steps; step++) {
+      gas_resistances[step] = m_reading_gas_resistances[step];
+    }
+    xSemaphoreGive(m_mutex);
+  }
+  return state;
+}
+
+BME680::ReadingState BME680::endReading(void) {
+  /* Parallel and sequential mode buffer up to three fields */
+  struct bme68x_data data[3];
   uint8_t n_fields;
 
-  int8_t rslt =
-      bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &gas_sensor);
-  if (rslt != BME68X_OK) return false;
-
-  if (n_fields) {
-    if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
-      temperature = data.temperature;
-      humidity = data.humidity;
-      pressure = data.pressure;
-
-      if (data.status & (BME68X_HEAT_STAB_MSK | BME68X_GASM_VALID_MSK)) {
-        gas_resistance = data.gas_resistance;
-      } else {
-        gas_resistance = 0;
-      }
-      xSemaphoreGive(m_mutex);
+  /* Without new data the library polls the forced mode field five times with
+   * a delay of 10 ms, check the status first to not block */
+  if (m_op_mode == BME68X_FORCED_MODE) {
+    uint8_t status;
+    if (bme68x_get_regs(BME68X_REG_FIELD0, &status, 1, &gas_sensor) !=
+        BME68X_OK) {
+      return READING_FAILED;
+    }
+    if (!(status & BME68X_NEW_DATA_MSK)) {
+      return READING_PENDING;
+    }
+  }
+
+  int8_t rslt = bme68x_get_data(m_op_mode, data, &n_fields, &gas_sensor);
+  if (rslt == BME68X_W_NO_NEW_DATA) {
+    return READING_PENDING;
+  }
+  if (rslt != BME68X_OK) {
+    return READING_FAILED;
+  }
+
+  for (uint8_t field = 0; field < n_fields; field++) {
+    const uint8_t step =
+        m_op_mode == BME68X_FORCED_MODE ? 0 : data[field].gas_index;
+    if (step >= m_heater_steps) {
+      continue;
+    }
+
+    const bool gas_valid =
+        data[field].status & (BME68X_HEAT_STAB_MSK | BME68X_GASM_VALID_MSK);
+    m_reading_gas_resistances[step] =
+        gas_valid ? data[field].gas_resistance : 0;
+    m_steps_read |= 1 << step;
+  }
+
+  /* The fields are sorted, the last one is the most recent */
+  if (n_fields && !storeReading(data[n_fields - 1])) {
+    return READING_FAILED;
+  }
+
+  return m_steps_read == (1 << m_heater_steps) - 1 ? READING_DONE
+                                                  : READING_PENDING;
+}
+
+bool BME680::storeReading(const struct bme68x_data &data) {
+  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
+    temperature = data.temperature;
+    humidity = data.humidity;
+    pressure = data.pressure;
+
+    if (data.status & (BME68X_HEAT_STAB_MSK | BME68X_GASM_VALID_MSK)) {
+      gas_resistance = data.gas_resistance;
     } else {
-      Logger::error("BME680: Failed to take mutex lock for setting data");
-      return false;
+      gas_resistance = 0;
     }
+    xSemaphoreGive(m_mutex);
+    return true;
   }
 
-  return true;
+  Logger::error("BME680: Failed to take mutex lock for setting data");
+  return false;
+}
+
+uint32_t BME680::getStepDuration(uint8_t step) {
+  const uint32_t meas_dur =
+      bme68x_get_meas_dur(m_op_mode, &gas_conf, &gas_sensor);
+  if (m_op_mode == BME68X_PARALLEL_MODE) {
+    /* The duration is a multiple of the measurement cycle */
+    return m_heater_durations[step] *
+           (meas_dur + (uint32_t)gas_heatr_conf.shared_heatr_dur * 1000);
+  }
+  return meas_dur + (uint32_t)m_heater_durations[step] * 1000;
 }
 
 int BME680::remainingReadingMillis(void) {
-  if (m_meas_start != 0) {
-    /* A measurement is already in progress */
-    int remaining_time =
-        (int)m_meas_period - (esp_timer_get_time() - m_meas_start);
-    return remaining_time < 0 ? reading_complete : remaining_time;
+  if (m_meas_deadline != 0) {
+    /* Wait for the first step whose data was not read yet, round up */
+    uint8_t step = 0;
+    while (step < m_heater_steps - 1 && (m_steps_read & (1 << step))) {
+      step++;
+    }
+    int64_t remaining_time = m_step_deadlines[step] - esp_timer_get_time();
+    return remaining_time <= 0 ? reading_complete
+                               : (int)((remaining_time + 999) / 1000);
   }
   return reading_not_started;
 }
@@ -193,6 +381,10 @@ bool BME680::setGasHeater(uint16_t heaterTemp, uint16_t heaterTime) {
     gas_heatr_conf.heatr_temp = heaterTemp;
     gas_heatr_conf.heatr_dur = heaterTime;
   }
+  m_heater_temperatures[0] = heaterTemp;
+  m_heater_durations[0] = heaterTime;
+  m_op_mode = BME68X_FORCED_MODE;
+  m_heater_steps = 1;
 
   int8_t rslt =
       bme68x_set_heatr_conf(BME68X_FORCED_MODE, &gas_heatr_conf, &gas_sensor);
@@ -245,18 +437,23 @@ bool BME680::setIIRFilterSize(uint8_t filtersize) {
 
 int8_t BME680::readI2C(uint8_t reg_addr, uint8_t *reg_data, uint32_t len,
                        void *intf_ptr) {
-  I2C *m_i2c = static_cast<I2C *>(intf_ptr);
+  BME680 *bme680 = static_cast<BME680 *>(intf_ptr);
 
-  m_i2c->read(0x77, reg_addr, reg_data, len);
-
-  return 0;
+  if (bme680->m_i2c->read(bme680->m_i2c_addr, reg_addr, reg_data, len) !=
+      ESP_OK) {
+    return BME68X_E_COM_FAIL;
+  }
+  return BME68X_OK;
 }
 
 int8_t BME680::writeI2C(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len,
                         void *intf_ptr) {
-  I2C *m_i2c = static_cast<I2C *>(intf_ptr);
-  m_i2c->write(0x77, reg_addr, reg_data, len);
-  return 0;
+  BME680 *bme680 = static_cast<BME680 *>(intf_ptr);
+  if (bme680->m_i2c->write(bme680->m_i2c_addr, reg_addr, reg_data, len) !=
+      ESP_OK) {
+    return BME68X_E_COM_FAIL;
+  }
+  return BME68X_OK;
 }
 
 void BME680::delayMicroseconds(uint32_t us, void *intf_ptr) {
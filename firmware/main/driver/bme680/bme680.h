@@ -16,6 +16,13 @@ https://github.com/adafruit/Adafruit_BME680
 
 #define BME68X_DEFAULT_ADDRESS (0x77)
 
+//! @brief Maximum time in milliseconds a measurement may take longer than
+//! calculated before it is given up
+#define BME680_READING_TIMEOUT_MS 500
+
+//! @brief Maximum number of steps of a heater profile
+#define BME680_HEATER_PROFILE_MAX_STEPS 10
+
 class BME680 {
  public:
   //! Constructor
@@ -30,6 +37,16 @@ class BME680 {
   //! Flag to indicate that the sensor reading is completed
   static constexpr int reading_complete = 0;
 
+  //! @brief The state of a measurement
+  enum ReadingState {
+    //! @brief The measurement is still running
+    READING_PENDING,
+    //! @brief The results of the measurement were stored
+    READING_DONE,
+    //! @brief The measurement failed or was not started
+    READING_FAILED
+  };
+
   //! @brief Get the last temperature reading
   //! @return Temperature in degrees C
   float getTemperature();
@@ -46,15 +63,73 @@ class BME680 {
   //! @return VOC in ohms
   uint32_t getGas();
 
+  //! @brief Get the volatile organic compound readings of every step of the
+  //! heater profile of the last reading
+  //! @param resistances Array to store the VOC in ohms per step in, 0 for
+  //! steps without a valid measurement
+  //! @param max_steps The number of elements of the array
+  //! @return The number of steps written, 0 if the mutex was not available
+  size_t getGasResistances(uint32_t *resistances, size_t max_steps);
+
   //! @brief Get the last altitude reading
   //! @param seaLevel Sea level pressure in Pascals
   //! @return Altitude in meters
   float getAltitude(float seaLevel);
 
   //! @brief Perform a reading and store the results in class variables
+  //! @note Blocks until the measurement is complete, use beginReading and
+  //! pollReading to measure without blocking
   //! @return True if successful, false if there was an error
   bool readData();
 
+  //! @brief Set the oversampling of the temperature, pressure and humidity
+  //! @param temperature Temperature oversampling setting
+  //! @param pressure Pressure oversampling setting
+  //! @param humidity Humidity oversampling setting
+  //! @return True if successful, false if there was an error
+  bool setOversampling(uint8_t temperature, uint8_t pressure,
+                       uint8_t humidity);
+
+  //! @brief Set the heater profile measured by every reading
+  //! @note In BME68X_FORCED_MODE only the first step is used, a temperature
+  //! or duration of 0 disables the heater. In
+  //! BME68X_SEQUENTIAL_MODE the durations are in milliseconds, in
+  //! BME68X_PARALLEL_MODE they are multiples of one measurement cycle, which
+  //! lasts the shared duration plus the conversion time.
+  //! @param op_mode The operation mode
+  //! @param temperatures The heater temperature of every step in degrees C
+  //! @param durations The heating duration of every step
+  //! @param length The number of steps, at most
+  //! BME680_HEATER_PROFILE_MAX_STEPS
+  //! @param shared_duration The heating duration in milliseconds shared by
+  //! all steps in parallel mode
+  //! @return True if successful, false if there was an error
+  bool setHeaterProfile(uint8_t op_mode, const uint16_t *temperatures,
+                        const uint16_t *durations, uint8_t length,
+                        uint16_t shared_duration = 0);
+
+  //! @brief Start a measurement without waiting for it
+  //! @note With a heater profile the measurement covers all steps
+  //! @note If a measurement is already in progress its deadline is returned
+  //! @return Time in microseconds since boot when the data is ready, 0 if
+  //! there was an error
+  int64_t beginReading();
+
+  //! @brief Complete the measurement started with beginReading
+  //! @note Never waits for the measurement, once the deadline passed the
+  //! results are read and stored in class variables
+  //! @return READING_DONE if the results were stored, READING_PENDING if the
+  //! measurement is still running, READING_FAILED on error
+  ReadingState pollReading();
+
+  //! @brief get the remaining time in milliseconds until the next data of
+  //! the measurement is ready
+  //! @note With a heater profile the data of every step has to be polled
+  //! before the sensor overwrites it
+  //! @return milliseconds to wait until the data is ready, reading_complete
+  //! if the deadline passed or reading_not_started
+  int remainingReadingMillis();
+
  private:
   //! @brief Initialize the sensor
   bool init();
@@ -89,18 +164,22 @@ class BME680 {
   //! @return True if successful, false if there was an error
   bool setODR(uint8_t odr);
 
-  //! @brief begin reading data from the sensor
-  //! @return milliseconds to wait until the data is ready
-  uint32_t beginReading();
+  //! @brief Read the results of the measurement and store them
+  //! @note The results of up to three steps are read in one burst
+  //! @return READING_DONE if the results of all steps were stored,
+  //! READING_PENDING if the sensor has no new data of some steps yet,
+  //! READING_FAILED on error
+  ReadingState endReading();
 
-  //! @brief end reading data from the sensor
+  //! @brief Store the results of the measurement in the class variables
+  //! @param data The results of the last step
   //! @return True if successful, false if there was an error
-  bool endReading();
+  bool storeReading(const struct bme68x_data &data);
 
-  //! @brief get the remaining time in milliseconds until the measurement is
-  //! complete
-  //! @return milliseconds to wait until the data is ready
-  int remainingReadingMillis();
+  //! @brief Get the duration of a step of the heater profile
+  //! @param step The step
+  //! @return The duration in microseconds
+  uint32_t getStepDuration(uint8_t step);
 
   //! Pointer to the I2C hal
   I2C *m_i2c;
@@ -108,11 +187,27 @@ class BME680 {
   //! Sensor ID
   int32_t _sensorID;
 
-  //! Timestamp of the start of the measurement
-  uint32_t m_meas_start;
+  //! Time in microseconds since boot when the measurement is complete, 0 if
+  //! no measurement is in progress
+  int64_t m_meas_deadline;
 
-  //! Measurement period in milliseconds
-  uint16_t m_meas_period;
+  //! Time in microseconds since boot when the data of each step is ready
+  int64_t m_step_deadlines[BME680_HEATER_PROFILE_MAX_STEPS];
+
+  //! Bit mask of the steps whose data was read
+  uint16_t m_steps_read;
+
+  //! Operation mode of the measurements
+  uint8_t m_op_mode;
+
+  //! Heater temperature of each step of the profile in degrees C
+  uint16_t m_heater_temperatures[BME680_HEATER_PROFILE_MAX_STEPS];
+
+  //! Heating duration of each step of the profile
+  uint16_t m_heater_durations[BME680_HEATER_PROFILE_MAX_STEPS];
+
+  //! Number of steps of the heater profile
+  uint8_t m_heater_steps;
 
   //! I2C address
   uint8_t m_i2c_addr;
@@ -131,7 +226,7 @@ class BME680 {
   //! @param reg_addr Register address
   //! @param reg_data Pointer to the data to be read
   //! @param len Number of bytes to read
-  //! @param intf_ptr Pointer to the I2C interface
+  //! @param intf_ptr Pointer to the driver
   //! @return 0 if successful, non-zero otherwise
   static int8_t readI2C(uint8_t reg_addr, uint8_t *reg_data, uint32_t len,
                         void *interface);
@@ -141,7 +236,7 @@ class BME680 {
   //! @param reg_addr Register address
   //! @param reg_data Pointer to the data to be written
   //! @param len Number of bytes to write
-  //! @param intf_ptr Pointer to the I2C interface
+  //! @param intf_ptr Pointer to the driver
   //! @return 0 if successful, non-zero otherwise
   static int8_t writeI2C(uint8_t reg_addr, const uint8_t *reg_data,
                          uint32_t len, void *interface);
@@ -165,6 +260,12 @@ class BME680 {
   //! cached gas in ohms
   uint32_t gas_resistance;
 
+  //! cached gas in ohms of each step of the heater profile
+  uint32_t gas_resistances[BME680_HEATER_PROFILE_MAX_STEPS];
+
+  //! gas in ohms of each step of the running measurement
+  uint32_t m_reading_gas_resistances[BME680_HEATER_PROFILE_MAX_STEPS];
+
   // mutex
   SemaphoreHandle_t m_mutex;
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "main/driver/eink/display_list.h"
+
+//! @brief FNV-1a offset basis and prime of the 64 bit hash
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+//! @brief Add bytes to a FNV-1a hash
+//! @param hash The hash
+//! @param data The bytes
+//! @param len The number of bytes
+//! @return The updated hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+DisplayList::DisplayList()
+    : m_font_size(FontSize::SMALL), m_recorded_font_size(0) {}
+
+DisplayList::~DisplayList() {}
+
+void DisplayList::reset() {
+  m_primitives.clear();
+  m_texts.clear();
+  // the font of the display is unknown until the list sets it
+  m_recorded_font_size = 0;
+}
+
+void DisplayList::clearDisplay() {
+  m_primitives.push_back({.type = PRIMITIVE_CLEAR});
+}
+
+void DisplayList::setFontSize(FontSize font_size) { m_font_size = font_size; }
+
+void DisplayList::drawText(uint16_t x, uint16_t y, std::string_view text) {
+  if (m_recorded_font_size != m_font_size) {
+    m_primitives.push_back(
+        {.type = PRIMITIVE_FONT_SIZE, .font_size = m_font_size});
+    m_recorded_font_size = m_font_size;
+  }
+  addTextPrimitive(PRIMITIVE_TEXT, x, y, text);
+  m_primitives.back().font_size = m_font_size;
+}
+
+void DisplayList::drawBitmap(uint16_t x, uint16_t y,
+                             std::string_view filename) {
+  addTextPrimitive(PRIMITIVE_BITMAP, x, y, filename);
+}
+
+void DisplayList::updateDisplay() {
+  m_primitives.push_back({.type = PRIMITIVE_UPDATE});
+}
+
+const std::vector<DisplayPrimitive>& DisplayList::getPrimitives() const {
+  return m_primitives;
+}
+
+bool DisplayList::hasSameLayout(const DisplayList& other) const {
+  if (m_primitives.size() != other.m_primitives.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < m_primitives.size(); i++) {
+    const DisplayPrimitive& primitive = m_primitives[i];
+    const DisplayPrimitive& other_primitive = other.m_primitives[i];
+    if (primitive.type != other_primitive.type ||
+        primitive.x != other_primitive.x || primitive.y != other_primitive.y ||
+        primitive.font_size != other_primitive.font_size) {
+      return false;
+    }
+    if (primitive.type == PRIMITIVE_BITMAP &&
+        getText(primitive) != other.getText(other_primitive)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t DisplayList::getHash() const {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  // the fields are hashed one by one, the padding of the struct is undefined
+  for (const DisplayPrimitive& primitive : m_primitives) {
+    const uint8_t type = primitive.type;
+    const uint8_t font_size = primitive.font_size;
+    hash = hashBytes(hash, &type, sizeof(type));
+    hash = hashBytes(hash, &primitive.x, sizeof(primitive.x));
+    hash = hashBytes(hash, &primitive.y, sizeof(primitive.y));
+    hash = hashBytes(hash, &font_size, sizeof(font_size));
+    hash = hashBytes(hash, &primitive.text_len, sizeof(primitive.text_len));
+    const std::string_view text = getText(primitive);
+    hash = hashBytes(hash, text.data(), text.size());
+  }
+  return hash;
+}
+
+std::string_view DisplayList::getText(const DisplayPrimitive& primitive) const {
+  return std::string_view(m_texts).substr(primitive.text_offset,
+                                          primitive.text_len);
+}
+
+void DisplayList::addTextPrimitive(DisplayPrimitiveType type, uint16_t x,
+                                   uint16_t y, std::string_view text) {
+  m_primitives.push_back({.type = type,
+                          .x = x,
+                          .y = y,
+                          .text_offset = (uint16_t)m_texts.size(),
+                          .text_len = (uint16_t)text.size()});
+  m_texts.append(text);
+}
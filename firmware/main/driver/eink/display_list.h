@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "main/driver/eink/eink.h"
+
+//! @brief Type of a recorded display primitive
+enum DisplayPrimitiveType {
+  PRIMITIVE_CLEAR,
+  PRIMITIVE_FONT_SIZE,
+  PRIMITIVE_TEXT,
+  PRIMITIVE_BITMAP,
+  PRIMITIVE_UPDATE
+};
+
+//! @brief A recorded display primitive
+struct DisplayPrimitive {
+  //! @brief The type of the primitive
+  DisplayPrimitiveType type = PRIMITIVE_CLEAR;
+  //! @brief The x coordinate of a text or bitmap
+  uint16_t x = 0;
+  //! @brief The y coordinate of a text or bitmap
+  uint16_t y = 0;
+  //! @brief The font size of a font size change or a text
+  FontSize font_size = FontSize::SMALL;
+  //! @brief Offset of the text or filename in the string table
+  uint16_t text_offset = 0;
+  //! @brief Length of the text or filename
+  uint16_t text_len = 0;
+};
+
+//! @brief Retained list of the primitives of a screen
+//! @note The UI records a screen into the list, which is sent to the display
+//! with EInk::render. Font size changes are only recorded in front of the next
+//! text that needs a different font, so repeated or unused changes cost no
+//! frame. The texts share one string table, a reset list keeps its memory for
+//! the next screen.
+class DisplayList {
+ public:
+  //! @brief Constructor
+  DisplayList();
+
+  //! @brief Destructor
+  ~DisplayList();
+
+  //! @brief Remove all primitives to record a new screen.
+  void reset();
+
+  //! @brief Record clearing the display content in the buffer.
+  void clearDisplay();
+
+  //! @brief Set the font size for the following texts.
+  //! @param[in] font_size The font size to set.
+  void setFontSize(FontSize font_size);
+
+  //! @brief Record drawing a text.
+  //! @param[in] x The x coordinate of the text.
+  //! @param[in] y The y coordinate of the text.
+  //! @param[in] text The text to draw.
+  void drawText(uint16_t x, uint16_t y, std::string_view text);
+
+  //! @brief Record drawing a bitmap.
+  //! @param[in] x The x coordinate of the bitmap.
+  //! @param[in] y The y coordinate of the bitmap.
+  //! @param[in] filename The filename of the bitmap to draw.
+  void drawBitmap(uint16_t x, uint16_t y, std::string_view filename);
+
+  //! @brief Record updating and refreshing the display.
+  void updateDisplay();
+
+  //! @brief Get the recorded primitives.
+  //! @return The primitives in the order they are sent.
+  const std::vector<DisplayPrimitive>& getPrimitives() const;
+
+  //! @brief Check if another list draws the same screen apart from the
+  //! content of its texts.
+  //! @param[in] other The other display list.
+  //! @return True if the primitives only differ in their texts.
+  bool hasSameLayout(const DisplayList& other) const;
+
+  //! @brief Get the hash of the recorded screen.
+  //! @note FNV-1a over the primitives and their texts, equal lists have equal
+  //! hashes.
+  //! @return The hash of the list.
+  uint64_t getHash() const;
+
+  //! @brief Get the text or filename of a primitive.
+  //! @param[in] primitive The primitive.
+  //! @return The text, valid until the list is changed.
+  std::string_view getText(const DisplayPrimitive& primitive) const;
+
+ private:
+  //! @brief Add a text or filename to the string table.
+  //! @param[in] type The type of the primitive.
+  //! @param[in] x The x coordinate.
+  //! @param[in] y The y coordinate.
+  //! @param[in] text The text or filename.
+  void addTextPrimitive(DisplayPrimitiveType type, uint16_t x, uint16_t y,
+                        std::string_view text);
+
+  //! @brief The recorded primitives.
+  std::vector<DisplayPrimitive> m_primitives;
+
+  //! @brief The texts and filenames of the primitives.
+  std::string m_texts;
+
+  //! @brief The font size set by the UI.
+  FontSize m_font_size;
+
+  //! @brief The font size of the display after the recorded primitives, 0 if
+  //! it is unknown.
+  uint8_t m_recorded_font_size;
+};
@@ -1,18 +1,65 @@
 #include "main/driver/eink/eink.h"
 
-#include <vector>
+#include <algorithm>
 
 #include "esp_timer.h"
+#include "main/config.h"
+#include "main/driver/eink/display_list.h"
 #include "main/logger/logger.h"
 
+//! @brief Frames of the commands without runtime parameters, encoded at
+//! compile time
+static constexpr auto SLEEP_FRAME = encodeEInkFrame(0x08);
+static constexpr auto UPDATE_FRAME = encodeEInkFrame(0x0A);
+static constexpr auto CLEAR_FRAME = encodeEInkFrame(0x2E);
+static constexpr std::array<std::array<uint8_t, 10>, 2> MEMORY_FRAMES = {
+    encodeEInkFrame<1>(0x07, {MemoryMode::MEM_NAND}),
+    encodeEInkFrame<1>(0x07, {MemoryMode::MEM_TF})};
+static constexpr std::array<std::array<uint8_t, 10>, 3> FONT_SIZE_FRAMES = {
+    encodeEInkFrame<1>(0x1F, {FontSize::SMALL}),
+    encodeEInkFrame<1>(0x1F, {FontSize::MEDIUM}),
+    encodeEInkFrame<1>(0x1F, {FontSize::LARGE})};
+
+static_assert(UPDATE_FRAME == std::array<uint8_t, 9>{0xA5, 0x00, 0x09, 0x0A,
+                                                     0xCC, 0x33, 0xC3, 0x3C,
+                                                     0xA6},
+              "Frame encoding does not match the display protocol");
+
 EInk::EInk(Uart* uart, DigitalOutputPin* display_wakeup_pin)
     : m_uart(uart),
       m_display_wakeup_pin(display_wakeup_pin),
-      m_display_sleeping(false) {
+      m_display_sleeping(false),
+      m_channel(uart),
+      m_rendered_list(new DisplayList()),
+      m_rendered_hash(0),
+      m_rendered_dropped_frames(0),
+      m_renders(0),
+      m_skipped_renders(0) {
   init();
 }
 
-EInk::~EInk() {}
+EInk::~EInk() { delete m_rendered_list; }
+
+//! @brief Get the height of a font
+//! @param font_size The font size
+//! @return The height of the characters in pixels
+static uint16_t getFontHeight(FontSize font_size) {
+  switch (font_size) {
+    case FontSize::SMALL:
+      return 32;
+    case FontSize::MEDIUM:
+      return 48;
+    default:
+      return 64;
+  }
+}
+
+//! @brief Get the width of a character the panel draws in a font
+//! @note The ASCII glyphs are half as wide as the font is high, wider than
+//! the advance the UI centers its texts with.
+static uint16_t getGlyphWidth(FontSize font_size) {
+  return getFontHeight(font_size) / 2;
+}
 
 void EInk::init() {
   Logger::info("Initializing eink display.");
@@ -30,14 +77,13 @@ void EInk::wakeUp() {
 }
 
 void EInk::sleep() {
-  EInkCommand command(0x08);
-  sendCommand(command);
+  sendFrame(SLEEP_FRAME.data(), SLEEP_FRAME.size());
   m_display_sleeping = true;
 }
 
 void EInk::setMemory(MemoryMode mode) {
-  EInkCommand command(0x07, {static_cast<uint8_t>(mode)});
-  sendCommand(command);
+  const auto& frame = MEMORY_FRAMES[mode];
+  sendFrame(frame.data(), frame.size());
 }
 
 void EInk::setBaudRate(uint32_t baud_rate) {
@@ -48,18 +94,22 @@ void EInk::setBaudRate(uint32_t baud_rate) {
 }
 
 void EInk::updateDisplay() {
-  EInkCommand command(0x0A);
-  sendCommand(command);
+  sendFrame(UPDATE_FRAME.data(), UPDATE_FRAME.size());
   Logger::debug("Trigger update");
 }
 
 void EInk::clearDisplay() {
-  EInkCommand command(0x2E);
-  sendCommand(command);
+  sendFrame(CLEAR_FRAME.data(), CLEAR_FRAME.size());
 }
 
 void EInk::setFontSize(FontSize font_size) {
-  EInkCommand command(0x1F, {static_cast<uint8_t>(font_size)});
+  const auto& frame = FONT_SIZE_FRAMES[font_size - FontSize::SMALL];
+  sendFrame(frame.data(), frame.size());
+}
+
+void EInk::setColor(Color foreground, Color background) {
+  EInkCommand command(0x10, {static_cast<uint8_t>(foreground),
+                             static_cast<uint8_t>(background)});
   sendCommand(command);
 }
 
@@ -71,13 +121,10 @@ void EInk::setDirection(DisplayDirection direction) {
 void EInk::drawPoint(uint16_t x, uint16_t y) {
   EInkCommand command(
       0x20, {(uint8_t)(x >> 8), (uint8_t)(x), (uint8_t)(y >> 8), (uint8_t)(y)});
-  command.printCommand();
   sendCommand(command);
 }
 
 void EInk::drawLine(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
-  Logger::debug("Draw line: " + std::to_string(x1) + " " + std::to_string(y1) +
-                " " + std::to_string(x2) + " " + std::to_string(y2));
   EInkCommand command(0x22, {
                                 (uint8_t)(x1 >> 8),
                                 (uint8_t)(x1),
@@ -182,37 +229,149 @@ void EInk::drawFilledTriangle(uint16_t x1, uint16_t y1, uint16_t x2,
   sendCommand(command);
 }
 
-void EInk::drawText(uint16_t x, uint16_t y, const std::string& text) {
-  std::vector<uint8_t> data;
-  data.push_back((uint8_t)(x >> 8));
-  data.push_back((uint8_t)(x));
-  data.push_back((uint8_t)(y >> 8));
-  data.push_back((uint8_t)(y));
-  for (int i = 0; i < text.size(); i++) {
-    data.push_back(text[i]);
-  }
-  EInkCommand command(0x30, data);
+void EInk::drawText(uint16_t x, uint16_t y, std::string_view text) {
+  EInkCommand command(
+      0x30, {(uint8_t)(x >> 8), (uint8_t)(x), (uint8_t)(y >> 8), (uint8_t)(y)},
+      text);
   sendCommand(command);
 }
 
 void EInk::sendCommand(const EInkCommand& command) {
+  beginCommand();
+  // the channel sends the frame without waiting for the reply of the
+  // display, it blocks only while the window of unacknowledged frames is full
+  m_channel.send(command);
+}
+
+void EInk::sendFrame(const uint8_t* frame, size_t length) {
+  beginCommand();
+  m_channel.sendFrame(frame, length);
+}
+
+void EInk::beginCommand() {
   if (m_display_sleeping) {
     wakeUp();
   }
-  m_uart->sendData(command.getCommand());
-  // display should send "OK" after receiving command, but it would be to slow,
-  // if we wait
-}
-
-void EInk::drawBitmap(uint16_t x, uint16_t y, const std::string& filename) {
-  std::vector<uint8_t> data;
-  data.push_back((uint8_t)(x >> 8));
-  data.push_back((uint8_t)(x));
-  data.push_back((uint8_t)(y >> 8));
-  data.push_back((uint8_t)(y));
-  for (int i = 0; i < filename.size(); i++) {
-    data.push_back(filename[i]);
+  // the screen no longer matches the last rendered display list, render sets
+  // the hash again once the whole list was sent
+  m_rendered_hash = 0;
+}
+
+bool EInk::render(const DisplayList& display_list) {
+  // a dropped frame may have left the last screen incomplete
+  const uint64_t hash = display_list.getHash();
+  const bool rendered_valid =
+      m_rendered_hash != 0 &&
+      m_channel.getDroppedFrames() == m_rendered_dropped_frames;
+  if (rendered_valid && hash == m_rendered_hash) {
+    m_skipped_renders++;
+    return false;
+  }
+
+  if (!rendered_valid || !display_list.hasSameLayout(*m_rendered_list) ||
+      !renderChanges(display_list)) {
+    renderAll(display_list);
   }
-  EInkCommand command(0x70, data);
+
+  *m_rendered_list = display_list;
+  m_rendered_hash = hash;
+  m_rendered_dropped_frames = m_channel.getDroppedFrames();
+  m_renders++;
+  return true;
+}
+
+void EInk::renderAll(const DisplayList& display_list) {
+  for (const DisplayPrimitive& primitive : display_list.getPrimitives()) {
+    switch (primitive.type) {
+      case PRIMITIVE_CLEAR:
+        clearDisplay();
+        break;
+      case PRIMITIVE_FONT_SIZE:
+        setFontSize(primitive.font_size);
+        break;
+      case PRIMITIVE_TEXT:
+        drawText(primitive.x, primitive.y, display_list.getText(primitive));
+        break;
+      case PRIMITIVE_BITMAP:
+        drawBitmap(primitive.x, primitive.y, display_list.getText(primitive));
+        break;
+      case PRIMITIVE_UPDATE:
+        updateDisplay();
+        break;
+    }
+  }
+}
+
+bool EInk::renderChanges(const DisplayList& display_list) {
+  const auto& primitives = display_list.getPrimitives();
+  const auto& rendered_primitives = m_rendered_list->getPrimitives();
+  size_t changed[EINK_PARTIAL_MAX_REGIONS];
+  size_t changed_count = 0;
+  for (size_t i = 0; i < primitives.size(); i++) {
+    if (primitives[i].type == PRIMITIVE_TEXT &&
+        display_list.getText(primitives[i]) !=
+            m_rendered_list->getText(rendered_primitives[i])) {
+      if (changed_count == EINK_PARTIAL_MAX_REGIONS) {
+        return false;
+      }
+      changed[changed_count++] = i;
+    }
+  }
+
+  // clear the glyphs of the old and the new text in the background color
+  setColor(Color::WHITE, Color::WHITE);
+  for (size_t j = 0; j < changed_count; j++) {
+    const size_t i = changed[j];
+    const DisplayPrimitive& primitive = primitives[i];
+    const uint16_t height = getFontHeight(primitive.font_size);
+    const size_t length =
+        std::max(primitive.text_len, rendered_primitives[i].text_len);
+    const size_t width = length * getGlyphWidth(primitive.font_size);
+    const size_t x2 = std::min<size_t>(primitive.x + width, EINK_WIDTH) - 1;
+    const size_t y2 = std::min<size_t>(primitive.y + height, EINK_HEIGHT) - 1;
+    drawFilledRectangle(primitive.x, primitive.y, x2, y2);
+  }
+
+  setColor(Color::BLACK, Color::WHITE);
+  uint8_t font_size = 0;
+  for (size_t j = 0; j < changed_count; j++) {
+    const size_t i = changed[j];
+    const DisplayPrimitive& primitive = primitives[i];
+    if (primitive.font_size != font_size) {
+      setFontSize(primitive.font_size);
+      font_size = primitive.font_size;
+    }
+    drawText(primitive.x, primitive.y, display_list.getText(primitive));
+  }
+
+  // the panel has no partial refresh, the whole panel is refreshed from the
+  // buffer
+  updateDisplay();
+  return true;
+}
+
+bool EInk::waitUntilIdle(int timeout_ms) {
+  return m_channel.waitUntilIdle(timeout_ms);
+}
+
+uint32_t EInk::getRenders() const { return m_renders; }
+
+uint32_t EInk::getSkippedRenders() const { return m_skipped_renders; }
+
+uint16_t EInk::getFontAdvance(FontSize font_size) {
+  switch (font_size) {
+    case FontSize::SMALL:
+      return 10;
+    case FontSize::MEDIUM:
+      return 15;
+    default:
+      return 30;
+  }
+}
+
+void EInk::drawBitmap(uint16_t x, uint16_t y, std::string_view filename) {
+  EInkCommand command(
+      0x70, {(uint8_t)(x >> 8), (uint8_t)(x), (uint8_t)(y >> 8), (uint8_t)(y)},
+      filename);
   sendCommand(command);
 }
\ No newline at end of file
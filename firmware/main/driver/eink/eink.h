@@ -1,7 +1,8 @@
 #pragma once
 
-#include <string>
+#include <string_view>
 
+#include "main/driver/eink/eink_channel.h"
 #include "main/driver/eink/eink_command.h"
 #include "main/hal/digital_output_pin/digital_output_pin.h"
 #include "main/hal/uart/uart.h"
@@ -15,6 +16,15 @@ enum DisplayDirection { DIR0 = 0, DIR90 = 1, DIR180 = 2, DIR270 = 3 };
 // enum with NAND/TF memory mode
 enum MemoryMode { MEM_NAND = 0, MEM_TF = 1 };
 
+// enum with the black/dark gray/light gray/white colors
+enum Color { BLACK = 0, DARK_GRAY = 1, LIGHT_GRAY = 2, WHITE = 3 };
+
+//! @brief Resolution of the display in pixels
+#define EINK_WIDTH 800
+#define EINK_HEIGHT 600
+
+class DisplayList;
+
 class EInk {
  public:
   //! Constructor
@@ -46,6 +56,11 @@ class EInk {
   //! @param[in] font_size The font size to set.
   void setFontSize(FontSize font_size);
 
+  //! @brief Set the colors for the following drawings in the buffer.
+  //! @param[in] foreground The color of the drawings and texts.
+  //! @param[in] background The color behind texts.
+  void setColor(Color foreground, Color background);
+
   //! @brief Set the display direction.
   //! @param[in] direction The direction to set.
   void setDirection(DisplayDirection direction);
@@ -112,19 +127,70 @@ class EInk {
   //! @param[in] x The x coordinate of the text.
   //! @param[in] y The y coordinate of the text.
   //! @param[in] text The text to draw.
-  void drawText(uint16_t x, uint16_t y, const std::string& text);
+  void drawText(uint16_t x, uint16_t y, std::string_view text);
 
   //! @brief Draw a bitmap in the buffer.
   //! @param[in] x The x coordinate of the bitmap.
   //! @param[in] y The y coordinate of the bitmap.
   //! @param[in] filename The filename of the bitmap to draw.
-  void drawBitmap(uint16_t x, uint16_t y, const std::string& filename);
+  void drawBitmap(uint16_t x, uint16_t y, std::string_view filename);
+
+  //! @brief Send a frame encoded at compile time.
+  //! @param[in] frame The frame, see encodeEInkFrame and
+  //! encodeEInkBitmapFrame.
+  //! @param[in] length The length of the frame.
+  void sendFrame(const uint8_t* frame, size_t length);
+
+  //! @brief Send the primitives of a display list.
+  //! @note The frames are sent back to back, only limited by the window of
+  //! unacknowledged frames. Nothing is sent if the list equals the last
+  //! rendered one and the display was not drawn on since. If only texts
+  //! changed, just their regions are cleared and redrawn.
+  //! @param[in] display_list The display list to send.
+  //! @return True if the list was sent, false if it was skipped.
+  bool render(const DisplayList& display_list);
+
+  //! @brief Wait until the display acknowledged all commands.
+  //! @param[in] timeout_ms The maximum time to wait in ms.
+  //! @return True if all commands were acknowledged or dropped, false on
+  //! timeout.
+  bool waitUntilIdle(int timeout_ms);
+
+  //! @brief Get the number of rendered display lists.
+  //! @return The number of display lists that were sent.
+  uint32_t getRenders() const;
+
+  //! @brief Get the number of skipped display lists.
+  //! @return The number of display lists skipped because the screen was
+  //! unchanged.
+  uint32_t getSkippedRenders() const;
+
+  //! @brief Get the horizontal advance of the characters of a font.
+  //! @note An estimate the UI centers its texts with, the glyphs the panel
+  //! draws are wider, so a redrawn text is cleared with the glyph width.
+  //! @param[in] font_size The font size.
+  //! @return The width of a character in pixels.
+  static uint16_t getFontAdvance(FontSize font_size);
 
  private:
+  //! @brief Send all primitives of a display list.
+  //! @param[in] display_list The display list to send.
+  void renderAll(const DisplayList& display_list);
+
+  //! @brief Redraw the texts that differ from the last rendered display list.
+  //! @note The list has to have the same layout as the last rendered one.
+  //! @param[in] display_list The display list to send.
+  //! @return True if the texts were redrawn, false if too many changed.
+  bool renderChanges(const DisplayList& display_list);
+
   //! @brief Send a command to the display.
   //! @param[in] command The command to send.
   void sendCommand(const EInkCommand& command);
 
+  //! @brief Prepare the display for the next frame.
+  //! @note Wakes the display up and forgets the last rendered display list.
+  void beginCommand();
+
   //! @brief Force wake up the display.
   //! @return True if the display is awake, false otherwise.
   void wakeUp();
@@ -141,4 +207,24 @@ class EInk {
   //! @brief Sleep mode of the display. True if the display is sleeping. False
   //! otherwise.
   bool m_display_sleeping;
+
+  //! @brief The acknowledged command channel to the display.
+  EInkChannel m_channel;
+
+  //! @brief Copy of the last rendered display list.
+  DisplayList* m_rendered_list;
+
+  //! @brief Hash of the last rendered display list, 0 if the display was
+  //! drawn on without a display list since.
+  uint64_t m_rendered_hash;
+
+  //! @brief Number of frames the channel had dropped after the last rendered
+  //! display list was sent.
+  uint32_t m_rendered_dropped_frames;
+
+  //! @brief Number of rendered display lists.
+  uint32_t m_renders;
+
+  //! @brief Number of display lists skipped because the screen was unchanged.
+  uint32_t m_skipped_renders;
 };
\ No newline at end of file
@@ -0,0 +1,271 @@
+#include "main/driver/eink/eink_channel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "esp_timer.h"
+#include "main/logger/logger.h"
+
+#define IDLE_BIT BIT0
+
+//! @brief Size of the buffer the replies are read into
+#define RX_CHUNK_SIZE 32
+
+EInkChannel::EInkChannel(Uart* uart)
+    : m_uart(uart),
+      m_first_frame(0),
+      m_outstanding_frames(0),
+      m_sent_frames(0),
+      m_state(STATE_PIPELINED),
+      m_recovery_frames(0),
+      m_discard_replies(false),
+      m_last_rx_time(0),
+      m_quiet_timeout_ms(EINK_ACK_TIMEOUT_MS),
+      m_last_ack_time(0),
+      m_reply_len(0),
+      m_retransmissions(0),
+      m_dropped_frames(0),
+      m_window(xSemaphoreCreateCounting(EINK_WINDOW_SIZE, EINK_WINDOW_SIZE)),
+      m_idle_events(xEventGroupCreate()),
+      m_mutex(xSemaphoreCreateMutex()),
+      m_rx_task_handle(NULL) {
+  init();
+}
+
+EInkChannel::~EInkChannel() {
+  if (m_rx_task_handle != NULL) {
+    vTaskDelete(m_rx_task_handle);
+  }
+  vSemaphoreDelete(m_mutex);
+  vEventGroupDelete(m_idle_events);
+  vSemaphoreDelete(m_window);
+}
+
+void EInkChannel::init() {
+  xEventGroupSetBits(m_idle_events, IDLE_BIT);
+  xTaskCreate(
+      [](void* channel_ptr) {
+        EInkChannel* channel = (EInkChannel*)channel_ptr;
+        while (true) {
+          channel->receiveReplies();
+        }
+      },
+      "eink_rx_task", 3072, this, 5, &m_rx_task_handle);
+}
+
+bool EInkChannel::send(const EInkCommand& command) {
+  if (command.getLength() > EINK_FRAME_MAX_SIZE) {
+    Logger::error("EInk command does not fit into a frame");
+    return false;
+  }
+  EInkFrame& frame = beginFrame();
+  frame.length = command.serialize(frame.data, sizeof(frame.data));
+  endFrame(frame);
+  return true;
+}
+
+bool EInkChannel::sendFrame(const uint8_t* data, size_t length) {
+  if (length > EINK_FRAME_MAX_SIZE) {
+    Logger::error("EInk frame is too long");
+    return false;
+  }
+  // the frame is copied, it is sent again if it is not acknowledged
+  EInkFrame& frame = beginFrame();
+  memcpy(frame.data, data, length);
+  frame.length = length;
+  endFrame(frame);
+  return true;
+}
+
+EInkFrame& EInkChannel::beginFrame() {
+  // wait for a free frame of the window
+  xSemaphoreTake(m_window, portMAX_DELAY);
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const size_t index =
+      (m_first_frame + m_outstanding_frames) % EINK_WINDOW_SIZE;
+  return m_frames[index];
+}
+
+void EInkChannel::endFrame(EInkFrame& frame) {
+  frame.sent_time = esp_timer_get_time();
+  frame.retransmissions = 0;
+  // the display answers after the refresh or after loading the bitmap
+  const uint8_t type = frame.data[3];
+  frame.timeout_ms = (type == 0x0A || type == 0x70) ? EINK_SLOW_ACK_TIMEOUT_MS
+                                                    : EINK_ACK_TIMEOUT_MS;
+  if (m_outstanding_frames == 0) {
+    m_last_ack_time = frame.sent_time;
+    xEventGroupClearBits(m_idle_events, IDLE_BIT);
+  }
+  m_outstanding_frames++;
+  // while recovering the frame is sent once the earlier frames are through
+  if (m_state == STATE_PIPELINED) {
+    m_uart->sendData(frame.data, frame.length);
+    m_sent_frames++;
+  }
+  xSemaphoreGive(m_mutex);
+}
+
+bool EInkChannel::waitUntilIdle(int timeout_ms) {
+  return xEventGroupWaitBits(m_idle_events, IDLE_BIT, pdFALSE, pdTRUE,
+                             pdMS_TO_TICKS(timeout_ms)) &
+         IDLE_BIT;
+}
+
+uint32_t EInkChannel::getDroppedFrames() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const uint32_t dropped_frames = m_dropped_frames;
+  xSemaphoreGive(m_mutex);
+  return dropped_frames;
+}
+
+void EInkChannel::receiveReplies() {
+  uint8_t data[RX_CHUNK_SIZE];
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const int timeout_ms = m_state == STATE_DRAINING
+                             ? getRemainingQuietMillis()
+                             : getRemainingTimeoutMillis();
+  xSemaphoreGive(m_mutex);
+  const size_t len = m_uart->receiveData(data, sizeof(data), timeout_ms);
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  if (len > 0) {
+    m_last_rx_time = esp_timer_get_time();
+  }
+  for (size_t i = 0; i < len; i++) {
+    parseReply(data[i]);
+  }
+  if (m_state == STATE_DRAINING) {
+    if (getRemainingQuietMillis() == 0) {
+      finishDrain();
+    }
+  } else if (m_sent_frames > 0 && getRemainingTimeoutMillis() == 0) {
+    Logger::warn("EInk frame was not acknowledged in time");
+    startDrain(false);
+  }
+  xSemaphoreGive(m_mutex);
+}
+
+void EInkChannel::parseReply(uint8_t byte) {
+  // keep the end of the reply, the display only sends short tokens
+  if (m_reply_len == sizeof(m_reply)) {
+    memmove(m_reply, m_reply + 1, sizeof(m_reply) - 1);
+    m_reply_len--;
+  }
+  m_reply[m_reply_len++] = (char)byte;
+
+  if (m_reply_len >= 2 && m_reply[m_reply_len - 2] == 'O' &&
+      m_reply[m_reply_len - 1] == 'K') {
+    m_reply_len = 0;
+    if (m_discard_replies || m_sent_frames == 0) {
+      return;
+    }
+    releaseFirstFrame();
+    if (m_state != STATE_STOP_AND_WAIT) {
+      return;
+    }
+    m_recovery_frames--;
+    if (m_recovery_frames > 0) {
+      resendFirstFrame();
+    } else {
+      Logger::debug("Recovered EInk channel, " +
+                    std::to_string(m_retransmissions) +
+                    " frames retransmitted so far");
+      m_state = STATE_PIPELINED;
+      sendPendingFrames();
+    }
+  } else if (m_reply_len >= 5 &&
+             memcmp(m_reply + m_reply_len - 5, "Error", 5) == 0) {
+    m_reply_len = 0;
+    Logger::warn("EInk display rejected a frame");
+    if (m_sent_frames > 0) {
+      startDrain(true);
+    }
+  }
+}
+
+void EInkChannel::releaseFirstFrame() {
+  m_first_frame = (m_first_frame + 1) % EINK_WINDOW_SIZE;
+  m_outstanding_frames--;
+  m_sent_frames--;
+  m_last_ack_time = esp_timer_get_time();
+  if (m_outstanding_frames == 0) {
+    xEventGroupSetBits(m_idle_events, IDLE_BIT);
+  }
+  xSemaphoreGive(m_window);
+}
+
+void EInkChannel::startDrain(bool discard_replies) {
+  // the display may still work on any of the sent frames
+  if (m_state != STATE_DRAINING) {
+    m_quiet_timeout_ms = EINK_ACK_TIMEOUT_MS;
+    for (size_t i = 0; i < m_sent_frames; i++) {
+      m_quiet_timeout_ms =
+          std::max(m_quiet_timeout_ms,
+                   m_frames[(m_first_frame + i) % EINK_WINDOW_SIZE].timeout_ms);
+    }
+  }
+  m_state = STATE_DRAINING;
+  m_discard_replies = m_discard_replies || discard_replies;
+  m_last_rx_time = esp_timer_get_time();
+}
+
+void EInkChannel::finishDrain() {
+  m_discard_replies = false;
+  m_reply_len = 0;
+  if (m_sent_frames > 0 &&
+      m_frames[m_first_frame].retransmissions >= EINK_MAX_RETRANSMISSIONS) {
+    m_dropped_frames++;
+    Logger::error("Dropping unacknowledged EInk frame, " +
+                  std::to_string(m_dropped_frames) + " dropped so far");
+    releaseFirstFrame();
+  }
+
+  m_recovery_frames = m_sent_frames;
+  m_sent_frames = 0;
+  if (m_recovery_frames == 0) {
+    m_state = STATE_PIPELINED;
+    sendPendingFrames();
+    return;
+  }
+  m_state = STATE_STOP_AND_WAIT;
+  resendFirstFrame();
+}
+
+void EInkChannel::resendFirstFrame() {
+  EInkFrame& frame = m_frames[m_first_frame];
+  frame.retransmissions++;
+  frame.sent_time = esp_timer_get_time();
+  m_last_ack_time = frame.sent_time;
+  m_sent_frames = 1;
+  m_retransmissions++;
+  m_uart->sendData(frame.data, frame.length);
+}
+
+void EInkChannel::sendPendingFrames() {
+  const int64_t now = esp_timer_get_time();
+  for (; m_sent_frames < m_outstanding_frames; m_sent_frames++) {
+    EInkFrame& frame =
+        m_frames[(m_first_frame + m_sent_frames) % EINK_WINDOW_SIZE];
+    frame.sent_time = now;
+    m_uart->sendData(frame.data, frame.length);
+  }
+}
+
+int EInkChannel::getRemainingTimeoutMillis() {
+  if (m_sent_frames == 0) {
+    return EINK_ACK_TIMEOUT_MS;
+  }
+  const EInkFrame& frame = m_frames[m_first_frame];
+  const int64_t start = std::max(frame.sent_time, m_last_ack_time);
+  const int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
+  return elapsed_ms >= frame.timeout_ms ? 0 : frame.timeout_ms - elapsed_ms;
+}
+
+int EInkChannel::getRemainingQuietMillis() {
+  const int64_t elapsed_ms = (esp_timer_get_time() - m_last_rx_time) / 1000;
+  return elapsed_ms >= m_quiet_timeout_ms ? 0
+                                          : m_quiet_timeout_ms - elapsed_ms;
+}
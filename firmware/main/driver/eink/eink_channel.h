@@ -0,0 +1,189 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "main/config.h"
+#include "main/driver/eink/eink_command.h"
+#include "main/hal/uart/uart.h"
+
+//! @brief A frame that was sent but not acknowledged yet
+struct EInkFrame {
+  //! @brief The serialized frame
+  uint8_t data[EINK_FRAME_MAX_SIZE];
+  //! @brief The length of the frame
+  size_t length;
+  //! @brief Time in microseconds when the frame was last sent
+  int64_t sent_time;
+  //! @brief Time in milliseconds to wait for the acknowledgement
+  int timeout_ms;
+  //! @brief Number of retransmissions of the frame
+  uint8_t retransmissions;
+};
+
+//! @brief Acknowledged command channel to the e-ink display
+//! @note The display answers every frame with "OK" in order. Up to
+//! EINK_WINDOW_SIZE frames are sent without waiting, the replies are parsed by
+//! the receive task, which frees the oldest frame on every "OK". The replies
+//! carry no sequence number, so if the display reports an error or the oldest
+//! frame is not acknowledged in time, nothing is sent until the line was quiet
+//! for a full timeout. A late "OK" received meanwhile still frees its frame.
+//! The frames that are still unacknowledged are then sent again one at a time
+//! (stop and wait), before the window is used again.
+class EInkChannel {
+ public:
+  //! @brief Constructor
+  //! @param uart Pointer to the UART hal
+  EInkChannel(Uart* uart);
+
+  //! @brief Destructor
+  ~EInkChannel();
+
+  //! @brief Initialize the channel and start the receive task.
+  void init();
+
+  //! @brief Send a command to the display.
+  //! @note Blocks while the window is full.
+  //! @param command The command to send.
+  //! @return True if the command was sent, false if it does not fit into a
+  //! frame.
+  bool send(const EInkCommand& command);
+
+  //! @brief Send an encoded frame to the display.
+  //! @note Blocks while the window is full.
+  //! @param data The frame, see encodeEInkFrame.
+  //! @param length The length of the frame.
+  //! @return True if the frame was sent, false if it is too long.
+  bool sendFrame(const uint8_t* data, size_t length);
+
+  //! @brief Wait until the display acknowledged all frames or they were
+  //! dropped.
+  //! @param timeout_ms The maximum time to wait in ms.
+  //! @return True if no frame is outstanding, false on timeout.
+  bool waitUntilIdle(int timeout_ms);
+
+  //! @brief Get the number of frames dropped without acknowledgement.
+  //! @return The number of dropped frames since startup.
+  uint32_t getDroppedFrames();
+
+ private:
+  //! @brief Wait for a free frame of the window and take the mutex.
+  //! @return The free frame.
+  EInkFrame& beginFrame();
+
+  //! @brief Send a frame filled after beginFrame and give the mutex.
+  //! @param frame The frame.
+  void endFrame(EInkFrame& frame);
+
+  //! @brief Receive and parse the replies, retransmit timed out frames.
+  //! @note Runs in the receive task.
+  void receiveReplies();
+
+  //! @brief Parse a byte of the replies of the display.
+  //! @param byte The received byte.
+  void parseReply(uint8_t byte);
+
+  //! @brief Free the oldest frame.
+  //! @note The mutex has to be held.
+  void releaseFirstFrame();
+
+  //! @brief Stop sending and wait until the line is quiet.
+  //! @note The mutex has to be held.
+  //! @param discard_replies True to ignore the replies until the line is
+  //! quiet, they can not be assigned to a frame after an error.
+  void startDrain(bool discard_replies);
+
+  //! @brief Start sending the unacknowledged frames again one at a time, drop
+  //! the oldest frame once it reached EINK_MAX_RETRANSMISSIONS.
+  //! @note The mutex has to be held.
+  void finishDrain();
+
+  //! @brief Send the oldest frame again as the only unacknowledged frame.
+  //! @note The mutex has to be held.
+  void resendFirstFrame();
+
+  //! @brief Send the outstanding frames that were not sent yet.
+  //! @note The mutex has to be held.
+  void sendPendingFrames();
+
+  //! @brief Get the time in ms until the oldest frame times out.
+  //! @note The mutex has to be held.
+  //! @return The remaining time, EINK_ACK_TIMEOUT_MS if no frame was sent.
+  int getRemainingTimeoutMillis();
+
+  //! @brief Get the time in ms until the line counts as quiet.
+  //! @note The mutex has to be held.
+  //! @return The remaining time, 0 if nothing was received for a full
+  //! timeout.
+  int getRemainingQuietMillis();
+
+  //! @brief The transmission state of the channel
+  enum State {
+    //! frames are sent as soon as the window has room
+    STATE_PIPELINED = 0,
+    //! nothing is sent until the replies to the sent frames stopped
+    STATE_DRAINING = 1,
+    //! the unacknowledged frames are sent again one at a time
+    STATE_STOP_AND_WAIT = 2
+  };
+
+  //! @brief Pointer to the UART hal
+  Uart* m_uart;
+
+  //! @brief The outstanding frames, a ring starting at m_first_frame
+  EInkFrame m_frames[EINK_WINDOW_SIZE];
+
+  //! @brief Index of the oldest outstanding frame
+  size_t m_first_frame;
+
+  //! @brief Number of outstanding frames
+  size_t m_outstanding_frames;
+
+  //! @brief Number of outstanding frames that were sent, starting with the
+  //! oldest one
+  size_t m_sent_frames;
+
+  //! @brief The transmission state
+  State m_state;
+
+  //! @brief Number of frames left to send one at a time
+  size_t m_recovery_frames;
+
+  //! @brief Flag if the replies are ignored until the line is quiet
+  bool m_discard_replies;
+
+  //! @brief Time in microseconds of the last received byte while draining
+  int64_t m_last_rx_time;
+
+  //! @brief Time in milliseconds without a reply until the line is quiet
+  int m_quiet_timeout_ms;
+
+  //! @brief Time in microseconds of the last acknowledgement, the display
+  //! starts on the oldest frame once it finished the previous one
+  int64_t m_last_ack_time;
+
+  //! @brief The last received bytes of the current reply
+  char m_reply[8];
+
+  //! @brief Number of bytes in m_reply
+  size_t m_reply_len;
+
+  //! @brief Number of retransmitted frames
+  uint32_t m_retransmissions;
+
+  //! @brief Number of frames dropped without acknowledgement
+  uint32_t m_dropped_frames;
+
+  //! @brief Counts the free frames of the window
+  SemaphoreHandle_t m_window;
+
+  //! @brief Set while no frame is outstanding
+  EventGroupHandle_t m_idle_events;
+
+  //! @brief Mutex to protect the frames
+  SemaphoreHandle_t m_mutex;
+
+  //! @brief Handle of the receive task
+  TaskHandle_t m_rx_task_handle;
+};
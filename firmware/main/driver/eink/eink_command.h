@@ -1,30 +1,135 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <vector>
+#include <initializer_list>
+#include <string_view>
 
-//! @brief Class to generate eink commands
+//! @brief Maximum number of fixed parameters of a command
+#define EINK_COMMAND_MAX_PARAMS 12
+
+//! @brief Maximum size of a frame, 9 bytes of framing and up to 1024 bytes of
+//! command data
+#define EINK_FRAME_MAX_SIZE (9 + 1024)
+
+//! @brief Encode a frame into a buffer
+//! @note 1 byte frame header, 2 byte frame length, 1 byte command type, 0 -
+//! 1024 bytes data, 4 bytes frame end and 1 byte parity. The buffer has to
+//! hold 9 bytes more than the parameters and the payload.
+//! @param buffer The buffer to write the frame to
+//! @param command Command number
+//! @param params Fixed parameters
+//! @param params_len Number of fixed parameters
+//! @param payload Data following the parameters
+//! @param payload_len Length of the payload
+//! @return The length of the frame
+constexpr size_t encodeEInkFrame(uint8_t *buffer, uint8_t command,
+                                 const uint8_t *params, size_t params_len,
+                                 const char *payload, size_t payload_len) {
+  const size_t command_length = 9 + params_len + payload_len;
+  size_t pos = 0;
+
+  // add frame header, frame length and command type
+  buffer[pos++] = 0xA5;
+  buffer[pos++] = (uint8_t)(command_length >> 8);
+  buffer[pos++] = (uint8_t)(command_length);
+  buffer[pos++] = command;
+
+  // add command data
+  for (size_t i = 0; i < params_len; i++) {
+    buffer[pos++] = params[i];
+  }
+  for (size_t i = 0; i < payload_len; i++) {
+    buffer[pos++] = (uint8_t)payload[i];
+  }
+
+  // add frame end
+  buffer[pos++] = 0xCC;
+  buffer[pos++] = 0x33;
+  buffer[pos++] = 0xC3;
+  buffer[pos++] = 0x3C;
+
+  // add parity
+  uint8_t parity = 0;
+  for (size_t i = 0; i < pos; i++) {
+    parity ^= buffer[i];
+  }
+  buffer[pos++] = parity;
+  return pos;
+}
+
+//! @brief Encode the frame of a command with fixed parameters at compile time
+//! @param command Command number
+//! @param params Fixed parameters
+//! @return The frame
+template <size_t N = 0>
+constexpr std::array<uint8_t, 9 + N> encodeEInkFrame(
+    uint8_t command, const std::array<uint8_t, N> &params = {}) {
+  std::array<uint8_t, 9 + N> frame{};
+  encodeEInkFrame(frame.data(), command, params.data(), N, nullptr, 0);
+  return frame;
+}
+
+//! @brief Encode the frame drawing a bitmap with a constant filename at
+//! compile time
+//! @param x The x coordinate of the bitmap
+//! @param y The y coordinate of the bitmap
+//! @param filename The filename of the bitmap, a string literal
+//! @return The frame
+template <size_t N>
+constexpr std::array<uint8_t, 9 + 4 + N - 1> encodeEInkBitmapFrame(
+    uint16_t x, uint16_t y, const char (&filename)[N]) {
+  const uint8_t params[] = {(uint8_t)(x >> 8), (uint8_t)(x), (uint8_t)(y >> 8),
+                            (uint8_t)(y)};
+  std::array<uint8_t, 9 + 4 + N - 1> frame{};
+  // the terminating null character is not sent
+  encodeEInkFrame(frame.data(), 0x70, params, 4, filename, N - 1);
+  return frame;
+}
+
+//! @brief Class to generate eink commands with runtime parameters
+//! @note The fixed parameters are stored in the command, the payload (a text
+//! or a filename) is only referenced and has to outlive the command. The frame
+//! is serialized straight into the buffer of the caller, so a command never
+//! allocates memory. Commands without runtime parameters use the frames of
+//! encodeEInkFrame instead.
 class EInkCommand {
  public:
   //! @brief Constructor
   //! @param command Command number
-  //! @param data Command data
-  EInkCommand(uint8_t command, std::vector<uint8_t> data = {});
+  //! @param params Fixed parameters, at most EINK_COMMAND_MAX_PARAMS bytes
+  //! @param payload Data following the parameters
+  EInkCommand(uint8_t command, std::initializer_list<uint8_t> params = {},
+              std::string_view payload = {});
 
   //! @brief Destructor
   ~EInkCommand();
 
-  //! @brief Get the command as a vector of bytes
-  //! @return Command as a vector of bytes
-  std::vector<uint8_t> getCommand() const;
+  //! @brief Get the length of the serialized frame
+  //! @return Length of the frame in bytes
+  size_t getLength() const;
+
+  //! @brief Serialize the frame into a buffer
+  //! @param buffer The buffer to write the frame to
+  //! @param size The size of the buffer
+  //! @return The length of the frame, 0 if it does not fit into the buffer
+  size_t serialize(uint8_t *buffer, size_t size) const;
 
   //! @brief Print the command to the console
+  //! @note Allocates a buffer for the frame, only meant for debugging
   void printCommand() const;
 
  private:
   //! @brief Command number
   uint8_t m_command;
 
-  //! @brief Command data
-  std::vector<uint8_t> m_data;
-};
\ No newline at end of file
+  //! @brief Fixed parameters of the command
+  uint8_t m_params[EINK_COMMAND_MAX_PARAMS];
+
+  //! @brief Number of fixed parameters
+  size_t m_params_len;
+
+  //! @brief Data following the parameters
+  std::string_view m_payload;
+};
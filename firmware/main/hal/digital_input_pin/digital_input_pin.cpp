@@ -0,0 +1,62 @@
+#include "main/hal/digital_input_pin/digital_input_pin.h"
+
+#include "esp_sleep.h"
+#include "main/logger/logger.h"
+
+DigitalInputPin::DigitalInputPin(int pin_num, bool pull_up)
+    : m_gpio_num(static_cast<gpio_num_t>(pin_num)), m_has_interrupt(false) {
+  init(pull_up);
+}
+
+DigitalInputPin::~DigitalInputPin() {
+  if (m_has_interrupt) {
+    gpio_isr_handler_remove(m_gpio_num);
+  }
+}
+
+void DigitalInputPin::init(bool pull_up) {
+  Logger::debug("Initializing digital input pin: " + std::to_string(m_gpio_num));
+  gpio_reset_pin(m_gpio_num);
+  gpio_set_direction(m_gpio_num, GPIO_MODE_INPUT);
+  gpio_set_pull_mode(m_gpio_num, pull_up ? GPIO_PULLUP_ONLY : GPIO_FLOATING);
+  Logger::debug("Finished initializing digital input pin: " +
+                std::to_string(m_gpio_num));
+}
+
+bool DigitalInputPin::isHigh() { return gpio_get_level(m_gpio_num) == 1; }
+
+bool DigitalInputPin::attachInterrupt(gpio_int_type_t type, gpio_isr_t handler,
+                                      void* arg) {
+  // the isr service is shared by all pins, it is only installed once
+  const esp_err_t err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    Logger::error("Failed to install gpio isr service: " +
+                  std::string(esp_err_to_name(err)));
+    return false;
+  }
+
+  gpio_set_intr_type(m_gpio_num, type);
+  if (gpio_isr_handler_add(m_gpio_num, handler, arg) != ESP_OK) {
+    Logger::error("Failed to attach interrupt to pin: " +
+                  std::to_string(m_gpio_num));
+    return false;
+  }
+  m_has_interrupt = true;
+  return true;
+}
+
+void DigitalInputPin::enableInterrupt() { gpio_intr_enable(m_gpio_num); }
+
+void DigitalInputPin::disableInterrupt() { gpio_intr_disable(m_gpio_num); }
+
+bool DigitalInputPin::enableWakeup(bool level) {
+  // only level triggers wake the chip from light sleep
+  if (gpio_wakeup_enable(m_gpio_num, level ? GPIO_INTR_HIGH_LEVEL
+                                           : GPIO_INTR_LOW_LEVEL) != ESP_OK ||
+      esp_sleep_enable_gpio_wakeup() != ESP_OK) {
+    Logger::error("Failed to enable wakeup on pin: " +
+                  std::to_string(m_gpio_num));
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "driver/gpio.h"
+
+//! @brief A class for reading a digital input pin.
+class DigitalInputPin {
+ public:
+  //! @brief Constructor
+  //! @param pin_num The pin number.
+  //! @param pull_up True to enable the internal pull up resistor.
+  DigitalInputPin(int pin_num, bool pull_up = false);
+
+  //! @brief Destructor
+  ~DigitalInputPin();
+
+  //! @brief Check if the pin level is high.
+  //! @return True if the pin level is high, false otherwise.
+  bool isHigh();
+
+  //! @brief Attach an interrupt handler to the pin.
+  //! @param type The interrupt trigger type.
+  //! @param handler The handler, called from the interrupt context.
+  //! @param arg The argument passed to the handler.
+  //! @return True if the handler was attached, false otherwise.
+  bool attachInterrupt(gpio_int_type_t type, gpio_isr_t handler, void* arg);
+
+  //! @brief Enable the interrupt of the pin.
+  void enableInterrupt();
+
+  //! @brief Disable the interrupt of the pin, safe to call from the interrupt
+  //! handler.
+  void disableInterrupt();
+
+  //! @brief Wake the chip from light sleep on the given level.
+  //! @param level The level that wakes the chip.
+  //! @return True if the wakeup was enabled, false otherwise.
+  bool enableWakeup(bool level);
+
+ private:
+  //! @brief Initialize the pin.
+  //! @param pull_up True to enable the internal pull up resistor.
+  void init(bool pull_up);
+
+  //! @brief The pin number.
+  const gpio_num_t m_gpio_num;
+
+  //! @brief Flag if an interrupt handler is attached.
+  bool m_has_interrupt;
+};
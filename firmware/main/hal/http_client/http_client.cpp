@@ -2,15 +2,37 @@
 
 #include <esp_crt_bundle.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <esp_tls.h>
+#include <strings.h>
 
 #include "main/config.h"
-#include "main/hal/timer/timer.h"
 #include "main/logger/logger.h"
 
-HTTPClient::HTTPClient() : request_ongoing(false), response_content("") {}
+//! @brief Event bit set when the response has been received completely
+#define REQUEST_FINISHED_BIT BIT0
 
-HTTPClient::~HTTPClient() {}
+//! @brief Maximum time in milliseconds to wait for the finish event after
+//! esp_http_client_perform returned
+#define REQUEST_FINISH_TIMEOUT_MS 1000
+
+HTTPClient::HTTPClient(bool keep_alive)
+    : m_keep_alive(keep_alive),
+      m_connected_during_request(false),
+      m_request_sent(false),
+      response_content(""),
+      m_response_content_type(""),
+      m_response_etag(""),
+      m_response_last_modified(""),
+      m_sink(nullptr),
+      m_sink_started(false),
+      m_client(nullptr),
+      m_request_start(0),
+      m_statistics({}),
+      m_mutex(xSemaphoreCreateMutex()),
+      m_request_events(xEventGroupCreate()) {}
+
+HTTPClient::~HTTPClient() { closeClient(); }
 
 esp_err_t HTTPClient::httpEventHandler(esp_http_client_event_t *event) {
   switch (event->event_id) {
@@ -18,21 +40,43 @@ esp_err_t HTTPClient::httpEventHandler(esp_http_client_event_t *event) {
       break;
 
     case HTTP_EVENT_ON_CONNECTED:
+      m_connected_during_request = true;
+      m_statistics.handshakes++;
+      m_statistics.handshake_time_ms +=
+          (esp_timer_get_time() - m_request_start) / 1000;
       break;
 
     case HTTP_EVENT_HEADER_SENT:
+      m_request_sent = true;
       break;
 
     case HTTP_EVENT_ON_HEADER:
+      if (strcasecmp(event->header_key, "Content-Type") == 0) {
+        m_response_content_type = event->header_value;
+      } else if (strcasecmp(event->header_key, "ETag") == 0) {
+        m_response_etag = event->header_value;
+      } else if (strcasecmp(event->header_key, "Last-Modified") == 0) {
+        m_response_last_modified = event->header_value;
+      }
       break;
 
     case HTTP_EVENT_ON_DATA: {
-      response_content.append((char *)event->data, event->data_len);
-      request_ongoing = false;
+      if (m_sink != nullptr) {
+        // the headers are complete once the body arrives
+        if (!m_sink_started) {
+          m_sink->begin(m_response_content_type);
+          m_sink_started = true;
+        }
+        m_sink->write((const char *)event->data, event->data_len);
+      } else {
+        response_content.append((char *)event->data, event->data_len);
+      }
+      m_statistics.bytes_received += event->data_len;
       break;
     }
 
     case HTTP_EVENT_ON_FINISH:
+      xEventGroupSetBits(m_request_events, REQUEST_FINISHED_BIT);
       break;
 
     case HTTP_EVENT_DISCONNECTED: {
@@ -53,8 +97,11 @@ esp_err_t HTTPClient::httpEventHandler(esp_http_client_event_t *event) {
   return ESP_OK;
 }
 
-HTTPResponse HTTPClient::getJSON(const std::string &url,
-                                 const std::string &token) {
+bool HTTPClient::openClient() {
+  if (m_client != nullptr) {
+    return true;
+  }
+
   esp_http_client_config_t config = {
       .url = API_BASE_URL,
       .event_handler = [](esp_http_client_event_t *event) -> esp_err_t {
@@ -65,84 +112,221 @@ HTTPResponse HTTPClient::getJSON(const std::string &url,
       .user_data = this,
       .crt_bundle_attach = esp_crt_bundle_attach};
 
+#if CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+  // keep the negotiated TLS session in the transport, so a reconnect resumes
+  // it instead of doing a full handshake with certificate validation
+  config.save_client_session = true;
+#endif
+
   m_client = esp_http_client_init(&config);
+  if (m_client == nullptr) {
+    Logger::error("Failed to initialize http client");
+    return false;
+  }
+  return true;
+}
 
-  Logger::debug("GET " + url);
-  esp_http_client_set_url(m_client, url.c_str());
-  esp_http_client_set_method(m_client, HTTP_METHOD_GET);
-  esp_http_client_set_header(m_client, "Content-Type", "application/json");
-  if (!token.empty()) {
-    esp_http_client_set_header(m_client, "Authorization",
-                               ("Bearer " + token).c_str());
+void HTTPClient::closeClient() {
+  if (m_client == nullptr) {
+    return;
+  }
+  esp_http_client_cleanup(m_client);
+  m_client = nullptr;
+}
+
+bool HTTPClient::isIdempotent(esp_http_client_method_t method) {
+  switch (method) {
+    case HTTP_METHOD_GET:
+    case HTTP_METHOD_HEAD:
+    case HTTP_METHOD_PUT:
+    case HTTP_METHOD_DELETE:
+    case HTTP_METHOD_OPTIONS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void HTTPClient::setOptionalHeader(const char *name, const std::string &value) {
+  // the handle is reused, so a header of a previous request has to be removed
+  if (!value.empty()) {
+    esp_http_client_set_header(m_client, name, value.c_str());
+  } else {
+    esp_http_client_delete_header(m_client, name);
   }
+}
+
+HTTPResponse HTTPClient::perform(const HTTPRequest &request) {
+  if (!openClient()) {
+    return {0, ""};
+  }
+  m_sink = request.sink;
+
+  esp_http_client_set_url(m_client, request.url.c_str());
+  esp_http_client_set_method(m_client, request.method);
+  esp_http_client_set_header(m_client, "Content-Type",
+                             request.content_type.c_str());
+  esp_http_client_set_post_field(
+      m_client, request.data.empty() ? NULL : request.data.c_str(),
+      request.data.length());
+
+  setOptionalHeader("Authorization",
+                    request.token.empty() ? "" : "Bearer " + request.token);
+  setOptionalHeader("Accept", request.accept);
+  setOptionalHeader("If-None-Match", request.if_none_match);
+  setOptionalHeader("If-Modified-Since", request.if_modified_since);
 
-  request_ongoing = true;
-  esp_err_t err = esp_http_client_perform(m_client);
+  m_statistics.requests++;
+  const int64_t start = esp_timer_get_time();
+
+  esp_err_t err = ESP_FAIL;
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    m_connected_during_request = false;
+    m_request_sent = false;
+    m_request_start = esp_timer_get_time();
+    response_content.clear();
+    m_response_content_type.clear();
+    m_response_etag.clear();
+    m_response_last_modified.clear();
+    m_sink_started = false;
+
+    xEventGroupClearBits(m_request_events, REQUEST_FINISHED_BIT);
+    err = esp_http_client_perform(m_client);
+    if (err == ESP_OK) {
+      break;
+    }
+
+    // a failure on a reused connection usually means that the server closed
+    // it while idle, so retry once on a fresh connection
+    esp_http_client_close(m_client);
+    if (!m_keep_alive || m_connected_during_request) {
+      break;
+    }
+
+    // the server may have processed a request that was sent before the
+    // connection failed, repeating a POST could store its data twice
+    if (m_request_sent && !isIdempotent(request.method)) {
+      Logger::warn("Connection failed after sending the request, not "
+                   "retrying it");
+      break;
+    }
+    Logger::debug("Connection closed by server, reconnecting...");
+    m_statistics.reconnects++;
+  }
 
   if (err == ESP_OK) {
     auto httpStatusCode = esp_http_client_get_status_code(m_client);
 
-    while (request_ongoing) {
-      Timer::sleepMS(100);
+    // the body is complete once the finish event was dispatched
+    if (!(xEventGroupWaitBits(m_request_events, REQUEST_FINISHED_BIT, pdTRUE,
+                              pdTRUE,
+                              REQUEST_FINISH_TIMEOUT_MS / portTICK_PERIOD_MS) &
+          REQUEST_FINISHED_BIT)) {
+      Logger::warn("HTTP response did not finish in time");
     }
+    recordLatency((esp_timer_get_time() - start) / 1000);
 
-    esp_http_client_cleanup(m_client);
+    if (!m_connected_during_request) {
+      m_statistics.reuses++;
+    }
+    m_statistics.bytes_sent += request.data.length();
+
+    if (!m_keep_alive) {
+      closeClient();
+    }
+    m_sink = nullptr;
 
     const std::string response_content_tmp = response_content;
     response_content.clear();
 
-    return {httpStatusCode, response_content_tmp};
+    return {httpStatusCode, response_content_tmp, m_response_content_type,
+            m_response_etag, m_response_last_modified};
   }
-  esp_http_client_cleanup(m_client);
+  // keep the handle in keep alive mode, it holds the TLS session to resume
+  if (!m_keep_alive) {
+    closeClient();
+  }
+  m_sink = nullptr;
   response_content.clear();
   Logger::error("HTTP request failed: " + std::string(esp_err_to_name(err)));
   return {0, ""};
 }
 
+HTTPResponse HTTPClient::getJSON(const std::string &url,
+                                 const std::string &token) {
+  Logger::debug("GET " + url);
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  HTTPResponse response = perform({.method = HTTP_METHOD_GET,
+                                   .url = url,
+                                   .token = token,
+                                   .content_type = "application/json",
+                                   .sink = nullptr});
+  xSemaphoreGive(m_mutex);
+  return response;
+}
+
 HTTPResponse HTTPClient::postJSON(const std::string &url,
                                   const std::string &data,
                                   const std::string &token) {
-  esp_http_client_config_t config = {
-      .url = API_BASE_URL,
-      .event_handler = [](esp_http_client_event_t *event) -> esp_err_t {
-        return static_cast<HTTPClient *>(event->user_data)
-            ->httpEventHandler(event);
-      },
-      .buffer_size = 1024,
-      .user_data = this,
-      .crt_bundle_attach = esp_crt_bundle_attach};
+  Logger::debug("POST " + url + " " + data);
 
-  m_client = esp_http_client_init(&config);
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  HTTPResponse response = perform({.method = HTTP_METHOD_POST,
+                                   .url = url,
+                                   .data = data,
+                                   .token = token,
+                                   .content_type = "application/json",
+                                   .sink = nullptr});
+  xSemaphoreGive(m_mutex);
+  return response;
+}
 
-  Logger::debug("POST " + url + " " + data);
-  esp_http_client_set_url(m_client, url.c_str());
-  esp_http_client_set_method(m_client, HTTP_METHOD_POST);
-  esp_http_client_set_header(m_client, "Content-Type", "application/json");
-  esp_http_client_set_post_field(m_client, data.c_str(), data.length());
-
-  if (!token.empty()) {
-    esp_http_client_set_header(m_client, "Authorization",
-                               ("Bearer " + token).c_str());
-  }
+HTTPResponse HTTPClient::request(const HTTPRequest &request) {
+  Logger::debug("Request " + request.url + " " + request.content_type);
 
-  request_ongoing = true;
-  esp_err_t err = esp_http_client_perform(m_client);
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  HTTPResponse response = perform(request);
+  xSemaphoreGive(m_mutex);
+  return response;
+}
 
-  if (err == ESP_OK) {
-    auto httpStatusCode = esp_http_client_get_status_code(m_client);
+void HTTPClient::recordLatency(uint32_t latency_ms) {
+  uint8_t bucket = 0;
+  while (bucket < HTTP_LATENCY_BUCKETS - 1 &&
+         latency_ms >= HTTP_LATENCY_BUCKET_LIMITS_MS[bucket]) {
+    bucket++;
+  }
+  m_statistics.latency_histogram[bucket]++;
+}
 
-    while (request_ongoing) {
-      Timer::sleepMS(100);
-    }
-    esp_http_client_cleanup(m_client);
+HTTPClientStatistics HTTPClient::getStatistics() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  HTTPClientStatistics statistics = m_statistics;
+  xSemaphoreGive(m_mutex);
+  return statistics;
+}
 
-    const std::string response_content_tmp = response_content;
-    response_content.clear();
+void HTTPClient::logStatistics() {
+  HTTPClientStatistics statistics = getStatistics();
+  Logger::info("HTTP requests: " + std::to_string(statistics.requests) +
+               " handshakes: " + std::to_string(statistics.handshakes) +
+               " reuses: " + std::to_string(statistics.reuses) +
+               " reconnects: " + std::to_string(statistics.reconnects) +
+               " sent: " + std::to_string(statistics.bytes_sent) +
+               " received: " + std::to_string(statistics.bytes_received));
 
-    return {httpStatusCode, response_content_tmp};
+  std::string histogram = "HTTP latency:";
+  for (uint8_t bucket = 0; bucket < HTTP_LATENCY_BUCKETS; bucket++) {
+    if (bucket < HTTP_LATENCY_BUCKETS - 1) {
+      histogram +=
+          " <" + std::to_string(HTTP_LATENCY_BUCKET_LIMITS_MS[bucket]) + "ms:";
+    } else {
+      histogram += " >=" +
+                   std::to_string(HTTP_LATENCY_BUCKET_LIMITS_MS[bucket - 1]) +
+                   "ms:";
+    }
+    histogram += std::to_string(statistics.latency_histogram[bucket]);
   }
-  esp_http_client_cleanup(m_client);
-  response_content.clear();
-  Logger::error("HTTP request failed: " + std::string(esp_err_to_name(err)));
-  return {0, ""};
+  Logger::info(histogram);
 }
\ No newline at end of file
@@ -5,6 +5,19 @@
 
 #include <string>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+//! @brief Number of buckets of the request latency histogram
+#define HTTP_LATENCY_BUCKETS 8
+
+//! @brief Upper bounds in milliseconds of the request latency histogram
+//! buckets, the last bucket collects everything above the last bound
+static constexpr uint32_t HTTP_LATENCY_BUCKET_LIMITS_MS[HTTP_LATENCY_BUCKETS -
+                                                        1] = {
+    50, 100, 200, 500, 1000, 2000, 5000};
+
 //! @brief HTTP response struct
 struct HTTPResponse {
   //! http status code
@@ -12,13 +25,112 @@ struct HTTPResponse {
 
   //! http response content
   std::string response_content;
+
+  //! content type of the response, empty if the server sent none
+  std::string content_type;
+
+  //! entity tag of the response, empty if the server sent none
+  std::string etag;
+
+  //! last modification date of the response, empty if the server sent none
+  std::string last_modified;
+};
+
+//! @brief Receiver of a response body that is consumed while it arrives
+//! @note A request with a sink does not collect the body in the response.
+class ResponseSink {
+ public:
+  //! @brief Destructor
+  virtual ~ResponseSink() = default;
+
+  //! @brief Called before the first chunk of a response body.
+  //! @note Called again if the request is retried on a new connection.
+  //! @param content_type The content type of the response.
+  virtual void begin(const std::string& content_type) = 0;
+
+  //! @brief Called for every chunk of the response body.
+  //! @param data The chunk.
+  //! @param length The length of the chunk.
+  virtual void write(const char* data, size_t length) = 0;
+};
+
+//! @brief HTTP request struct
+struct HTTPRequest {
+  //! http method
+  esp_http_client_method_t method;
+
+  //! URL to send the request to
+  std::string url;
+
+  //! request body, empty if there is no body
+  std::string data;
+
+  //! authentication token, empty if no token is needed
+  std::string token;
+
+  //! content type of the request body
+  std::string content_type;
+
+  //! accepted response content types, empty to omit the Accept header
+  std::string accept;
+
+  //! entity tag for If-None-Match, empty to omit the header
+  std::string if_none_match;
+
+  //! date for If-Modified-Since, empty to omit the header
+  std::string if_modified_since;
+
+  //! receiver of the response body, nullptr to collect the body in the
+  //! response
+  ResponseSink* sink;
+};
+
+//! @brief HTTP client connection statistics
+struct HTTPClientStatistics {
+  //! number of performed requests
+  uint32_t requests;
+
+  //! number of established connections (TCP + TLS handshakes)
+  uint32_t handshakes;
+
+  //! number of requests sent over an already open connection
+  uint32_t reuses;
+
+  //! number of requests retried after the server closed the connection
+  uint32_t reconnects;
+
+  //! accumulated time in milliseconds spent to establish connections
+  //! @note divided by handshakes this shows if TLS sessions are resumed
+  uint32_t handshake_time_ms;
+
+  //! number of request body bytes sent
+  uint64_t bytes_sent;
+
+  //! number of response body bytes received
+  uint64_t bytes_received;
+
+  //! histogram of the request latencies
+  //! @see HTTP_LATENCY_BUCKET_LIMITS_MS
+  uint32_t latency_histogram[HTTP_LATENCY_BUCKETS];
 };
 
 //! @brief HTTP client class
+//! @note In keep alive mode the client handle and the TLS session are kept
+//! open across requests to the same host, the HTTP/1.1 connection stays open
+//! unless the server answers with "Connection: close". If the server closed
+//! the connection in the meantime the request is retried once on a new
+//! connection. Requests with a non idempotent method like POST are only
+//! retried if they failed before their headers were sent, otherwise the
+//! server may have processed them and the failure is returned to the caller.
+//! With CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS the new connection resumes the
+//! previous TLS session. test/https_stand_in.py is a local
+//! stand-in server that logs the reused connections and resumed sessions.
 class HTTPClient {
  public:
   //! @brief Constructor
-  HTTPClient();
+  //! @param keep_alive True to reuse the connection across requests, false to
+  //! open a new connection for every request.
+  HTTPClient(bool keep_alive = true);
 
   //! @brief Destructor
   ~HTTPClient();
@@ -37,19 +149,92 @@ class HTTPClient {
   HTTPResponse postJSON(const std::string& url, const std::string& data,
                         const std::string& token = "");
 
+  //! @brief Send a request.
+  //! @param request The request.
+  //! @return The http response, status code 0 if the request failed.
+  HTTPResponse request(const HTTPRequest& request);
+
+  //! @brief Get the connection statistics.
+  //! @return A copy of the current statistics.
+  HTTPClientStatistics getStatistics();
+
+  //! @brief Log the connection statistics and the latency histogram.
+  void logStatistics();
+
  private:
+  //! @brief Perform a request, reusing the open connection if possible.
+  //! @param request The request.
+  //! @return The http response, status code 0 if the request failed.
+  HTTPResponse perform(const HTTPRequest& request);
+
+  //! @brief Set a header of the reused handle or remove it.
+  //! @param name The header name.
+  //! @param value The header value, empty string to remove the header.
+  void setOptionalHeader(const char* name, const std::string& value);
+
+  //! @brief Check if a request can be repeated without changing its effect.
+  //! @param method The http method of the request.
+  //! @return True if the method is idempotent, false otherwise.
+  static bool isIdempotent(esp_http_client_method_t method);
+
+  //! @brief Create the http client handle if there is none.
+  //! @return True if the handle is available, false otherwise.
+  bool openClient();
+
+  //! @brief Close the connection and release the http client handle.
+  void closeClient();
+
+  //! @brief Add a request latency to the histogram.
+  //! @param latency_ms The latency in milliseconds.
+  void recordLatency(uint32_t latency_ms);
+
   //! @brief The http event handler.
   //! @param event The http event.
   //! @return ESP_OK if the event was handled successfully, an error otherwise.
   esp_err_t httpEventHandler(esp_http_client_event_t* event);
 
-  //! @brief Flag to indicate if a request is ongoing. (True if a request is
-  //! ongoin, false otherwise).
-  bool request_ongoing;
+  //! @brief Flag to indicate if the connection is kept open across requests.
+  const bool m_keep_alive;
+
+  //! @brief Flag to indicate if a new connection was established during the
+  //! current request.
+  bool m_connected_during_request;
+
+  //! @brief Flag to indicate if the headers of the current request attempt
+  //! were sent.
+  bool m_request_sent;
 
   //! @brief The response content.
   std::string response_content;
 
-  //! @brief The http client handle.
+  //! @brief The content type of the response.
+  std::string m_response_content_type;
+
+  //! @brief The entity tag of the response.
+  std::string m_response_etag;
+
+  //! @brief The last modification date of the response.
+  std::string m_response_last_modified;
+
+  //! @brief The receiver of the current response body, nullptr if the body is
+  //! collected in response_content.
+  ResponseSink* m_sink;
+
+  //! @brief Flag if the sink was started for the current attempt.
+  bool m_sink_started;
+
+  //! @brief The http client handle, nullptr if no handle is open.
   esp_http_client_handle_t m_client;
+
+  //! @brief Start time of the current request attempt in microseconds.
+  int64_t m_request_start;
+
+  //! @brief The connection statistics.
+  HTTPClientStatistics m_statistics;
+
+  //! @brief Mutex to serialize requests on the shared handle.
+  SemaphoreHandle_t m_mutex;
+
+  //! @brief Event group signalling the end of the current request.
+  EventGroupHandle_t m_request_events;
 };
@@ -1,9 +1,11 @@
 #include "main/hal/i2c/i2c.h"
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 
-#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "main/config.h"
 #include "main/logger/logger.h"
 
 I2C::I2C(int sda_pin, int scl_pin, int master_timeout_ms)
@@ -12,70 +14,277 @@ I2C::I2C(int sda_pin, int scl_pin, int master_timeout_ms)
               .scl_io_num = scl_pin,
               .sda_pullup_en = GPIO_PULLUP_ENABLE,
               .scl_pullup_en = GPIO_PULLUP_ENABLE,
-              .master = {.clk_speed = 100000},
+              .master = {.clk_speed = I2C_DEFAULT_CLOCK_SPEED},
               .clk_flags = I2C_SCLK_SRC_FLAG_FOR_NOMAL}),
       m_sda_pin(sda_pin),
       m_scl_pin(scl_pin),
-      m_master_timeout_ms(master_timeout_ms) {
+      m_master_timeout_ms(master_timeout_ms),
+      m_clock_speed(I2C_DEFAULT_CLOCK_SPEED),
+      m_bus_task_handle(NULL),
+      m_mutex(xSemaphoreCreateMutex()) {
   init();
 }
 
-I2C::~I2C() {}
+I2C::~I2C() {
+  if (m_bus_task_handle != NULL) {
+    vTaskDelete(m_bus_task_handle);
+  }
+  i2c_driver_delete(I2C_NUM_0);
+}
 
 void I2C::init() {
   Logger::info("Initializing I2C.");
   i2c_param_config(I2C_NUM_0, &m_conf);
   i2c_driver_install(I2C_NUM_0, m_conf.mode, 0, 0, 0);
+
+  // the bus task runs above the driver tasks, so a completed transaction is
+  // followed by the next one without delay
+  xTaskCreate(
+      [](void *i2c_ptr) {
+        I2C *i2c = (I2C *)i2c_ptr;
+        while (true) {
+          // wait until a transaction was queued
+          ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+          i2c->processTransactions();
+        }
+      },
+      "i2c_task", 3072, this, 10, &m_bus_task_handle);
   Logger::info("Finished initializing I2C.");
 }
 
-void I2C::read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data,
-               size_t len) {
-  i2c_master_write_read_device(I2C_NUM_0, device_addr, &reg_addr, 1, data, len,
-                               m_master_timeout_ms / portTICK_PERIOD_MS);
+bool I2C::addDevice(uint8_t device_addr, const I2CDeviceConfig &config) {
+  if (config.clock_speed == 0 || config.clock_speed > 400000) {
+    Logger::error("Unsupported I2C clock speed: " +
+                  std::to_string(config.clock_speed));
+    return false;
+  }
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  m_devices[device_addr] = config;
+  xSemaphoreGive(m_mutex);
+  return true;
+}
+
+std::vector<uint8_t> I2C::scan() {
+  std::vector<uint8_t> devices;
+  // the reserved addresses at both ends of the 7 bit range are skipped
+  for (uint8_t device_addr = 0x08; device_addr < 0x78; device_addr++) {
+    if (submit(device_addr, false, 0, nullptr, 0, nullptr, 0) == ESP_OK) {
+      char address[5];
+      snprintf(address, sizeof(address), "0x%02X", device_addr);
+      Logger::info("Found I2C device at " + std::string(address));
+      devices.push_back(device_addr);
+    }
+  }
+  return devices;
+}
+
+esp_err_t I2C::transfer(uint8_t device_addr, const uint8_t *write_data,
+                        size_t write_len, uint8_t *read_data,
+                        size_t read_len) {
+  return submit(device_addr, false, 0, write_data, write_len, read_data,
+                read_len);
 }
 
-void I2C::read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data) {
-  read(device_addr, reg_addr, data, 1);
+esp_err_t I2C::read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data,
+                    size_t len) {
+  return submit(device_addr, true, reg_addr, nullptr, 0, data, len);
 }
 
-void I2C::readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
-                           uint16_t *data) {
+esp_err_t I2C::read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data) {
+  return read(device_addr, reg_addr, data, 1);
+}
+
+esp_err_t I2C::readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
+                                uint16_t *data) {
   uint8_t buf[2];
-  read(device_addr, reg_addr, buf, 2);
+  const esp_err_t err = read(device_addr, reg_addr, buf, 2);
+  if (err != ESP_OK) {
+    return err;
+  }
   *data = buf[0] | (buf[1] << 8);
+  return ESP_OK;
 }
 
-void I2C::readBigEndian(uint8_t device_addr, uint8_t reg_addr, uint16_t *data) {
+esp_err_t I2C::readBigEndian(uint8_t device_addr, uint8_t reg_addr,
+                             uint16_t *data) {
   uint8_t buf[2];
-  read(device_addr, reg_addr, buf, 2);
+  const esp_err_t err = read(device_addr, reg_addr, buf, 2);
+  if (err != ESP_OK) {
+    return err;
+  }
   *data = buf[1] | (buf[0] << 8);
+  return ESP_OK;
 }
 
-void I2C::readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
-                           uint32_t *data) {
+esp_err_t I2C::readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
+                                uint32_t *data) {
   uint8_t buf[4];
-  read(device_addr, reg_addr, buf, 4);
-  *data = buf[0] | (buf[1] << 8) | (buf[2] << 16) | (buf[3] << 24);
+  const esp_err_t err = read(device_addr, reg_addr, buf, 4);
+  if (err != ESP_OK) {
+    return err;
+  }
+  *data = buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+  return ESP_OK;
 }
 
-void I2C::readBigEndian(uint8_t device_addr, uint8_t reg_addr, uint32_t *data) {
+esp_err_t I2C::readBigEndian(uint8_t device_addr, uint8_t reg_addr,
+                             uint32_t *data) {
   uint8_t buf[4];
-  read(device_addr, reg_addr, buf, 4);
-  *data = buf[3] | (buf[2] << 8) | (buf[1] << 16) | (buf[0] << 24);
+  const esp_err_t err = read(device_addr, reg_addr, buf, 4);
+  if (err != ESP_OK) {
+    return err;
+  }
+  *data = buf[3] | (buf[2] << 8) | (buf[1] << 16) | ((uint32_t)buf[0] << 24);
+  return ESP_OK;
+}
+
+esp_err_t I2C::write(uint8_t device_addr, uint8_t reg_addr,
+                     const uint8_t *data, size_t len) {
+  return submit(device_addr, true, reg_addr, data, len, nullptr, 0);
+}
+
+esp_err_t I2C::write(uint8_t device_addr, uint8_t reg_addr, uint8_t data) {
+  return write(device_addr, reg_addr, &data, 1);
 }
 
-void I2C::write(uint8_t device_addr, uint8_t reg_addr, const uint8_t *data,
-                size_t len) {
-  uint8_t write_buf[len + 1];
-  write_buf[0] = reg_addr;
-  memcpy(write_buf + 1, data, len);
+void I2C::logStatistics() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const std::map<uint8_t, I2CDeviceStatistics> statistics = m_statistics;
+  xSemaphoreGive(m_mutex);
 
-  i2c_master_write_to_device(I2C_NUM_0, device_addr, write_buf,
-                             sizeof(write_buf),
-                             m_master_timeout_ms / portTICK_PERIOD_MS);
+  for (const auto &[device_addr, device] : statistics) {
+    const int64_t latency_avg =
+        device.transactions > 0 ? device.latency_sum / device.transactions : 0;
+    Logger::info("I2C device " + std::to_string(device_addr) +
+                 " transactions: " + std::to_string(device.transactions) +
+                 " errors: " + std::to_string(device.errors) +
+                 " latency avg: " + std::to_string(latency_avg) +
+                 " us max: " + std::to_string(device.latency_max) + " us");
+  }
 }
 
-void I2C::write(uint8_t device_addr, uint8_t reg_addr, uint8_t data) {
-  write(device_addr, reg_addr, &data, 1);
+esp_err_t I2C::submit(uint8_t device_addr, bool has_reg, uint8_t reg_addr,
+                      const uint8_t *write_data, size_t write_len,
+                      uint8_t *read_data, size_t read_len) {
+  StaticSemaphore_t done_buffer;
+  I2CTransaction transaction = {
+      .device_addr = device_addr,
+      .has_reg = has_reg,
+      .reg_addr = reg_addr,
+      .write_data = write_data,
+      .write_len = write_data != nullptr ? write_len : 0,
+      .read_data = read_data,
+      .read_len = read_data != nullptr ? read_len : 0,
+      .clock_speed = I2C_DEFAULT_CLOCK_SPEED,
+      .timeout = pdMS_TO_TICKS(m_master_timeout_ms),
+      .queued_time = esp_timer_get_time(),
+      .result = ESP_FAIL,
+      .done = xSemaphoreCreateBinaryStatic(&done_buffer)};
+  I2CPriority priority = I2C_PRIORITY_NORMAL;
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const auto device = m_devices.find(device_addr);
+  if (device != m_devices.end()) {
+    transaction.clock_speed = device->second.clock_speed;
+    transaction.timeout = pdMS_TO_TICKS(device->second.timeout_ms);
+    priority = device->second.priority;
+  }
+
+  auto &queue = m_queues[priority];
+  if (queue.size() >= I2C_QUEUE_MAX_LENGTH) {
+    xSemaphoreGive(m_mutex);
+    vSemaphoreDelete(transaction.done);
+    Logger::error("I2C transaction queue is full, dropping transaction to " +
+                  std::to_string(device_addr));
+    return ESP_FAIL;
+  }
+  queue.push_back(&transaction);
+  xSemaphoreGive(m_mutex);
+
+  // wake up the bus task and wait for the result
+  xTaskNotifyGive(m_bus_task_handle);
+  xSemaphoreTake(transaction.done, portMAX_DELAY);
+  vSemaphoreDelete(transaction.done);
+  return transaction.result;
+}
+
+I2CTransaction *I2C::takeNextTransaction() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  for (auto &queue : m_queues) {
+    if (!queue.empty()) {
+      I2CTransaction *transaction = queue.front();
+      queue.pop_front();
+      xSemaphoreGive(m_mutex);
+      return transaction;
+    }
+  }
+  xSemaphoreGive(m_mutex);
+  return nullptr;
+}
+
+void I2C::processTransactions() {
+  I2CTransaction *transaction;
+  while ((transaction = takeNextTransaction()) != nullptr) {
+    transaction->result = execute(*transaction);
+    const int64_t latency = esp_timer_get_time() - transaction->queued_time;
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    I2CDeviceStatistics &statistics = m_statistics[transaction->device_addr];
+    statistics.transactions++;
+    if (transaction->result != ESP_OK) {
+      statistics.errors++;
+    }
+    statistics.latency_sum += latency;
+    statistics.latency_max = std::max(statistics.latency_max, latency);
+    xSemaphoreGive(m_mutex);
+
+    // the transaction belongs to the waiting task, it must not be accessed
+    // after it was completed
+    xSemaphoreGive(transaction->done);
+  }
+}
+
+esp_err_t I2C::execute(const I2CTransaction &transaction) {
+  // the port is only reconfigured when the next device needs another clock
+  if (transaction.clock_speed != m_clock_speed) {
+    m_conf.master.clk_speed = transaction.clock_speed;
+    const esp_err_t err = i2c_param_config(I2C_NUM_0, &m_conf);
+    if (err != ESP_OK) {
+      return err;
+    }
+    m_clock_speed = transaction.clock_speed;
+  }
+
+  // the buffer holds all commands of the longest transaction, a register
+  // write followed by a read with a repeated start
+  i2c_cmd_handle_t cmd =
+      i2c_cmd_link_create_static(m_cmd_buffer, sizeof(m_cmd_buffer));
+  i2c_master_start(cmd);
+  const uint8_t address = transaction.device_addr << 1;
+  const bool has_write = transaction.has_reg || transaction.write_len > 0;
+  if (has_write || transaction.read_len == 0) {
+    i2c_master_write_byte(cmd, address | I2C_MASTER_WRITE, true);
+    if (transaction.has_reg) {
+      i2c_master_write_byte(cmd, transaction.reg_addr, true);
+    }
+    if (transaction.write_len > 0) {
+      i2c_master_write(cmd, transaction.write_data, transaction.write_len,
+                       true);
+    }
+  }
+  if (transaction.read_len > 0) {
+    if (has_write) {
+      i2c_master_start(cmd);
+    }
+    i2c_master_write_byte(cmd, address | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, transaction.read_data, transaction.read_len,
+                    I2C_MASTER_LAST_NACK);
+  }
+  i2c_master_stop(cmd);
+
+  const esp_err_t err =
+      i2c_master_cmd_begin(I2C_NUM_0, cmd, transaction.timeout);
+  i2c_cmd_link_delete_static(cmd);
+  return err;
 }
@@ -1,74 +1,217 @@
 #pragma once
 
+#include <deque>
+#include <map>
+#include <vector>
+
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+//! @brief Priority of an I2C transaction, lower values are sent first
+enum I2CPriority { I2C_PRIORITY_HIGH = 0, I2C_PRIORITY_NORMAL = 1 };
+
+//! @brief Number of I2C transaction priorities
+#define I2C_PRIORITIES 2
+
+//! @brief Maximum number of queued transactions per priority
+#define I2C_QUEUE_MAX_LENGTH 8
+
+//! @brief Configuration of a device on the bus
+struct I2CDeviceConfig {
+  //! @brief The clock speed in Hz, at most 400 kHz (fast mode)
+  uint32_t clock_speed;
+  //! @brief The timeout of a transaction in ms
+  int timeout_ms;
+  //! @brief The priority of the transactions
+  I2CPriority priority;
+};
+
+//! @brief A queued I2C transaction
+//! @note The transaction lives on the stack of the calling task, which waits
+//! until the bus task completed it.
+struct I2CTransaction {
+  //! @brief The address of the device
+  uint8_t device_addr;
+  //! @brief Flag if the register address is written first
+  bool has_reg;
+  //! @brief The address of the first register of the burst
+  uint8_t reg_addr;
+  //! @brief The data to write, nullptr for a read only transaction
+  const uint8_t *write_data;
+  //! @brief The length of the data to write
+  size_t write_len;
+  //! @brief The buffer to read into, nullptr for a write only transaction
+  uint8_t *read_data;
+  //! @brief The length of the data to read
+  size_t read_len;
+  //! @brief The clock speed of the device in Hz
+  uint32_t clock_speed;
+  //! @brief The timeout of the transaction in ticks
+  TickType_t timeout;
+  //! @brief Time in microseconds when the transaction was queued
+  int64_t queued_time;
+  //! @brief The result of the transaction
+  esp_err_t result;
+  //! @brief Semaphore given by the bus task once the transaction completed
+  SemaphoreHandle_t done;
+};
+
+//! @brief Statistics of the transactions of one device
+struct I2CDeviceStatistics {
+  //! @brief Number of completed transactions
+  uint32_t transactions;
+  //! @brief Number of failed transactions
+  uint32_t errors;
+  //! @brief Sum of the latencies from queueing to completion in microseconds
+  int64_t latency_sum;
+  //! @brief Maximum latency from queueing to completion in microseconds
+  int64_t latency_max;
+};
 
+//! @brief Manager of the I2C bus
+//! @note The bus is owned by a single bus task, the drivers of all tasks
+//! queue their transactions and wait for the result. Transactions never
+//! interleave and are sent in order of the priority of their device. Every
+//! device has its own clock speed and timeout, unknown devices use the
+//! standard mode clock. Register bursts are sent as one command link from the
+//! caller's buffer, the data is not copied.
 class I2C {
  public:
   //! @brief Constructor
   //! @param sda_pin The pin to use for SDA.
   //! @param scl_pin The pin to use for SCL.
-  //! @param master_timeout_ms The timeout for the master.
+  //! @param master_timeout_ms The timeout for the master, used for devices
+  //! without a configuration.
   I2C(int sda_pin, int scl_pin, int master_timeout_ms);
 
   //! @brief Destructor
   ~I2C();
 
-  //! @brief Initialize the I2C.
+  //! @brief Initialize the I2C and start the bus task.
   void init();
 
+  //! @brief Configure a device on the bus.
+  //! @param device_addr The address of the device.
+  //! @param config The configuration of the device.
+  //! @return True if the configuration is valid, false otherwise.
+  bool addDevice(uint8_t device_addr, const I2CDeviceConfig &config);
+
+  //! @brief Scan the bus for devices.
+  //! @return The addresses of the devices that acknowledged their address.
+  std::vector<uint8_t> scan();
+
+  //! @brief Write data and read the response in one transaction with a
+  //! repeated start.
+  //! @param device_addr The address of the device.
+  //! @param write_data The data to write, nullptr to only read.
+  //! @param write_len The length of the data to write.
+  //! @param read_data The buffer to read into, nullptr to only write.
+  //! @param read_len The length of the data to read.
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t transfer(uint8_t device_addr, const uint8_t *write_data,
+                     size_t write_len, uint8_t *read_data, size_t read_len);
+
   //! @brief Write data to the I2C.
   //! @param device_addr The address of the device to write to.
-  //! @param reg_addr The address of the register to write to.
-  //! @param data The data to write.
+  //! @param reg_addr The address of the first register to write to.
+  //! @param data The data to write, sent without a copy.
   //! @param len The length of the data to write.
-  void write(uint8_t device_addr, uint8_t reg_addr, const uint8_t *data,
-             size_t len);
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t write(uint8_t device_addr, uint8_t reg_addr, const uint8_t *data,
+                  size_t len);
 
   //! @brief Write one byte to the I2C.
   //! @param device_addr The address of the device to write to.
   //! @param reg_addr The address of the register to write to.
   //! @param data The byte to write.
-  void write(uint8_t device_addr, uint8_t reg_addr, uint8_t data);
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t write(uint8_t device_addr, uint8_t reg_addr, uint8_t data);
 
   //! @brief Read data from the I2C.
   //! @param device_addr The address of the device to read from.
-  //! @param reg_addr The address of the register to read from.
+  //! @param reg_addr The address of the first register to read from.
   //! @param data The pointer to store the data in.
   //! @param len The length of the data to read.
-  void read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data, size_t len);
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data,
+                 size_t len);
 
   //! @brief Read one byte from the I2C.
   //! @param device_addr The address of the device to read from.
   //! @param reg_addr The address of the register to read from.
   //! @param data The pointer to store the data in.
-  void read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data);
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t read(uint8_t device_addr, uint8_t reg_addr, uint8_t *data);
 
   //! @brief Read two bytes from the I2C in little endian.
   //! @param device_addr The address of the device to read from.
   //! @param reg_addr The address of the register to read from.
-  //! @param data The pointer to store the data in.
-  void readLittleEndian(uint8_t device_addr, uint8_t reg_addr, uint16_t *data);
+  //! @param data The pointer to store the data in, only written if the read
+  //! succeeds.
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
+                             uint16_t *data);
 
   //! @brief Read two bytes from the I2C in big endian.
   //! @param device_addr The address of the device to read from.
   //! @param reg_addr The address of the register to read from.
-  //! @param data The pointer to store the data in.
-  void readBigEndian(uint8_t device_addr, uint8_t reg_addr, uint16_t *data);
+  //! @param data The pointer to store the data in, only written if the read
+  //! succeeds.
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t readBigEndian(uint8_t device_addr, uint8_t reg_addr,
+                          uint16_t *data);
 
   //! @brief Read four bytes from the I2C in little endian.
   //! @param device_addr The address of the device to read from.
   //! @param reg_addr The address of the register to read from.
-  //! @param data The pointer to store the data in.
-  void readLittleEndian(uint8_t device_addr, uint8_t reg_addr, uint32_t *data);
+  //! @param data The pointer to store the data in, only written if the read
+  //! succeeds.
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t readLittleEndian(uint8_t device_addr, uint8_t reg_addr,
+                             uint32_t *data);
 
   //! @brief Read four bytes from the I2C in big endian.
   //! @param device_addr The address of the device to read from.
   //! @param reg_addr The address of the register to read from.
-  void readBigEndian(uint8_t device_addr, uint8_t reg_addr, uint32_t *data);
+  //! @param data The pointer to store the data in, only written if the read
+  //! succeeds.
+  //! @return ESP_OK if successful, the error of the transaction otherwise.
+  esp_err_t readBigEndian(uint8_t device_addr, uint8_t reg_addr,
+                          uint32_t *data);
+
+  //! @brief Log the transaction statistics of all devices.
+  void logStatistics();
 
  private:
+  //! @brief Queue a transaction and wait until the bus task completed it.
+  //! @param device_addr The address of the device.
+  //! @param has_reg Flag if the register address is written first.
+  //! @param reg_addr The address of the first register.
+  //! @param write_data The data to write, nullptr to only read.
+  //! @param write_len The length of the data to write.
+  //! @param read_data The buffer to read into, nullptr to only write.
+  //! @param read_len The length of the data to read.
+  //! @return The result of the transaction.
+  esp_err_t submit(uint8_t device_addr, bool has_reg, uint8_t reg_addr,
+                   const uint8_t *write_data, size_t write_len,
+                   uint8_t *read_data, size_t read_len);
+
+  //! @brief Take the next transaction with the highest priority.
+  //! @return The transaction, nullptr if all queues are empty.
+  I2CTransaction *takeNextTransaction();
+
+  //! @brief Send all queued transactions, called by the bus task.
+  void processTransactions();
+
+  //! @brief Send a transaction on the bus.
+  //! @param transaction The transaction.
+  //! @return The result of the transaction.
+  esp_err_t execute(const I2CTransaction &transaction);
+
   //! @brief The I2C configuration.
-  const i2c_config_t m_conf;
+  i2c_config_t m_conf;
 
   //! @brief The pin to use for SDA.
   const int m_sda_pin;
@@ -78,4 +221,25 @@ class I2C {
 
   //! @brief The timeout in ms for the i2c master.
   int m_master_timeout_ms;
+
+  //! @brief The queued transactions, one queue per priority
+  std::deque<I2CTransaction *> m_queues[I2C_PRIORITIES];
+
+  //! @brief The configurations of the devices
+  std::map<uint8_t, I2CDeviceConfig> m_devices;
+
+  //! @brief The current clock speed of the bus in Hz
+  uint32_t m_clock_speed;
+
+  //! @brief Buffer of the command link, only used by the bus task
+  uint8_t m_cmd_buffer[I2C_LINK_RECOMMENDED_SIZE(3)];
+
+  //! @brief The transaction statistics of the devices
+  std::map<uint8_t, I2CDeviceStatistics> m_statistics;
+
+  //! @brief The bus task handle
+  TaskHandle_t m_bus_task_handle;
+
+  //! @brief Mutex to protect the queues, configurations and statistics
+  SemaphoreHandle_t m_mutex;
 };
@@ -432,3 +432,44 @@ bool NonVolatileStorage::setValue(const std::string& namespace_name,
   closeStorage(handle);
   return persist_status;
 }
+
+bool NonVolatileStorage::getBlob(const std::string& namespace_name,
+                                 const std::string& key, void* data,
+                                 size_t* length) {
+  if (isNullPointer(data) || isNullPointer(length)) {
+    return false;
+  }
+
+  nvs_handle_t handle;
+  if (!openStorage(namespace_name, &handle)) {
+    return false;
+  }
+
+  esp_err_t err = nvs_get_blob(handle, key.c_str(), data, length);
+
+  closeStorage(handle);
+
+  if (err == ESP_ERR_NVS_NOT_FOUND) {
+    *length = 0;
+  }
+  return evaluateReadError(err, namespace_name, key);
+}
+
+bool NonVolatileStorage::setBlob(const std::string& namespace_name,
+                                 const std::string& key, const void* data,
+                                 size_t length) {
+  nvs_handle_t handle;
+  if (!openStorage(namespace_name, &handle)) {
+    return false;
+  }
+
+  esp_err_t err = nvs_set_blob(handle, key.c_str(), data, length);
+  if (!evaluateWriteError(err, namespace_name, key)) {
+    closeStorage(handle);
+    return false;
+  }
+
+  bool persist_status = persistValue(handle, namespace_name, key);
+  closeStorage(handle);
+  return persist_status;
+}
@@ -97,6 +97,16 @@ class NonVolatileStorage {
   bool getValue(const std::string& namespace_name, const std::string& key,
                 std::string* value);
 
+  //! @brief Get a binary blob from the non-volatile storage.
+  //! @param namespace_name The namespace name.
+  //! @param key The key.
+  //! @param data The buffer to store the blob in.
+  //! @param length The size of the buffer, set to the size of the blob or 0
+  //! if the key is not set yet.
+  //! @return True if successful, false otherwise.
+  bool getBlob(const std::string& namespace_name, const std::string& key,
+               void* data, size_t* length);
+
   //! @brief Set an int8 value in the non-volatile storage.
   //! @param namespace_name The namespace name.
   //! @param key The key.
@@ -169,6 +179,15 @@ class NonVolatileStorage {
   bool setValue(const std::string& namespace_name, const std::string& key,
                 const std::string& value);
 
+  //! @brief Set a binary blob in the non-volatile storage.
+  //! @param namespace_name The namespace name.
+  //! @param key The key.
+  //! @param data The blob to set.
+  //! @param length The size of the blob.
+  //! @return True if successful, false otherwise.
+  bool setBlob(const std::string& namespace_name, const std::string& key,
+               const void* data, size_t length);
+
  private:
   //! @brief Open the persisted storage
   //! @param namespace_name The namespace name.
@@ -0,0 +1,319 @@
+#include "main/hal/sample_storage/sample_storage.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "main/logger/logger.h"
+#include "spi_flash_mmu.h"
+
+//! @brief Marker of a completely written record, changes with the record
+//! layout so records of an older layout are not read
+#define RECORD_MAGIC 0x41515333
+
+//! @brief State of a record that was not consumed yet, erased flash
+#define RECORD_PENDING 0xFFFFFFFF
+
+//! @brief State of a consumed record, only clears bits so no erase is needed
+#define RECORD_CONSUMED 0x00000000
+
+//! @brief Number of records per flash sector
+#define RECORDS_PER_SECTOR (SPI_FLASH_SEC_SIZE / sizeof(Record))
+
+SampleStorage::SampleStorage(const std::string& partition_label)
+    : m_partition(nullptr),
+      m_available(false),
+      m_slots(0),
+      m_head(0),
+      m_tail(0),
+      m_count(0),
+      m_cursor_index(0),
+      m_cursor_slot(0),
+      m_next_sequence(0),
+      m_dropped(0) {
+  static_assert(SPI_FLASH_SEC_SIZE % sizeof(Record) == 0,
+                "A record must not span two flash sectors");
+
+  m_partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+      partition_label.c_str());
+  if (m_partition == nullptr) {
+    Logger::error("Sample partition " + partition_label + " not found");
+    return;
+  }
+
+  // at least two sectors are needed, the sector written next is kept erased
+  m_slots = m_partition->size / SPI_FLASH_SEC_SIZE * RECORDS_PER_SECTOR;
+  if (m_slots < 2 * RECORDS_PER_SECTOR) {
+    Logger::error("Sample partition " + partition_label + " is too small");
+    return;
+  }
+
+  load();
+}
+
+SampleStorage::~SampleStorage() {}
+
+bool SampleStorage::isAvailable() { return m_available; }
+
+void SampleStorage::load() {
+  bool found = false;
+  uint32_t newest_sequence = 0;
+  size_t newest_slot = 0;
+  bool pending_found = false;
+  uint32_t oldest_pending_sequence = 0;
+  size_t oldest_pending_slot = 0;
+  size_t pending_count = 0;
+
+  Record record;
+  for (size_t slot = 0; slot < m_slots; slot++) {
+    if (!readRecord(slot, &record)) {
+      return;
+    }
+    if (record.magic != RECORD_MAGIC) {
+      continue;
+    }
+
+    if (!found || record.sequence > newest_sequence) {
+      newest_sequence = record.sequence;
+      newest_slot = slot;
+    }
+    found = true;
+
+    if (record.state != RECORD_PENDING) {
+      continue;
+    }
+    pending_count++;
+    if (!pending_found || record.sequence < oldest_pending_sequence) {
+      oldest_pending_sequence = record.sequence;
+      oldest_pending_slot = slot;
+      pending_found = true;
+    }
+  }
+
+  if (!found) {
+    // fresh partition or foreign content
+    m_available = format();
+    return;
+  }
+
+  m_next_sequence = newest_sequence + 1;
+  m_tail = (newest_slot + 1) % m_slots;
+
+  // a torn write after the newest record, continue in the next sector
+  if (m_tail % RECORDS_PER_SECTOR != 0) {
+    if (!readRecord(m_tail, &record)) {
+      return;
+    }
+    if (!isErased(record)) {
+      m_tail = (m_tail / RECORDS_PER_SECTOR + 1) * RECORDS_PER_SECTOR % m_slots;
+    }
+  }
+
+  // records are consumed in order, but torn slots without a magic may lie
+  // between the pending records, so only the complete records are counted
+  moveHead(pending_found ? oldest_pending_slot : m_tail);
+  m_count = pending_count;
+
+  m_available = true;
+  Logger::info("Sample storage loaded, " + std::to_string(m_count) +
+               " pending samples");
+}
+
+bool SampleStorage::format() {
+  Logger::info("Formatting sample storage...");
+  if (esp_partition_erase_range(m_partition, 0, m_partition->size) != ESP_OK) {
+    Logger::error("Failed to erase sample partition");
+    return false;
+  }
+  m_tail = 0;
+  m_count = 0;
+  m_next_sequence = 0;
+  moveHead(0);
+  return true;
+}
+
+bool SampleStorage::eraseSector(size_t slot) {
+  const size_t offset = slot / RECORDS_PER_SECTOR * SPI_FLASH_SEC_SIZE;
+  if (esp_partition_erase_range(m_partition, offset, SPI_FLASH_SEC_SIZE) !=
+      ESP_OK) {
+    Logger::error("Failed to erase sample sector");
+    return false;
+  }
+  return true;
+}
+
+bool SampleStorage::readRecord(size_t slot, Record* record) {
+  if (esp_partition_read(m_partition, slot * sizeof(Record), record,
+                         sizeof(Record)) != ESP_OK) {
+    Logger::error("Failed to read sample record");
+    return false;
+  }
+  return true;
+}
+
+bool SampleStorage::isErased(const Record& record) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+  for (size_t i = 0; i < sizeof(Record); i++) {
+    if (bytes[i] != 0xFF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SampleStorage::isPending(const Record& record) {
+  return record.magic == RECORD_MAGIC && record.state == RECORD_PENDING;
+}
+
+void SampleStorage::moveHead(size_t slot) {
+  m_head = slot;
+  m_cursor_index = 0;
+  m_cursor_slot = slot;
+}
+
+bool SampleStorage::findPending(size_t* slot) {
+  Record record;
+  for (; *slot != m_tail; *slot = (*slot + 1) % m_slots) {
+    if (!readRecord(*slot, &record)) {
+      return false;
+    }
+    if (isPending(record)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SampleStorage::append(const AirQualitySample& sample, bool drop_oldest) {
+  if (!m_available) {
+    return false;
+  }
+
+  // entering a new sector, it has to be erased before it can be written
+  if (m_tail % RECORDS_PER_SECTOR == 0) {
+    const bool sector_in_use =
+        m_count > 0 &&
+        m_head / RECORDS_PER_SECTOR == m_tail / RECORDS_PER_SECTOR;
+    if (sector_in_use) {
+      if (!drop_oldest) {
+        m_dropped++;
+        return false;
+      }
+
+      // drop the pending records of the sector that is erased
+      const size_t next_sector =
+          (m_head / RECORDS_PER_SECTOR + 1) * RECORDS_PER_SECTOR % m_slots;
+      size_t dropped = 0;
+      Record record;
+      const size_t head_sector = m_head / RECORDS_PER_SECTOR;
+      for (size_t slot = m_head; slot / RECORDS_PER_SECTOR == head_sector;
+           slot++) {
+        if (!readRecord(slot, &record)) {
+          return false;
+        }
+        if (isPending(record)) {
+          dropped++;
+        }
+      }
+      size_t head = next_sector;
+      m_count -= dropped;
+      m_dropped += dropped;
+      if (m_count == 0 || !findPending(&head)) {
+        head = m_tail;
+      }
+      moveHead(head);
+    }
+
+    if (!eraseSector(m_tail)) {
+      return false;
+    }
+  }
+
+  // the magic is the last member, so it is written last. The padding is
+  // cleared, so no uninitialized memory is written to flash.
+  Record record;
+  memset(&record, 0, sizeof(record));
+  record.sequence = m_next_sequence;
+  record.sample = sample;
+  record.state = RECORD_PENDING;
+  record.magic = RECORD_MAGIC;
+  const bool written = esp_partition_write(m_partition, m_tail * sizeof(Record),
+                                           &record, sizeof(Record)) == ESP_OK;
+
+  // a failed write leaves the slot partly programmed, it must not be written
+  // again before its sector is erased, so it is skipped like a torn slot
+  m_next_sequence++;
+  m_tail = (m_tail + 1) % m_slots;
+  if (!written) {
+    Logger::error("Failed to write sample record");
+    if (m_count == 0) {
+      moveHead(m_tail);
+    }
+    return false;
+  }
+  m_count++;
+  return true;
+}
+
+bool SampleStorage::read(size_t index, AirQualitySample* sample) {
+  if (!m_available || index >= m_count) {
+    return false;
+  }
+
+  // torn slots are skipped, continue at the last read record if possible
+  if (index < m_cursor_index) {
+    m_cursor_index = 0;
+    m_cursor_slot = m_head;
+  }
+  while (m_cursor_index < index) {
+    size_t slot = (m_cursor_slot + 1) % m_slots;
+    if (!findPending(&slot)) {
+      return false;
+    }
+    m_cursor_slot = slot;
+    m_cursor_index++;
+  }
+
+  Record record;
+  if (!readRecord(m_cursor_slot, &record) || !isPending(record)) {
+    return false;
+  }
+  *sample = record.sample;
+  return true;
+}
+
+void SampleStorage::consume(size_t count) {
+  if (!m_available) {
+    return;
+  }
+
+  // the head is always a pending record, torn slots after it are skipped
+  const uint32_t state = RECORD_CONSUMED;
+  size_t head = m_head;
+  for (; count > 0 && m_count > 0; count--) {
+    if (esp_partition_write(m_partition,
+                            head * sizeof(Record) + offsetof(Record, state),
+                            &state, sizeof(state)) != ESP_OK) {
+      // the sample is uploaded again after a reboot
+      Logger::warn("Failed to mark sample record as consumed");
+    }
+    m_count--;
+    head = (head + 1) % m_slots;
+    if (m_count > 0 && !findPending(&head)) {
+      break;
+    }
+  }
+  if (m_count == 0 || head == m_tail) {
+    m_count = 0;
+    head = m_tail;
+  }
+  moveHead(head);
+}
+
+size_t SampleStorage::size() { return m_count; }
+
+size_t SampleStorage::capacity() {
+  return m_available ? m_slots - RECORDS_PER_SECTOR : 0;
+}
+
+uint32_t SampleStorage::getDroppedCount() { return m_dropped; }
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "esp_partition.h"
+
+//! @brief A timestamped air quality sample
+struct AirQualitySample {
+  //! unix time of the measurement, 0 if the clock was not synchronized
+  uint32_t timestamp;
+
+  //! temperature in degrees celsius
+  float temperature;
+
+  //! relative humidity in percent
+  float humidity;
+
+  //! air pressure in pascal
+  float pressure;
+
+  //! gas resistance in ohms
+  uint32_t gas_resistance;
+
+  //! indoor air quality index from 0 to 500, NAN without BSEC
+  float iaq;
+
+  //! CO2 equivalent in ppm, NAN without BSEC
+  float co2_equivalent;
+
+  //! breath VOC equivalent in ppm, NAN without BSEC
+  float breath_voc_equivalent;
+
+  //! accuracy of the indoor air quality index from 0 to 3
+  uint8_t iaq_accuracy;
+
+  //! number of the boot the sample was measured in
+  uint32_t boot_id;
+
+  //! seconds since the boot when the sample was measured, converts the
+  //! sample to unix time once the clock of that boot was synchronized
+  uint32_t uptime;
+};
+
+//! @brief Flash backed FIFO of air quality samples
+//! @note The samples are appended as fixed size records to a data partition
+//! that is used as a ring of flash sectors. A sector is erased when the write
+//! position enters it. Uploaded samples are marked as consumed in place, so
+//! pending samples survive a reboot and are found again by scanning the
+//! partition.
+class SampleStorage {
+ public:
+  //! @brief Constructor
+  //! @param partition_label The label of the data partition to use.
+  SampleStorage(const std::string& partition_label);
+
+  //! @brief Destructor
+  ~SampleStorage();
+
+  //! @brief Check if the partition was found and loaded.
+  //! @return True if the storage can be used, false otherwise.
+  bool isAvailable();
+
+  //! @brief Append a sample.
+  //! @param sample The sample to append.
+  //! @param drop_oldest True to drop the oldest samples if the storage is full,
+  //! false to reject the new sample.
+  //! @return True if the sample was stored, false otherwise.
+  bool append(const AirQualitySample& sample, bool drop_oldest);
+
+  //! @brief Read a pending sample without removing it.
+  //! @param index The position of the sample, 0 is the oldest sample.
+  //! @param sample The sample to store the result in.
+  //! @return True if the sample was read, false otherwise.
+  bool read(size_t index, AirQualitySample* sample);
+
+  //! @brief Mark the oldest pending samples as consumed.
+  //! @param count The number of samples to consume.
+  void consume(size_t count);
+
+  //! @brief Get the number of pending samples.
+  size_t size();
+
+  //! @brief Get the number of samples that can be stored at least.
+  size_t capacity();
+
+  //! @brief Get the number of samples dropped because the storage was full.
+  uint32_t getDroppedCount();
+
+ private:
+  //! @brief A sample record as it is stored in flash
+  struct Record {
+    //! increasing sequence number of the record
+    uint32_t sequence;
+
+    //! the stored sample
+    AirQualitySample sample;
+
+    //! unused, keeps the record size a divisor of the sector size
+    uint8_t reserved[8];
+
+    //! RECORD_PENDING until the sample was consumed
+    uint32_t state;
+
+    //! RECORD_MAGIC, written last to mark the record as complete
+    uint32_t magic;
+  };
+
+  //! @brief Scan the partition for the pending records.
+  void load();
+
+  //! @brief Erase the complete partition and start with an empty storage.
+  bool format();
+
+  //! @brief Erase the flash sector that contains the given slot.
+  //! @param slot The record slot.
+  bool eraseSector(size_t slot);
+
+  //! @brief Read the record of the given slot.
+  //! @param slot The record slot.
+  //! @param record The record to store the result in.
+  bool readRecord(size_t slot, Record* record);
+
+  //! @brief Check if a record is erased flash.
+  //! @param record The record to check.
+  static bool isErased(const Record& record);
+
+  //! @brief Check if a record is complete and was not consumed yet.
+  //! @param record The record to check.
+  static bool isPending(const Record& record);
+
+  //! @brief Move the head and restart sequential reads at it.
+  //! @param slot The new head slot.
+  void moveHead(size_t slot);
+
+  //! @brief Find the first pending record at or after a slot.
+  //! @param slot The slot to start at, set to the pending slot or the tail.
+  //! @return True if a pending record was found before the tail.
+  bool findPending(size_t* slot);
+
+  //! @brief The data partition, nullptr if not found
+  const esp_partition_t* m_partition;
+
+  //! @brief Flag if the storage was loaded successfully
+  bool m_available;
+
+  //! @brief Number of record slots of the partition
+  size_t m_slots;
+
+  //! @brief Slot of the oldest pending record, the tail if there is none
+  size_t m_head;
+
+  //! @brief Slot the next record is written to
+  size_t m_tail;
+
+  //! @brief Number of pending records, torn slots between head and tail are
+  //! not counted
+  size_t m_count;
+
+  //! @brief Index of the last read record, continues sequential reads
+  size_t m_cursor_index;
+
+  //! @brief Slot of the last read record
+  size_t m_cursor_slot;
+
+  //! @brief Sequence number of the next record
+  uint32_t m_next_sequence;
+
+  //! @brief Number of dropped samples
+  uint32_t m_dropped;
+};
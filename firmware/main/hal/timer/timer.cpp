@@ -2,7 +2,14 @@
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <time.h>
 
 #include "esp_system.h"
 
 void Timer::sleepMS(uint32_t ms) { vTaskDelay(ms / portTICK_PERIOD_MS); }
+
+uint32_t Timer::getUnixTime() {
+  // the clock starts at epoch on boot, anything before 2023 is not synchronized
+  const time_t now = time(NULL);
+  return now < 1672531200 ? 0 : static_cast<uint32_t>(now);
+}
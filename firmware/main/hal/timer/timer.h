@@ -7,4 +7,8 @@ class Timer {
   //! @brief Sleep for the given number of milliseconds
   //! @param ms The number of milliseconds to sleep
   static void sleepMS(uint32_t ms);
+
+  //! @brief Get the current unix time
+  //! @return The seconds since epoch, 0 if the clock is not synchronized yet
+  static uint32_t getUnixTime();
 };
\ No newline at end of file
@@ -1,10 +1,14 @@
 #include "main/hal/uart/uart.h"
 
+#include <algorithm>
+
 #include "driver/uart.h"
 #include "esp_timer.h"
 #include "main/logger/logger.h"
 
 static const int RX_BUF_SIZE = 1024;
+// holds a complete screen of commands, so drawing never waits for the wire
+static const int TX_BUF_SIZE = 2048;
 
 Uart::Uart(int rx_pin, int tx_pin, int baud_rate)
     : m_conf({
@@ -25,15 +29,27 @@ Uart::~Uart() {}
 
 void Uart::init() {
   Logger::info("Initializing UART.");
-  uart_driver_install(UART_NUM_1, RX_BUF_SIZE * 2, 0, 0, NULL, 0);
+  uart_driver_install(UART_NUM_1, RX_BUF_SIZE * 2, TX_BUF_SIZE, 0, NULL, 0);
   uart_param_config(UART_NUM_1, &m_conf);
   uart_set_pin(UART_NUM_1, m_tx_pin, m_rx_pin, UART_PIN_NO_CHANGE,
                UART_PIN_NO_CHANGE);
   Logger::info("Finished initializing UART.");
 }
 
-void Uart::sendData(std::vector<uint8_t> data) {
-  uart_write_bytes(UART_NUM_1, data.data(), data.size());
+void Uart::sendData(const uint8_t* data, size_t len) {
+  uart_write_bytes(UART_NUM_1, data, len);
+}
+
+size_t Uart::receiveData(uint8_t* data, size_t len, int timeout_ms) {
+  if (len == 0 ||
+      uart_read_bytes(UART_NUM_1, data, 1, pdMS_TO_TICKS(timeout_ms)) <= 0) {
+    return 0;
+  }
+  size_t available = 0;
+  uart_get_buffered_data_len(UART_NUM_1, &available);
+  const int received =
+      uart_read_bytes(UART_NUM_1, data + 1, std::min(available, len - 1), 0);
+  return 1 + (received > 0 ? received : 0);
 }
 
 void Uart::readData(std::vector<uint8_t>& data, int32_t len) {
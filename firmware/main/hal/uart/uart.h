@@ -19,9 +19,20 @@ class Uart {
   //! @brief Initialize the UART.
   void init();
 
-  //! @brief Send a string to the UART.
+  //! @brief Send data to the UART.
+  //! @note The data is copied into the TX ring buffer of the driver, the call
+  //! only blocks while the ring buffer is full.
   //! @param data The data to send.
-  void sendData(std::vector<uint8_t> data);
+  //! @param len The length of the data to send.
+  void sendData(const uint8_t* data, size_t len);
+
+  //! @brief Receive the data that is available.
+  //! @note Waits for the first byte, then returns the bytes received so far.
+  //! @param data The buffer to store the data in.
+  //! @param len The size of the buffer.
+  //! @param timeout_ms The maximum time to wait for the first byte in ms.
+  //! @return The number of received bytes, 0 on timeout.
+  size_t receiveData(uint8_t* data, size_t len, int timeout_ms);
 
   //! @brief Read data from the UART.
   //! @param data The vector to store the data in.
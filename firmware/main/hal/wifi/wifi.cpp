@@ -6,6 +6,7 @@
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "esp_wifi.h"
 #include "lwip/dns.h"
 #include "lwip/inet.h"
@@ -18,7 +19,8 @@ Wifi::Wifi(NonVolatileStorage* non_volatile_storage)
     : m_non_volatile_storage(non_volatile_storage),
       m_current_mode(WIFIMode::MODE_OFF),
       m_connected(false),
-      m_retries(0) {
+      m_retries(0),
+      m_sntp_started(false) {
   init();
 }
 
@@ -33,6 +35,19 @@ void Wifi::start_dns() { start_dns_server(); }
 
 void Wifi::stop_dns() { stop_dns_server(); }
 
+void Wifi::start_sntp() {
+  if (m_sntp_started) {
+    return;
+  }
+  // synchronize the system clock, used to timestamp the sensor samples
+  esp_sntp_config_t config = ESP_NETIF_SNTP_DEFAULT_CONFIG(SNTP_SERVER);
+  if (esp_netif_sntp_init(&config) != ESP_OK) {
+    Logger::error("Failed to start sntp");
+    return;
+  }
+  m_sntp_started = true;
+}
+
 void Wifi::wifi_event_handler(void* arg, esp_event_base_t event_base,
                               int32_t event_id, void* event_data) {
   if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
@@ -93,6 +108,8 @@ bool Wifi::startStation(const std::string& ssid, const std::string& password) {
   IP_ADDR4(&dns_server, 8, 8, 8, 8);  // Google DNS
   dns_setserver(0, &dns_server);
 
+  start_sntp();
+
   m_current_mode = WIFIMode::MODE_STA;
   return true;
 }
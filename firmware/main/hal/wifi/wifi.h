@@ -47,6 +47,9 @@ class Wifi {
   //! @brief Stop the dns server.
   void stop_dns();
 
+  //! @brief Start the time synchronization with the sntp server.
+  void start_sntp();
+
   //! @brief Initialize the wifi in access point mode.
   void wifi_init_softap();
 
@@ -75,4 +78,7 @@ class Wifi {
 
   //! @brief The number of retries made to connect to the wifi.
   uint8_t m_retries;
+
+  //! @brief Flag if the time synchronization was started.
+  bool m_sntp_started;
 };
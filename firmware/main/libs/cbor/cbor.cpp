@@ -0,0 +1,275 @@
+#include "main/libs/cbor/cbor.h"
+
+#include <cmath>
+#include <cstring>
+
+#define CBOR_MAJOR_UNSIGNED 0
+#define CBOR_MAJOR_NEGATIVE 1
+#define CBOR_MAJOR_BYTES 2
+#define CBOR_MAJOR_TEXT 3
+#define CBOR_MAJOR_ARRAY 4
+#define CBOR_MAJOR_MAP 5
+#define CBOR_MAJOR_TAG 6
+#define CBOR_MAJOR_SIMPLE 7
+
+#define CBOR_INFO_UINT8 24
+#define CBOR_INFO_UINT16 25
+#define CBOR_INFO_UINT32 26
+#define CBOR_INFO_UINT64 27
+
+#define CBOR_SIMPLE_NULL 0xF6
+#define CBOR_SIMPLE_UNDEFINED 0xF7
+
+CborWriter::CborWriter(uint8_t* buffer, size_t capacity)
+    : m_buffer(buffer), m_capacity(capacity), m_size(0), m_overflow(false) {}
+
+void CborWriter::writeArray(size_t count) {
+  writeHead(CBOR_MAJOR_ARRAY, count);
+}
+
+void CborWriter::writeMap(size_t count) { writeHead(CBOR_MAJOR_MAP, count); }
+
+void CborWriter::writeUInt(uint64_t value) {
+  writeHead(CBOR_MAJOR_UNSIGNED, value);
+}
+
+void CborWriter::writeInt(int64_t value) {
+  if (value >= 0) {
+    writeHead(CBOR_MAJOR_UNSIGNED, value);
+  } else {
+    writeHead(CBOR_MAJOR_NEGATIVE, -1 - value);
+  }
+}
+
+void CborWriter::writeFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  const uint8_t data[5] = {(CBOR_MAJOR_SIMPLE << 5) | CBOR_INFO_UINT32,
+                           static_cast<uint8_t>(bits >> 24),
+                           static_cast<uint8_t>(bits >> 16),
+                           static_cast<uint8_t>(bits >> 8),
+                           static_cast<uint8_t>(bits)};
+  writeBytes(data, sizeof(data));
+}
+
+void CborWriter::writeString(const char* text) {
+  const size_t length = strlen(text);
+  writeHead(CBOR_MAJOR_TEXT, length);
+  writeBytes(reinterpret_cast<const uint8_t*>(text), length);
+}
+
+size_t CborWriter::size() { return m_size; }
+
+bool CborWriter::ok() { return !m_overflow; }
+
+void CborWriter::writeHead(uint8_t major, uint64_t argument) {
+  uint8_t data[9];
+  size_t length;
+  data[0] = major << 5;
+
+  if (argument < CBOR_INFO_UINT8) {
+    data[0] |= argument;
+    length = 1;
+  } else if (argument <= UINT8_MAX) {
+    data[0] |= CBOR_INFO_UINT8;
+    length = 2;
+  } else if (argument <= UINT16_MAX) {
+    data[0] |= CBOR_INFO_UINT16;
+    length = 3;
+  } else if (argument <= UINT32_MAX) {
+    data[0] |= CBOR_INFO_UINT32;
+    length = 5;
+  } else {
+    data[0] |= CBOR_INFO_UINT64;
+    length = 9;
+  }
+
+  // big endian argument after the initial byte
+  for (size_t i = 1; i < length; i++) {
+    data[i] = argument >> (8 * (length - 1 - i));
+  }
+  writeBytes(data, length);
+}
+
+void CborWriter::writeBytes(const uint8_t* data, size_t length) {
+  if (m_overflow || m_size + length > m_capacity) {
+    m_overflow = true;
+    return;
+  }
+  memcpy(m_buffer + m_size, data, length);
+  m_size += length;
+}
+
+CborReader::CborReader(const uint8_t* data, size_t size)
+    : m_data(data), m_size(size), m_offset(0) {}
+
+bool CborReader::readHead(uint8_t* major, uint8_t* info, uint64_t* argument) {
+  if (m_offset >= m_size) {
+    return false;
+  }
+
+  *major = m_data[m_offset] >> 5;
+  *info = m_data[m_offset] & 0x1F;
+  m_offset++;
+
+  size_t length;
+  if (*info < CBOR_INFO_UINT8) {
+    *argument = *info;
+    return true;
+  } else if (*info == CBOR_INFO_UINT8) {
+    length = 1;
+  } else if (*info == CBOR_INFO_UINT16) {
+    length = 2;
+  } else if (*info == CBOR_INFO_UINT32) {
+    length = 4;
+  } else if (*info == CBOR_INFO_UINT64) {
+    length = 8;
+  } else {
+    // indefinite length items are not supported
+    return false;
+  }
+
+  if (m_offset + length > m_size) {
+    return false;
+  }
+
+  *argument = 0;
+  for (size_t i = 0; i < length; i++) {
+    *argument = (*argument << 8) | m_data[m_offset + i];
+  }
+  m_offset += length;
+  return true;
+}
+
+bool CborReader::readArray(size_t* count) {
+  uint8_t major, info;
+  uint64_t argument;
+  if (!readHead(&major, &info, &argument) || major != CBOR_MAJOR_ARRAY) {
+    return false;
+  }
+  *count = argument;
+  return true;
+}
+
+bool CborReader::readMap(size_t* count) {
+  uint8_t major, info;
+  uint64_t argument;
+  if (!readHead(&major, &info, &argument) || major != CBOR_MAJOR_MAP) {
+    return false;
+  }
+  *count = argument;
+  return true;
+}
+
+bool CborReader::readNumber(double* value) {
+  uint8_t major, info;
+  uint64_t argument;
+  if (!readHead(&major, &info, &argument)) {
+    return false;
+  }
+
+  switch (major) {
+    case CBOR_MAJOR_UNSIGNED:
+      *value = static_cast<double>(argument);
+      return true;
+
+    case CBOR_MAJOR_NEGATIVE:
+      *value = -1.0 - static_cast<double>(argument);
+      return true;
+
+    case CBOR_MAJOR_SIMPLE:
+      if (info == CBOR_INFO_UINT16) {
+        // half precision float
+        const int exponent = (argument >> 10) & 0x1F;
+        const double mantissa = argument & 0x3FF;
+        double result;
+        if (exponent == 0) {
+          result = ldexp(mantissa, -24);
+        } else if (exponent == 0x1F) {
+          result = mantissa == 0 ? INFINITY : NAN;
+        } else {
+          result = ldexp(mantissa + 1024, exponent - 25);
+        }
+        *value = (argument & 0x8000) ? -result : result;
+        return true;
+      } else if (info == CBOR_INFO_UINT32) {
+        const uint32_t bits = argument;
+        float result;
+        memcpy(&result, &bits, sizeof(result));
+        *value = result;
+        return true;
+      } else if (info == CBOR_INFO_UINT64) {
+        memcpy(value, &argument, sizeof(*value));
+        return true;
+      }
+      return false;
+
+    default:
+      return false;
+  }
+}
+
+bool CborReader::readNullableNumber(double* value) {
+  if (m_offset < m_size && (m_data[m_offset] == CBOR_SIMPLE_NULL ||
+                            m_data[m_offset] == CBOR_SIMPLE_UNDEFINED)) {
+    m_offset++;
+    *value = NAN;
+    return true;
+  }
+  return readNumber(value);
+}
+
+bool CborReader::readString(const char** text, size_t* length) {
+  uint8_t major, info;
+  uint64_t argument;
+  if (!readHead(&major, &info, &argument) || major != CBOR_MAJOR_TEXT ||
+      argument > m_size - m_offset) {
+    return false;
+  }
+  *text = reinterpret_cast<const char*>(m_data + m_offset);
+  *length = argument;
+  m_offset += argument;
+  return true;
+}
+
+bool CborReader::skip() {
+  uint8_t major, info;
+  uint64_t argument;
+  if (!readHead(&major, &info, &argument)) {
+    return false;
+  }
+
+  switch (major) {
+    case CBOR_MAJOR_BYTES:
+    case CBOR_MAJOR_TEXT:
+      if (argument > m_size - m_offset) {
+        return false;
+      }
+      m_offset += argument;
+      return true;
+
+    case CBOR_MAJOR_ARRAY:
+      for (uint64_t i = 0; i < argument; i++) {
+        if (!skip()) {
+          return false;
+        }
+      }
+      return true;
+
+    case CBOR_MAJOR_MAP:
+      for (uint64_t i = 0; i < 2 * argument; i++) {
+        if (!skip()) {
+          return false;
+        }
+      }
+      return true;
+
+    case CBOR_MAJOR_TAG:
+      return skip();
+
+    default:
+      return true;
+  }
+}
+
+bool CborReader::atEnd() { return m_offset == m_size; }
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! @brief The CBOR content type
+#define CBOR_CONTENT_TYPE "application/cbor"
+
+//! @brief CBOR (RFC 8949) encoder writing into a preallocated buffer
+//! @note Only definite length items are written. If the buffer is too small
+//! the writer stops writing and ok() returns false.
+class CborWriter {
+ public:
+  //! @brief Constructor
+  //! @param buffer The buffer to write to
+  //! @param capacity The size of the buffer in bytes
+  CborWriter(uint8_t* buffer, size_t capacity);
+
+  //! @brief Start an array
+  //! @param count The number of items of the array
+  void writeArray(size_t count);
+
+  //! @brief Start a map
+  //! @param count The number of key value pairs of the map
+  void writeMap(size_t count);
+
+  //! @brief Write an unsigned integer
+  //! @param value The value
+  void writeUInt(uint64_t value);
+
+  //! @brief Write a signed integer
+  //! @param value The value
+  void writeInt(int64_t value);
+
+  //! @brief Write a single precision float
+  //! @param value The value
+  void writeFloat(float value);
+
+  //! @brief Write a text string
+  //! @param text The text, must be zero terminated
+  void writeString(const char* text);
+
+  //! @brief Get the number of bytes written
+  size_t size();
+
+  //! @brief Check if all items fit into the buffer
+  //! @return True if nothing was truncated, false otherwise
+  bool ok();
+
+ private:
+  //! @brief Write the head of an item
+  //! @param major The major type
+  //! @param argument The value or length of the item
+  void writeHead(uint8_t major, uint64_t argument);
+
+  //! @brief Write raw bytes
+  //! @param data The bytes
+  //! @param length The number of bytes
+  void writeBytes(const uint8_t* data, size_t length);
+
+  //! @brief The buffer to write to
+  uint8_t* m_buffer;
+
+  //! @brief The size of the buffer
+  const size_t m_capacity;
+
+  //! @brief The number of bytes written
+  size_t m_size;
+
+  //! @brief Flag if the buffer overflowed
+  bool m_overflow;
+};
+
+//! @brief CBOR (RFC 8949) decoder reading from a buffer without copies
+//! @note Strings are returned as pointers into the buffer. Indefinite length
+//! items are not supported.
+class CborReader {
+ public:
+  //! @brief Constructor
+  //! @param data The encoded data
+  //! @param size The size of the data in bytes
+  CborReader(const uint8_t* data, size_t size);
+
+  //! @brief Read the start of an array
+  //! @param count The number of items of the array
+  //! @return True if an array was read, false otherwise
+  bool readArray(size_t* count);
+
+  //! @brief Read the start of a map
+  //! @param count The number of key value pairs of the map
+  //! @return True if a map was read, false otherwise
+  bool readMap(size_t* count);
+
+  //! @brief Read a number, integers and floats are accepted
+  //! @param value The value
+  //! @return True if a number was read, false otherwise
+  bool readNumber(double* value);
+
+  //! @brief Read a number that may be null
+  //! @param value The value, NAN for null or undefined
+  //! @return True if a number or null was read, false otherwise
+  bool readNullableNumber(double* value);
+
+  //! @brief Read a text string
+  //! @param text The pointer to the text in the buffer, not zero terminated
+  //! @param length The length of the text
+  //! @return True if a text string was read, false otherwise
+  bool readString(const char** text, size_t* length);
+
+  //! @brief Skip the next item including all nested items
+  //! @return True if the item was skipped, false otherwise
+  bool skip();
+
+  //! @brief Check if all data was read
+  bool atEnd();
+
+ private:
+  //! @brief Read the head of an item
+  //! @param major The major type
+  //! @param info The additional information
+  //! @param argument The value or length of the item
+  //! @return True if the head was read, false otherwise
+  bool readHead(uint8_t* major, uint8_t* info, uint64_t* argument);
+
+  //! @brief The encoded data
+  const uint8_t* m_data;
+
+  //! @brief The size of the data
+  const size_t m_size;
+
+  //! @brief The current read position
+  size_t m_offset;
+};
@@ -0,0 +1,273 @@
+#include "main/libs/json_stream/json_stream.h"
+
+#include <cstdlib>
+#include <cstring>
+
+JsonStreamParser::JsonStreamParser(JsonStreamHandler* handler)
+    : m_handler(handler) {
+  reset();
+}
+
+void JsonStreamParser::reset() {
+  m_state = STATE_VALUE;
+  m_containers = 0;
+  m_depth = 0;
+  m_expect_key = false;
+  m_is_key = false;
+  m_done = false;
+  m_token_length = 0;
+  m_code_point = 0;
+  m_code_point_digits = 0;
+}
+
+bool JsonStreamParser::feed(const char* data, size_t length) {
+  for (size_t i = 0; i < length && m_state != STATE_ERROR; i++) {
+    const char c = data[i];
+    switch (m_state) {
+      case STATE_STRING:
+      case STATE_ESCAPE:
+      case STATE_UNICODE:
+        parseString(c);
+        break;
+
+      case STATE_NUMBER:
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+            c == 'e' || c == 'E') {
+          append(c);
+          if (m_token_length == sizeof(m_token) - 1) {
+            m_state = STATE_ERROR;
+          }
+        } else {
+          finishNumber();
+          parseStructure(c);
+        }
+        break;
+
+      case STATE_LITERAL:
+        if (c >= 'a' && c <= 'z' && m_token_length < 5) {
+          append(c);
+        } else {
+          finishLiteral();
+          parseStructure(c);
+        }
+        break;
+
+      default:
+        parseStructure(c);
+        break;
+    }
+  }
+  return m_state != STATE_ERROR;
+}
+
+bool JsonStreamParser::finish() {
+  // a top level number or literal ends with the input
+  if (m_state == STATE_NUMBER) {
+    finishNumber();
+  } else if (m_state == STATE_LITERAL) {
+    finishLiteral();
+  }
+  return m_state == STATE_VALUE && m_depth == 0 && m_done;
+}
+
+void JsonStreamParser::parseStructure(char c) {
+  if (m_state == STATE_ERROR) {
+    return;
+  }
+
+  switch (c) {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+      return;
+
+    case '{':
+    case '[':
+      if (m_depth == JSON_STREAM_MAX_DEPTH) {
+        m_state = STATE_ERROR;
+        return;
+      }
+      if (c == '{') {
+        m_containers |= 1 << m_depth;
+        m_expect_key = true;
+        m_handler->onStartObject();
+      } else {
+        m_containers &= ~(1 << m_depth);
+        m_expect_key = false;
+        m_handler->onStartArray();
+      }
+      m_depth++;
+      return;
+
+    case '}':
+    case ']':
+      if (m_depth == 0 || inObject() != (c == '}')) {
+        m_state = STATE_ERROR;
+        return;
+      }
+      m_depth--;
+      m_expect_key = false;
+      if (c == '}') {
+        m_handler->onEndObject();
+      } else {
+        m_handler->onEndArray();
+      }
+      m_done = m_depth == 0;
+      return;
+
+    case ':':
+      m_expect_key = false;
+      return;
+
+    case ',':
+      m_expect_key = inObject();
+      return;
+
+    case '"':
+      m_is_key = m_expect_key;
+      m_token_length = 0;
+      m_state = STATE_STRING;
+      return;
+
+    case 't':
+    case 'f':
+    case 'n':
+      m_token_length = 0;
+      append(c);
+      m_state = STATE_LITERAL;
+      return;
+
+    default:
+      if ((c >= '0' && c <= '9') || c == '-') {
+        m_token_length = 0;
+        append(c);
+        m_state = STATE_NUMBER;
+        return;
+      }
+      m_state = STATE_ERROR;
+      return;
+  }
+}
+
+void JsonStreamParser::parseString(char c) {
+  if (m_state == STATE_ESCAPE) {
+    m_state = STATE_STRING;
+    switch (c) {
+      case 'b':
+        append('\b');
+        break;
+      case 'f':
+        append('\f');
+        break;
+      case 'n':
+        append('\n');
+        break;
+      case 'r':
+        append('\r');
+        break;
+      case 't':
+        append('\t');
+        break;
+      case 'u':
+        m_code_point = 0;
+        m_code_point_digits = 0;
+        m_state = STATE_UNICODE;
+        break;
+      default:
+        append(c);
+        break;
+    }
+    return;
+  }
+
+  if (m_state == STATE_UNICODE) {
+    uint8_t digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      digit = c - 'A' + 10;
+    } else {
+      m_state = STATE_ERROR;
+      return;
+    }
+    m_code_point = (m_code_point << 4) | digit;
+    if (++m_code_point_digits < 4) {
+      return;
+    }
+
+    // encode the code point as utf-8, surrogate pairs are kept as they are
+    if (m_code_point < 0x80) {
+      append(m_code_point);
+    } else if (m_code_point < 0x800) {
+      append(0xC0 | (m_code_point >> 6));
+      append(0x80 | (m_code_point & 0x3F));
+    } else {
+      append(0xE0 | (m_code_point >> 12));
+      append(0x80 | ((m_code_point >> 6) & 0x3F));
+      append(0x80 | (m_code_point & 0x3F));
+    }
+    m_state = STATE_STRING;
+    return;
+  }
+
+  if (c == '\\') {
+    m_state = STATE_ESCAPE;
+    return;
+  }
+
+  if (c != '"') {
+    append(c);
+    return;
+  }
+
+  m_token[m_token_length] = '\0';
+  m_state = STATE_VALUE;
+  if (m_is_key) {
+    m_expect_key = false;
+    m_handler->onKey(m_token, m_token_length);
+  } else {
+    m_handler->onString(m_token, m_token_length);
+    m_done = m_depth == 0;
+  }
+}
+
+void JsonStreamParser::finishNumber() {
+  m_token[m_token_length] = '\0';
+  char* end;
+  const double value = strtod(m_token, &end);
+  if (end != m_token + m_token_length) {
+    m_state = STATE_ERROR;
+    return;
+  }
+  m_state = STATE_VALUE;
+  m_handler->onNumber(value);
+  m_done = m_depth == 0;
+}
+
+void JsonStreamParser::finishLiteral() {
+  m_token[m_token_length] = '\0';
+  if (strcmp(m_token, "true") == 0) {
+    m_handler->onLiteral(true);
+  } else if (strcmp(m_token, "false") == 0 || strcmp(m_token, "null") == 0) {
+    m_handler->onLiteral(false);
+  } else {
+    m_state = STATE_ERROR;
+    return;
+  }
+  m_state = STATE_VALUE;
+  m_done = m_depth == 0;
+}
+
+void JsonStreamParser::append(char c) {
+  // overlong strings are truncated, one byte is kept for the terminator
+  if (m_token_length < sizeof(m_token) - 1) {
+    m_token[m_token_length++] = c;
+  }
+}
+
+bool JsonStreamParser::inObject() {
+  return m_depth > 0 && (m_containers & (1 << (m_depth - 1)));
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//! @brief Maximum nesting depth of the parsed json
+#define JSON_STREAM_MAX_DEPTH 16
+
+//! @brief Size of the buffer for a single string or number token
+#define JSON_STREAM_TOKEN_SIZE 64
+
+//! @brief Receiver of the events of a JsonStreamParser
+class JsonStreamHandler {
+ public:
+  //! @brief Destructor
+  virtual ~JsonStreamHandler() = default;
+
+  //! @brief Called when an object starts
+  virtual void onStartObject() = 0;
+
+  //! @brief Called when an object ends
+  virtual void onEndObject() = 0;
+
+  //! @brief Called when an array starts
+  virtual void onStartArray() = 0;
+
+  //! @brief Called when an array ends
+  virtual void onEndArray() = 0;
+
+  //! @brief Called for the key of an object member
+  //! @param key The key, zero terminated, only valid during the call
+  //! @param length The length of the key
+  virtual void onKey(const char* key, size_t length) = 0;
+
+  //! @brief Called for a string value
+  //! @param value The string, zero terminated, only valid during the call
+  //! @param length The length of the string
+  virtual void onString(const char* value, size_t length) = 0;
+
+  //! @brief Called for a number value
+  //! @param value The number
+  virtual void onNumber(double value) = 0;
+
+  //! @brief Called for true, false and null
+  //! @param value The boolean value, false for null
+  virtual void onLiteral(bool value) = 0;
+};
+
+//! @brief SAX style json parser that consumes its input in chunks
+//! @note The parser keeps no copy of the input, only the current token is
+//! buffered. Strings longer than JSON_STREAM_TOKEN_SIZE - 1 bytes are
+//! truncated, so the memory use does not depend on the size of the input.
+class JsonStreamParser {
+ public:
+  //! @brief Constructor
+  //! @param handler The receiver of the parser events
+  JsonStreamParser(JsonStreamHandler* handler);
+
+  //! @brief Reset the parser to parse a new document
+  void reset();
+
+  //! @brief Parse the next chunk of the input
+  //! @param data The chunk
+  //! @param length The length of the chunk
+  //! @return True if the input is valid so far, false otherwise
+  bool feed(const char* data, size_t length);
+
+  //! @brief Finish parsing after the last chunk
+  //! @return True if a complete document was parsed, false otherwise
+  bool finish();
+
+ private:
+  //! @brief The parser states
+  enum State {
+    STATE_VALUE,
+    STATE_STRING,
+    STATE_ESCAPE,
+    STATE_UNICODE,
+    STATE_NUMBER,
+    STATE_LITERAL,
+    STATE_ERROR
+  };
+
+  //! @brief Parse a character outside of a token
+  //! @param c The character
+  void parseStructure(char c);
+
+  //! @brief Parse a character of a string
+  //! @param c The character
+  void parseString(char c);
+
+  //! @brief Finish the number in the token buffer
+  void finishNumber();
+
+  //! @brief Finish the literal in the token buffer
+  void finishLiteral();
+
+  //! @brief Append a character to the token buffer
+  //! @param c The character
+  void append(char c);
+
+  //! @brief Check if the current container is an object
+  bool inObject();
+
+  //! @brief The receiver of the parser events
+  JsonStreamHandler* m_handler;
+
+  //! @brief The current state
+  State m_state;
+
+  //! @brief The container types, bit set for objects
+  uint32_t m_containers;
+
+  //! @brief The current nesting depth
+  uint8_t m_depth;
+
+  //! @brief Flag if the next string is an object key
+  bool m_expect_key;
+
+  //! @brief Flag if the current string is an object key
+  bool m_is_key;
+
+  //! @brief Flag if a complete top level value was parsed
+  bool m_done;
+
+  //! @brief The current token
+  char m_token[JSON_STREAM_TOKEN_SIZE];
+
+  //! @brief The length of the current token
+  size_t m_token_length;
+
+  //! @brief The code point of a \u escape sequence
+  uint16_t m_code_point;
+
+  //! @brief The number of hex digits of a \u escape sequence read so far
+  uint8_t m_code_point_digits;
+};
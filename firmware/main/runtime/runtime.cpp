@@ -1,46 +1,63 @@
 #include "main/runtime/runtime.h"
 
+#include <algorithm>
+
 #include "esp_timer.h"
 #include "main/config.h"
 #include "main/hal/timer/timer.h"
 #include "main/logger/logger.h"
 
 Runtime::Runtime()
-    : m_i2c(nullptr),
+    : m_gesture_interrupt_pin(nullptr),
+      m_gesture_task_handle(NULL),
+      m_gesture_interrupt_time(0),
+      m_gesture_count(0),
+      m_gesture_latency_sum(0),
+      m_gesture_latency_max(0),
+      m_no_sleep_lock(NULL),
+      m_i2c(nullptr),
       m_uart(nullptr),
       m_non_volatile_storage(nullptr),
       m_wifi(nullptr),
       m_http_server(nullptr),
-      m_upload_data_http_client(nullptr),
-      m_download_data_http_client(nullptr),
+      m_http_client(nullptr),
+      m_network_service(nullptr),
       m_registration_portal(nullptr),
       m_eink(nullptr),
       m_apds9960(nullptr),
       m_bme680(nullptr),
       m_ui_service(nullptr),
       m_authentication_service(nullptr),
+      m_sample_storage(nullptr),
+      m_sample_buffer(nullptr),
+      m_bsec_service(nullptr),
       m_data_service(nullptr),
       m_data_download_service(nullptr),
       m_home_ui(nullptr),
       m_image_ui(nullptr) {}
 
 Runtime::~Runtime() {
+  // the ui service stops its task, which uses the home ui and the data
+  delete m_ui_service;
   delete m_home_ui;
   delete m_data_download_service;
   delete m_data_service;
+  delete m_bsec_service;
+  delete m_sample_buffer;
+  delete m_sample_storage;
   delete m_authentication_service;
-  delete m_ui_service;
   delete m_bme680;
   delete m_apds9960;
   delete m_eink;
   delete m_registration_portal;
-  delete m_download_data_http_client;
-  delete m_upload_data_http_client;
+  delete m_network_service;
+  delete m_http_client;
   delete m_http_server;
   delete m_wifi;
   delete m_non_volatile_storage;
   delete m_uart;
   delete m_i2c;
+  delete m_gesture_interrupt_pin;
   delete m_display_wakeup_pin;
   delete m_led_pin;
 }
@@ -60,6 +77,7 @@ void Runtime::initialize() {
   Timer::sleepMS(2000);
 
   m_i2c = new I2C(21, 22, 1000);
+  m_i2c->scan();
 
   m_non_volatile_storage = new NonVolatileStorage();
 
@@ -67,30 +85,75 @@ void Runtime::initialize() {
 
   m_http_server = new HTTPServer();
 
-  m_upload_data_http_client = new HTTPClient();
+  m_http_client = new HTTPClient();
 
-  m_download_data_http_client = new HTTPClient();
+  m_network_service = new NetworkService(m_http_client);
+  m_network_service->startNetworkTask();
 
-  m_authentication_service = new AuthenticationService(
-      m_upload_data_http_client, m_non_volatile_storage);
+  m_authentication_service =
+      new AuthenticationService(m_network_service, m_non_volatile_storage);
 
   m_registration_portal = new RegistrationPortal(
       m_wifi, m_http_server, m_authentication_service, m_image_ui);
 
-  m_bme680 = new BME680(m_i2c);
+  // gestures are read while the user waits, the BME680 measurements are not
+  // time critical
+  m_i2c->addDevice(BME68X_DEFAULT_ADDRESS,
+                   {.clock_speed = I2C_FAST_MODE_CLOCK_SPEED,
+                    .timeout_ms = I2C_SENSOR_TIMEOUT_MS,
+                    .priority = I2C_PRIORITY_NORMAL});
+  m_i2c->addDevice(APDS9960_ADDRESS,
+                   {.clock_speed = I2C_FAST_MODE_CLOCK_SPEED,
+                    .timeout_ms = I2C_SENSOR_TIMEOUT_MS,
+                    .priority = I2C_PRIORITY_HIGH});
 
+  m_bme680 = new BME680(m_i2c);
   m_apds9960 = new APDS9960(m_i2c);
+  if (m_apds9960->isConnected()) {
+    // the INT pin of the sensor is open drain and active low
+    m_gesture_interrupt_pin = new DigitalInputPin(4, true);
+    m_apds9960->enableGestureInterrupt();
+  }
+
+#if SAMPLE_STORAGE_ENABLED
+  m_sample_storage = new SampleStorage(SAMPLE_STORAGE_PARTITION);
+#endif
+
+  m_sample_buffer = new SampleBuffer(
+      SAMPLE_BUFFER_CAPACITY, SAMPLE_BUFFER_DROP_POLICY, m_sample_storage);
 
-  m_data_service = new DataService(m_upload_data_http_client,
-                                   m_authentication_service, m_bme680);
+#if BSEC_ENABLED
+  m_bsec_service = new BsecService(m_bme680, m_non_volatile_storage);
+  m_bsec_service->startBsecTask();
+#endif
 
-  m_data_download_service = new DataDownloadService(m_download_data_http_client,
-                                                    m_authentication_service);
+  m_data_service = new DataService(m_network_service, m_authentication_service,
+                                   m_bme680, m_sample_buffer,
+                                   m_non_volatile_storage, m_bsec_service);
 
-  m_home_ui = new HomeUI(m_eink, m_data_download_service);
+  m_data_download_service =
+      new DataDownloadService(m_network_service, m_authentication_service);
+
+  m_home_ui = new HomeUI();
 
   m_ui_service =
       new UIService(m_eink, m_data_download_service, m_home_ui, m_image_ui);
+  m_ui_service->startPrepareTask();
+
+#if LIGHT_SLEEP_ENABLED && CONFIG_PM_ENABLE
+  // the chip enters light sleep whenever all tasks are blocked, the display
+  // transfer is protected by a lock until the display acknowledged all frames
+  // because the UART stops while sleeping
+  esp_pm_config_t pm_config = {
+      .max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ,
+      .min_freq_mhz = CONFIG_XTAL_FREQ,
+      .light_sleep_enable = true};
+  if (esp_pm_configure(&pm_config) != ESP_OK ||
+      esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "ui",
+                         &m_no_sleep_lock) != ESP_OK) {
+    Logger::error("Failed to enable light sleep");
+  }
+#endif
 
   Logger::debug("Runtime initialized");
   // check if the device is authenticated and try to connect to the wifi
@@ -113,7 +176,7 @@ void Runtime::initialize() {
     m_data_download_service->startDataDownloadTask();
 
     // wait for the first data to be downloaded
-    while (m_data_download_service->getAirQualityData().size() == 0) {
+    while (m_data_download_service->getAirQualityData()->empty()) {
       Timer::sleepMS(1000);
       Logger::debug("Waiting for first data to be downloaded");
     }
@@ -130,27 +193,113 @@ void Runtime::run() {
   // m_eink->clearDisplay();
   // m_eink->updateDisplay();
 
+  if (m_no_sleep_lock != NULL) {
+    esp_pm_lock_acquire(m_no_sleep_lock);
+  }
   m_ui_service->show();
+  if (m_no_sleep_lock != NULL) {
+    m_eink->waitUntilIdle(EINK_SLOW_ACK_TIMEOUT_MS);
+    esp_pm_lock_release(m_no_sleep_lock);
+  }
 
+  // the task sleeps until the gesture sensor pulls its INT pin low, the level
+  // trigger also wakes the chip from light sleep
+  m_gesture_task_handle = xTaskGetCurrentTaskHandle();
+  if (m_gesture_interrupt_pin != nullptr &&
+      m_gesture_interrupt_pin->attachInterrupt(GPIO_INTR_LOW_LEVEL,
+                                               onGestureInterrupt, this)) {
+    m_gesture_interrupt_pin->enableWakeup(false);
+  }
+
+  uint32_t refreshes = 0;
   auto start_time = esp_timer_get_time();
   while (1) {
-    auto gesture = m_apds9960->readGesture();
-
-    if (gesture == APDS9960_LEFT) {
-      Logger::debug("Left gesture detected");
-      m_ui_service->moveLeft();
-      start_time = esp_timer_get_time();
-    } else if (gesture == APDS9960_RIGHT) {
-      Logger::debug("Right gesture detected");
-      m_ui_service->moveRight();
+    // wait for a gesture until the next refresh is due
+    const int64_t refresh_in_us =
+        30000000 - (esp_timer_get_time() - start_time);
+    const TickType_t timeout =
+        refresh_in_us > 0 ? pdMS_TO_TICKS(refresh_in_us / 1000) + 1 : 0;
+    if (ulTaskNotifyTake(pdTRUE, timeout) > 0) {
+      handleGesture();
       start_time = esp_timer_get_time();
     }
-    Timer::sleepMS(1);
 
-    // refresh after 30 seconds
+    // refresh after 30 seconds if the data changed
     if (esp_timer_get_time() - start_time > 30000000) {
-      m_ui_service->show();
+      if (m_no_sleep_lock != NULL) {
+        esp_pm_lock_acquire(m_no_sleep_lock);
+      }
+      m_ui_service->refresh();
+      if (m_no_sleep_lock != NULL) {
+        m_eink->waitUntilIdle(EINK_SLOW_ACK_TIMEOUT_MS);
+        esp_pm_lock_release(m_no_sleep_lock);
+      }
       start_time = esp_timer_get_time();
+
+      // report the bus statistics every 10 refreshes
+      if (++refreshes % 10 == 0) {
+        m_i2c->logStatistics();
+      }
     }
   }
 }
+
+void Runtime::onGestureInterrupt(void* arg) {
+  Runtime* runtime = (Runtime*)arg;
+
+  // the level interrupt stays disabled until the FIFO was read, otherwise it
+  // would fire again immediately
+  runtime->m_gesture_interrupt_pin->disableInterrupt();
+  runtime->m_gesture_interrupt_time = esp_timer_get_time();
+
+  BaseType_t higher_priority_task_woken = pdFALSE;
+  vTaskNotifyGiveFromISR(runtime->m_gesture_task_handle,
+                         &higher_priority_task_woken);
+  portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+void Runtime::handleGesture() {
+  if (m_no_sleep_lock != NULL) {
+    esp_pm_lock_acquire(m_no_sleep_lock);
+  }
+
+  const auto gesture = m_apds9960->readGesture();
+  bool shown = true;
+  if (gesture == APDS9960_LEFT) {
+    Logger::debug("Left gesture detected");
+    m_ui_service->moveLeft();
+  } else if (gesture == APDS9960_RIGHT) {
+    Logger::debug("Right gesture detected");
+    m_ui_service->moveRight();
+  } else {
+    shown = false;
+  }
+
+  if (m_no_sleep_lock != NULL) {
+    m_eink->waitUntilIdle(EINK_SLOW_ACK_TIMEOUT_MS);
+    esp_pm_lock_release(m_no_sleep_lock);
+  }
+  m_gesture_interrupt_pin->enableInterrupt();
+
+  if (!shown) {
+    return;
+  }
+
+  // the latency covers the gesture itself, its decoding and the transfer of
+  // the new screen to the display
+  const int64_t latency = esp_timer_get_time() - m_gesture_interrupt_time;
+  m_gesture_latency_sum += latency;
+  m_gesture_latency_max = std::max(m_gesture_latency_max, latency);
+  Logger::debug("Gesture to screen latency: " +
+                std::to_string(latency / 1000) + " ms");
+
+  if (++m_gesture_count == GESTURE_LATENCY_REPORT_INTERVAL) {
+    Logger::info(
+        "Gesture to screen latency average: " +
+        std::to_string(m_gesture_latency_sum / m_gesture_count / 1000) +
+        " ms max: " + std::to_string(m_gesture_latency_max / 1000) + " ms");
+    m_gesture_count = 0;
+    m_gesture_latency_sum = 0;
+    m_gesture_latency_max = 0;
+  }
+}
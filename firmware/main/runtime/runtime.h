@@ -2,20 +2,27 @@
 
 #include <cstdint>
 
+#include "esp_pm.h"
+
 #include "main/driver/apds9960/apds9960.h"
 #include "main/driver/bme680/bme680.h"
 #include "main/driver/eink/eink.h"
+#include "main/hal/digital_input_pin/digital_input_pin.h"
 #include "main/hal/digital_output_pin/digital_output_pin.h"
 #include "main/hal/http_client/http_client.h"
 #include "main/hal/http_server/http_server.h"
 #include "main/hal/i2c/i2c.h"
 #include "main/hal/non_volatile_storage/non_volatile_storage.h"
 #include "main/hal/registration_portal/registration_portal.h"
+#include "main/hal/sample_storage/sample_storage.h"
 #include "main/hal/uart/uart.h"
 #include "main/hal/wifi/wifi.h"
 #include "main/service/authentication_service/authentication_service.h"
+#include "main/service/bsec_service/bsec_service.h"
 #include "main/service/data_download_service/data_download_service.h"
 #include "main/service/data_service/data_service.h"
+#include "main/service/network_service/network_service.h"
+#include "main/service/sample_buffer/sample_buffer.h"
 #include "main/service/ui_service/ui_service.h"
 #include "main/ui/home_ui/home_ui.h"
 #include "main/ui/image_ui/image_ui.h"
@@ -36,6 +43,13 @@ class Runtime {
   void run();
 
  private:
+  //! @brief Interrupt handler of the gesture sensor, wakes the run task.
+  //! @param arg Pointer to the runtime.
+  static void onGestureInterrupt(void* arg);
+
+  //! @brief Handle the gesture that triggered the interrupt.
+  void handleGesture();
+
   //! @brief The current runtime state.
   uint8_t m_runtime_state;
 
@@ -45,6 +59,28 @@ class Runtime {
   //! @brief The display wakeup pin.
   DigitalOutputPin* m_display_wakeup_pin;
 
+  //! @brief The interrupt pin of the gesture sensor.
+  DigitalInputPin* m_gesture_interrupt_pin;
+
+  //! @brief The task woken by the gesture interrupt.
+  TaskHandle_t m_gesture_task_handle;
+
+  //! @brief Time in microseconds of the last gesture interrupt, written by
+  //! the interrupt handler.
+  volatile int64_t m_gesture_interrupt_time;
+
+  //! @brief Number of gestures since the latency was reported.
+  uint32_t m_gesture_count;
+
+  //! @brief Sum of the gesture to screen latencies in microseconds.
+  int64_t m_gesture_latency_sum;
+
+  //! @brief Maximum gesture to screen latency in microseconds.
+  int64_t m_gesture_latency_max;
+
+  //! @brief Lock that keeps the chip awake while the UI talks to the display.
+  esp_pm_lock_handle_t m_no_sleep_lock;
+
   //! @brief The I2C hal.
   I2C* m_i2c;
 
@@ -60,11 +96,11 @@ class Runtime {
   //! @brief The HTTP server.
   HTTPServer* m_http_server;
 
-  //! @brief The HTTP client for data upload.
-  HTTPClient* m_upload_data_http_client;
+  //! @brief The HTTP client.
+  HTTPClient* m_http_client;
 
-  //! @brief The HTTP client for data download.
-  HTTPClient* m_download_data_http_client;
+  //! @brief The network service.
+  NetworkService* m_network_service;
 
   //! @brief The registration portal.
   RegistrationPortal* m_registration_portal;
@@ -84,6 +120,15 @@ class Runtime {
   //! @brief The authentication service.
   AuthenticationService* m_authentication_service;
 
+  //! @brief The flash storage of the sample buffer.
+  SampleStorage* m_sample_storage;
+
+  //! @brief The buffer of samples to upload.
+  SampleBuffer* m_sample_buffer;
+
+  //! @brief The BSEC service.
+  BsecService* m_bsec_service;
+
   //! @brief The data service.
   DataService* m_data_service;
 
@@ -4,8 +4,9 @@
 #include "main/logger/logger.h"
 
 AuthenticationService::AuthenticationService(
-    HTTPClient *http_client, NonVolatileStorage *non_volatile_storage)
-    : m_http_client(http_client), m_non_volatile_storage(non_volatile_storage) {
+    NetworkService *network_service, NonVolatileStorage *non_volatile_storage)
+    : m_network_service(network_service),
+      m_non_volatile_storage(non_volatile_storage) {
   Logger::info("Initializing authentication service...");
   loadAuthenticationToken();
   Logger::info("Finished initializing authentication service");
@@ -16,7 +17,8 @@ AuthenticationService::~AuthenticationService() {}
 bool AuthenticationService::authenticate(const std::string &temp_token) {
   const std::string body = "{\"code\":\"" + temp_token + "\"}";
 
-  auto response = m_http_client->postJSON(API_BASE_URL "/devices/login", body);
+  auto response = m_network_service->postAndWait(
+      API_BASE_URL "/devices/login", body, "", PRIORITY_AUTH);
   Logger::info("Response: " + response.response_content);
 
   if (response.httpStatusCode != 200) {
@@ -2,15 +2,15 @@
 
 #include <string>
 
-#include "main/hal/http_client/http_client.h"
 #include "main/hal/non_volatile_storage/non_volatile_storage.h"
+#include "main/service/network_service/network_service.h"
 
 class AuthenticationService {
  public:
   //! @brief Constructor
-  //! @param http_client The http client
+  //! @param network_service The network service
   //! @param non_volatile_storage The non volatile storage
-  AuthenticationService(HTTPClient* http_client,
+  AuthenticationService(NetworkService* network_service,
                         NonVolatileStorage* non_volatile_storage);
 
   //! @brief Destructor
@@ -38,8 +38,8 @@ class AuthenticationService {
   //! @brief Load the authentication token from the non volatile storage
   void loadAuthenticationToken();
 
-  //! @brief Pointer to the http client
-  HTTPClient* m_http_client;
+  //! @brief Pointer to the network service
+  NetworkService* m_network_service;
 
   //! @brief Pointer to the non volatile storage
   NonVolatileStorage* m_non_volatile_storage;
@@ -0,0 +1,305 @@
+#include "main/service/bsec_service/bsec_service.h"
+
+#include "esp_timer.h"
+#include "main/config.h"
+#include "main/logger/logger.h"
+
+BsecService::BsecService(BME680* bme680,
+                         NonVolatileStorage* non_volatile_storage)
+    : m_bme680(bme680),
+      m_non_volatile_storage(non_volatile_storage),
+      m_output{},
+      m_output_valid(false),
+      m_samples_since_save(0),
+      m_running(false),
+      m_stop_requested(false),
+      m_task_stopped(xSemaphoreCreateBinary()),
+      m_bsec_task_handle(NULL),
+      m_mutex(xSemaphoreCreateMutex()) {}
+
+BsecService::~BsecService() { stopBsecTask(); }
+
+bool BsecService::startBsecTask() {
+  Logger::info("Starting BSEC task...");
+  if (m_bsec_task_handle != NULL) {
+    Logger::error("BSEC task already running");
+    return false;
+  }
+
+  if (!init()) {
+    return false;
+  }
+
+  xTaskCreate(
+      [](void* bsec_service_ptr) {
+        BsecService* bsec_service = (BsecService*)bsec_service_ptr;
+
+        while (!bsec_service->m_stop_requested) {
+          // the library returns the time of its next call, it has to be met
+          // for the selected sample rate
+          const int64_t timestamp = getTimestamp();
+          bsec_bme_settings_t settings = {};
+          const bsec_library_return_t status =
+              bsec_sensor_control(timestamp, &settings);
+          if (status < BSEC_OK) {
+            Logger::error("BSEC sensor control failed: " +
+                          std::to_string(status));
+          } else if (status > BSEC_OK) {
+            Logger::warn("BSEC sensor control warning: " +
+                         std::to_string(status));
+          }
+
+          if (status >= BSEC_OK && settings.trigger_measurement &&
+              bsec_service->measure(settings)) {
+            bsec_service->process(settings.process_data, timestamp);
+          }
+
+          // sleep until the next call, rounded up to full ticks because an
+          // early call violates the timing of the library, only a stop
+          // request wakes the task earlier
+          const int64_t wait_us = (settings.next_call - getTimestamp()) / 1000;
+          const int64_t tick_us = portTICK_PERIOD_MS * 1000;
+          const TickType_t ticks =
+              wait_us > 0 ? (wait_us + tick_us - 1) / tick_us : 1;
+          ulTaskNotifyTake(pdTRUE, ticks);
+        }
+
+        xSemaphoreGive(bsec_service->m_task_stopped);
+        vTaskDelete(NULL);
+      },
+      "bsec_task", 8192, this, 5, &m_bsec_task_handle);
+  m_running = true;
+  Logger::info("Finished starting BSEC task");
+  return true;
+}
+
+bool BsecService::stopBsecTask() {
+  if (m_bsec_task_handle == NULL) {
+    Logger::info("BSEC task not running");
+    return true;
+  }
+
+  // deleting the task could interrupt it inside the library, it exits at the
+  // end of its iteration instead
+  m_stop_requested = true;
+  xTaskNotifyGive(m_bsec_task_handle);
+  xSemaphoreTake(m_task_stopped, portMAX_DELAY);
+  m_bsec_task_handle = NULL;
+  m_running = false;
+  m_stop_requested = false;
+  saveState();
+  return true;
+}
+
+bool BsecService::isRunning() { return m_running; }
+
+bool BsecService::getOutput(BsecOutput* output) {
+  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
+    const bool valid = m_output_valid;
+    if (valid) {
+      *output = m_output;
+    }
+    xSemaphoreGive(m_mutex);
+    return valid;
+  }
+  Logger::error("Failed to take mutex lock for getting BSEC output");
+  return false;
+}
+
+bool BsecService::init() {
+  bsec_library_return_t status = bsec_init();
+  if (status != BSEC_OK) {
+    Logger::error("Failed to initialize BSEC: " + std::to_string(status));
+    return false;
+  }
+
+  loadState();
+
+  const bsec_sensor_configuration_t requested_outputs[] = {
+      {.sample_rate = BSEC_SAMPLE_RATE, .sensor_id = BSEC_OUTPUT_IAQ},
+      {.sample_rate = BSEC_SAMPLE_RATE,
+       .sensor_id = BSEC_OUTPUT_CO2_EQUIVALENT},
+      {.sample_rate = BSEC_SAMPLE_RATE,
+       .sensor_id = BSEC_OUTPUT_BREATH_VOC_EQUIVALENT},
+      {.sample_rate = BSEC_SAMPLE_RATE,
+       .sensor_id = BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE},
+      {.sample_rate = BSEC_SAMPLE_RATE,
+       .sensor_id = BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY},
+      {.sample_rate = BSEC_SAMPLE_RATE,
+       .sensor_id = BSEC_OUTPUT_RAW_PRESSURE},
+      {.sample_rate = BSEC_SAMPLE_RATE, .sensor_id = BSEC_OUTPUT_RAW_GAS}};
+  bsec_sensor_configuration_t required_settings[BSEC_MAX_PHYSICAL_SENSOR];
+  uint8_t n_required_settings = BSEC_MAX_PHYSICAL_SENSOR;
+
+  status = bsec_update_subscription(
+      requested_outputs,
+      sizeof(requested_outputs) / sizeof(requested_outputs[0]),
+      required_settings, &n_required_settings);
+  if (status != BSEC_OK) {
+    Logger::error("Failed to subscribe to BSEC outputs: " +
+                  std::to_string(status));
+    return false;
+  }
+  return true;
+}
+
+bool BsecService::measure(const bsec_bme_settings_t& settings) {
+  // the IAQ solution only uses forced mode measurements
+  if (settings.op_mode != BME68X_FORCED_MODE) {
+    Logger::warn("Unsupported BSEC operation mode: " +
+                 std::to_string(settings.op_mode));
+    return false;
+  }
+
+  if (!m_bme680->setOversampling(settings.temperature_oversampling,
+                                 settings.pressure_oversampling,
+                                 settings.humidity_oversampling)) {
+    Logger::error("Failed to set BSEC oversampling");
+    return false;
+  }
+
+  const uint16_t temperature = settings.run_gas ? settings.heater_temperature
+                                                : 0;
+  const uint16_t duration = settings.run_gas ? settings.heater_duration : 0;
+  if (!m_bme680->setHeaterProfile(BME68X_FORCED_MODE, &temperature, &duration,
+                                  1)) {
+    Logger::error("Failed to set BSEC heater profile");
+    return false;
+  }
+
+  if (m_bme680->beginReading() == 0) {
+    return false;
+  }
+
+  BME680::ReadingState state;
+  while (true) {
+    const int remaining_millis = m_bme680->remainingReadingMillis();
+    if (remaining_millis > 0) {
+      vTaskDelay(pdMS_TO_TICKS(remaining_millis) + 1);
+    }
+    state = m_bme680->pollReading();
+    if (state != BME680::READING_PENDING) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+  return state == BME680::READING_DONE;
+}
+
+void BsecService::process(uint32_t process_data, int64_t timestamp) {
+  bsec_input_t inputs[BSEC_MAX_PHYSICAL_SENSOR];
+  uint8_t n_inputs = 0;
+
+  const auto add_input = [&](uint8_t sensor_id, float signal) {
+    inputs[n_inputs].time_stamp = timestamp;
+    inputs[n_inputs].signal = signal;
+    inputs[n_inputs].signal_dimensions = 1;
+    inputs[n_inputs].sensor_id = sensor_id;
+    n_inputs++;
+  };
+
+  if (process_data & BSEC_PROCESS_TEMPERATURE) {
+    add_input(BSEC_INPUT_TEMPERATURE, m_bme680->getTemperature());
+    add_input(BSEC_INPUT_HEATSOURCE, BSEC_TEMPERATURE_OFFSET);
+  }
+  if (process_data & BSEC_PROCESS_HUMIDITY) {
+    add_input(BSEC_INPUT_HUMIDITY, m_bme680->getHumidity());
+  }
+  if (process_data & BSEC_PROCESS_PRESSURE) {
+    add_input(BSEC_INPUT_PRESSURE, m_bme680->getPressure());
+  }
+  // the driver reports 0 if the gas measurement was not valid
+  const uint32_t gas_resistance = m_bme680->getGas();
+  if ((process_data & BSEC_PROCESS_GAS) && gas_resistance != 0) {
+    add_input(BSEC_INPUT_GASRESISTOR, gas_resistance);
+  }
+
+  bsec_output_t outputs[BSEC_NUMBER_OUTPUTS];
+  uint8_t n_outputs = BSEC_NUMBER_OUTPUTS;
+  const bsec_library_return_t status =
+      bsec_do_steps(inputs, n_inputs, outputs, &n_outputs);
+  if (status != BSEC_OK) {
+    Logger::error("BSEC processing failed: " + std::to_string(status));
+    return;
+  }
+
+  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
+    for (uint8_t i = 0; i < n_outputs; i++) {
+      const float signal = outputs[i].signal;
+      switch (outputs[i].sensor_id) {
+        case BSEC_OUTPUT_IAQ:
+          m_output.iaq = signal;
+          m_output.iaq_accuracy = outputs[i].accuracy;
+          m_output_valid = true;
+          break;
+        case BSEC_OUTPUT_CO2_EQUIVALENT:
+          m_output.co2_equivalent = signal;
+          break;
+        case BSEC_OUTPUT_BREATH_VOC_EQUIVALENT:
+          m_output.breath_voc_equivalent = signal;
+          break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_TEMPERATURE:
+          m_output.temperature = signal;
+          break;
+        case BSEC_OUTPUT_SENSOR_HEAT_COMPENSATED_HUMIDITY:
+          m_output.humidity = signal;
+          break;
+        case BSEC_OUTPUT_RAW_PRESSURE:
+          m_output.pressure = signal;
+          break;
+        case BSEC_OUTPUT_RAW_GAS:
+          m_output.gas_resistance = static_cast<uint32_t>(signal);
+          break;
+        default:
+          break;
+      }
+    }
+    xSemaphoreGive(m_mutex);
+  } else {
+    Logger::error("Failed to take mutex lock for setting BSEC output");
+  }
+
+  if (++m_samples_since_save >= BSEC_STATE_SAVE_INTERVAL) {
+    saveState();
+  }
+}
+
+void BsecService::loadState() {
+  uint8_t state[BSEC_MAX_STATE_BLOB_SIZE];
+  size_t length = sizeof(state);
+  if (!m_non_volatile_storage->getBlob(STORAGE_USERCONFIG, KEY_BSECSTATE,
+                                       state, &length) ||
+      length == 0) {
+    Logger::info("No BSEC state stored, starting uncalibrated");
+    return;
+  }
+
+  const bsec_library_return_t status = bsec_set_state(
+      state, length, m_work_buffer, sizeof(m_work_buffer));
+  if (status != BSEC_OK) {
+    Logger::warn("Failed to restore BSEC state: " + std::to_string(status));
+    return;
+  }
+  Logger::info("Restored BSEC state");
+}
+
+void BsecService::saveState() {
+  m_samples_since_save = 0;
+
+  uint8_t state[BSEC_MAX_STATE_BLOB_SIZE];
+  uint32_t length = 0;
+  const bsec_library_return_t status =
+      bsec_get_state(0, state, sizeof(state), m_work_buffer,
+                     sizeof(m_work_buffer), &length);
+  if (status != BSEC_OK) {
+    Logger::error("Failed to get BSEC state: " + std::to_string(status));
+    return;
+  }
+
+  if (!m_non_volatile_storage->setBlob(STORAGE_USERCONFIG, KEY_BSECSTATE,
+                                       state, length)) {
+    Logger::error("Failed to persist BSEC state");
+  }
+}
+
+int64_t BsecService::getTimestamp() { return esp_timer_get_time() * 1000; }
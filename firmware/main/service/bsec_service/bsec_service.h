@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "main/driver/bme680/bme680.h"
+#include "main/driver/bme680/libs/bsec_interface.h"
+#include "main/hal/non_volatile_storage/non_volatile_storage.h"
+
+//! @brief The air quality estimated by the BSEC library
+//! @note The estimates are NAN until BSEC output them for the first time.
+struct BsecOutput {
+  //! @brief The indoor air quality index from 0 to 500
+  float iaq = NAN;
+  //! @brief The accuracy of the index from 0 (unreliable) to 3 (calibrated)
+  uint8_t iaq_accuracy = 0;
+  //! @brief The CO2 equivalent in ppm
+  float co2_equivalent = NAN;
+  //! @brief The breath VOC equivalent in ppm
+  float breath_voc_equivalent = NAN;
+  //! @brief The temperature compensated for self heating in degrees celsius
+  float temperature = 0;
+  //! @brief The humidity compensated for self heating in percent
+  float humidity = 0;
+  //! @brief The pressure in pascal
+  float pressure = 0;
+  //! @brief The gas resistance in ohm
+  uint32_t gas_resistance = 0;
+};
+
+//! @brief Service that runs the BSEC library on the BME680 measurements
+//! @note BSEC decides when the sensor is measured, the task sleeps until the
+//! next call it requests instead of a fixed interval. The library state holds
+//! the calibration of the sensor and is persisted, so the calibration
+//! survives a reboot. While the service runs it owns the sensor, no other
+//! measurements must be started.
+class BsecService {
+ public:
+  //! @brief Constructor
+  //! @param bme680 The BME680 driver
+  //! @param non_volatile_storage The non volatile storage to persist the
+  //! library state
+  BsecService(BME680* bme680, NonVolatileStorage* non_volatile_storage);
+
+  //! @brief Destructor
+  ~BsecService();
+
+  //! @brief Initialize the library and start the BSEC task
+  //! @return True if the task was started, false otherwise
+  bool startBsecTask();
+
+  //! @brief Stop the BSEC task and persist the library state
+  //! @note Waits until the task finished its current iteration, which
+  //! includes a running measurement, so the state is never read while the
+  //! task uses the library
+  bool stopBsecTask();
+
+  //! @brief Check if the BSEC task is running
+  //! @return True if the task is running, false otherwise
+  bool isRunning();
+
+  //! @brief Get the latest air quality estimate
+  //! @param output The output to store the estimate in
+  //! @return True if an estimate is available, false otherwise
+  bool getOutput(BsecOutput* output);
+
+ private:
+  //! @brief Initialize the library, restore its state and subscribe to the
+  //! outputs
+  //! @return True if successful, false otherwise
+  bool init();
+
+  //! @brief Run the measurement requested by the library
+  //! @param settings The sensor settings returned by bsec_sensor_control
+  //! @return True if successful, false otherwise
+  bool measure(const bsec_bme_settings_t& settings);
+
+  //! @brief Pass the measurement to the library and store its outputs
+  //! @param process_data The inputs requested by the library
+  //! @param timestamp The time of the measurement in nanoseconds
+  void process(uint32_t process_data, int64_t timestamp);
+
+  //! @brief Restore the library state from the non volatile storage
+  void loadState();
+
+  //! @brief Persist the library state in the non volatile storage
+  void saveState();
+
+  //! @brief Get the current time for the library
+  //! @return The time since boot in nanoseconds
+  static int64_t getTimestamp();
+
+  //! @brief Pointer to the BME680 driver
+  BME680* m_bme680;
+
+  //! @brief Pointer to the non volatile storage
+  NonVolatileStorage* m_non_volatile_storage;
+
+  //! @brief The latest air quality estimate
+  BsecOutput m_output;
+
+  //! @brief Flag if an estimate is available
+  bool m_output_valid;
+
+  //! @brief Number of processed samples since the state was persisted
+  uint32_t m_samples_since_save;
+
+  //! @brief Work buffer of the library state functions
+  uint8_t m_work_buffer[BSEC_MAX_WORKBUFFER_SIZE];
+
+  //! @brief Flag if the BSEC task is running
+  std::atomic<bool> m_running;
+
+  //! @brief Flag to ask the BSEC task to exit after its current iteration
+  std::atomic<bool> m_stop_requested;
+
+  //! @brief Given by the BSEC task right before it deletes itself
+  SemaphoreHandle_t m_task_stopped;
+
+  //! @brief The BSEC task handle
+  TaskHandle_t m_bsec_task_handle;
+
+  //! @brief Mutex to protect the air quality estimate
+  SemaphoreHandle_t m_mutex;
+};
@@ -0,0 +1,120 @@
+#include "main/service/data_download_service/air_quality_cbor_decoder.h"
+
+#include <cmath>
+#include <string>
+#include <string_view>
+
+#include "main/libs/cbor/cbor.h"
+#include "main/logger/logger.h"
+
+bool AirQualityCborDecoder::decode(const uint8_t* data, size_t size,
+                                   AirQualityStore* air_quality_data) {
+  air_quality_data->clear();
+  CborReader reader(data, size);
+
+  size_t count;
+  if (!reader.readArray(&count)) {
+    Logger::error("Error: Expected an array");
+    return false;
+  }
+
+  uint32_t dropped = 0;
+  for (uint32_t index = 0; index < count; index++) {
+    size_t fields;
+    if (!reader.readMap(&fields)) {
+      Logger::error("Wrong data format");
+      return false;
+    }
+
+    AirQualityData element = {};
+    element.iaq = NAN;
+    element.co2_equivalent = NAN;
+    element.breath_voc_equivalent = NAN;
+    bool has_id = false;
+    bool has_device = false;
+    uint8_t numbers = 0;
+    for (size_t field = 0; field < fields; field++) {
+      const char* key;
+      size_t key_length;
+      if (!reader.readString(&key, &key_length)) {
+        Logger::error("Wrong data format");
+        return false;
+      }
+      const std::string_view name(key, key_length);
+
+      double value;
+      bool ok = true;
+      if (name == "id") {
+        const char* id;
+        size_t id_length;
+        ok = reader.readString(&id, &id_length);
+        if (ok) {
+          element.device_id = std::string_view(id, id_length);
+          has_id = true;
+        }
+      } else if (name == "device") {
+        const char* device;
+        size_t device_length;
+        ok = reader.readString(&device, &device_length);
+        if (ok) {
+          element.device_name = std::string_view(device, device_length);
+          has_device = true;
+        }
+      } else if (name == "humidity") {
+        ok = reader.readNumber(&value);
+        element.humidity = static_cast<float>(value);
+        numbers++;
+      } else if (name == "pressure") {
+        ok = reader.readNumber(&value);
+        element.pressure = static_cast<uint32_t>(value);
+        numbers++;
+      } else if (name == "temperature") {
+        ok = reader.readNumber(&value);
+        element.temperature = static_cast<float>(value);
+        numbers++;
+      } else if (name == "gasResistance") {
+        ok = reader.readNumber(&value);
+        element.gas_resistance = static_cast<uint32_t>(value);
+        numbers++;
+      } else if (name == "iaq") {
+        ok = reader.readNullableNumber(&value);
+        element.iaq = static_cast<float>(value);
+      } else if (name == "co2Equivalent") {
+        ok = reader.readNullableNumber(&value);
+        element.co2_equivalent = static_cast<float>(value);
+      } else if (name == "breathVocEquivalent") {
+        ok = reader.readNullableNumber(&value);
+        element.breath_voc_equivalent = static_cast<float>(value);
+      } else {
+        ok = reader.skip();
+      }
+
+      if (!ok) {
+        Logger::error("Wrong data format");
+        return false;
+      }
+    }
+
+    if (!has_device || numbers != 4) {
+      Logger::error("Wrong data format");
+      return false;
+    }
+    // without an id the device is keyed by its name
+    if (!has_id) {
+      element.device_id = element.device_name;
+    }
+    if (!air_quality_data->add(
+            element.device_id, element.device_name, element.temperature,
+            element.humidity, element.pressure, element.gas_resistance,
+            element.iaq, element.co2_equivalent,
+            element.breath_voc_equivalent)) {
+      dropped++;
+    }
+  }
+
+  if (dropped > 0) {
+    Logger::warn("Dropped air quality data of " + std::to_string(dropped) +
+                 " devices");
+  }
+  return reader.atEnd();
+}
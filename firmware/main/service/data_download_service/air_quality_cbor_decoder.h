@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "main/service/data_download_service/air_quality_store.h"
+
+//! @brief Decoder for the CBOR array of the /sensors/latest endpoint
+//! @note The response is decoded in place, only the device names are copied
+//! into the store.
+class AirQualityCborDecoder {
+ public:
+  //! @brief Decode a complete response
+  //! @param data The response content
+  //! @param size The size of the content in bytes
+  //! @param air_quality_data The store to add the air quality data to, it is
+  //! cleared first
+  //! @return True if the content was decoded successfully, false otherwise
+  static bool decode(const uint8_t* data, size_t size,
+                     AirQualityStore* air_quality_data);
+
+ private:
+  //! @brief Private constructor to prevent instantiation.
+  AirQualityCborDecoder();
+};
@@ -0,0 +1,182 @@
+#include "main/service/data_download_service/air_quality_json_decoder.h"
+
+#include <cmath>
+#include <string_view>
+
+#include "main/logger/logger.h"
+
+AirQualityJsonDecoder::AirQualityJsonDecoder()
+    : m_parser(this),
+      m_air_quality_data(nullptr),
+      m_element{},
+      m_depth(0),
+      m_field(FIELD_NONE),
+      m_fields_found(0),
+      m_dropped(0),
+      m_invalid(false) {}
+
+void AirQualityJsonDecoder::begin(AirQualityStore* air_quality_data) {
+  m_parser.reset();
+  m_air_quality_data = air_quality_data;
+  m_air_quality_data->clear();
+  m_depth = 0;
+  m_field = FIELD_NONE;
+  m_fields_found = 0;
+  m_dropped = 0;
+  m_invalid = false;
+}
+
+bool AirQualityJsonDecoder::feed(const char* data, size_t length) {
+  if (m_air_quality_data == nullptr) {
+    return false;
+  }
+  return m_parser.feed(data, length) && !m_invalid;
+}
+
+bool AirQualityJsonDecoder::finish() {
+  if (m_air_quality_data == nullptr) {
+    return false;
+  }
+  if (!m_parser.finish()) {
+    Logger::error("Invalid json");
+    return false;
+  }
+  if (m_invalid) {
+    Logger::error("Wrong data format");
+    return false;
+  }
+  if (m_dropped > 0) {
+    Logger::warn("Dropped air quality data of " + std::to_string(m_dropped) +
+                 " devices");
+  }
+  return true;
+}
+
+void AirQualityJsonDecoder::onStartObject() {
+  // the elements of the top level array are the only expected objects
+  if (++m_depth != 2) {
+    m_invalid = true;
+    return;
+  }
+  m_fields_found = 0;
+  m_field = FIELD_NONE;
+  m_element = AirQualityData{};
+  m_element.iaq = NAN;
+  m_element.co2_equivalent = NAN;
+  m_element.breath_voc_equivalent = NAN;
+  m_device_id.clear();
+  m_device_name.clear();
+}
+
+void AirQualityJsonDecoder::onEndObject() {
+  if (m_depth-- != 2) {
+    return;
+  }
+  if ((m_fields_found & FIELDS_REQUIRED) != FIELDS_REQUIRED) {
+    m_invalid = true;
+    return;
+  }
+  // without an id the device is keyed by its name
+  const std::string& device_id =
+      (m_fields_found & FIELD_ID) ? m_device_id : m_device_name;
+  if (!m_air_quality_data->add(device_id, m_device_name,
+                               m_element.temperature, m_element.humidity,
+                               m_element.pressure, m_element.gas_resistance,
+                               m_element.iaq, m_element.co2_equivalent,
+                               m_element.breath_voc_equivalent)) {
+    m_dropped++;
+  }
+}
+
+void AirQualityJsonDecoder::onStartArray() {
+  if (++m_depth != 1) {
+    m_invalid = true;
+  }
+}
+
+void AirQualityJsonDecoder::onEndArray() { m_depth--; }
+
+void AirQualityJsonDecoder::onKey(const char* key, size_t length) {
+  const std::string_view name(key, length);
+  if (name == "id") {
+    m_field = FIELD_ID;
+  } else if (name == "device") {
+    m_field = FIELD_DEVICE;
+  } else if (name == "humidity") {
+    m_field = FIELD_HUMIDITY;
+  } else if (name == "pressure") {
+    m_field = FIELD_PRESSURE;
+  } else if (name == "temperature") {
+    m_field = FIELD_TEMPERATURE;
+  } else if (name == "gasResistance") {
+    m_field = FIELD_GAS_RESISTANCE;
+  } else if (name == "iaq") {
+    m_field = FIELD_IAQ;
+  } else if (name == "co2Equivalent") {
+    m_field = FIELD_CO2_EQUIVALENT;
+  } else if (name == "breathVocEquivalent") {
+    m_field = FIELD_BREATH_VOC_EQUIVALENT;
+  } else {
+    m_field = FIELD_NONE;
+  }
+}
+
+void AirQualityJsonDecoder::onString(const char* value, size_t length) {
+  if (m_depth != 2 || m_field == FIELD_NONE) {
+    return;
+  }
+  if (m_field == FIELD_ID) {
+    m_device_id.assign(value, length);
+  } else if (m_field == FIELD_DEVICE) {
+    m_device_name.assign(value, length);
+  } else {
+    m_invalid = true;
+    return;
+  }
+  m_fields_found |= m_field;
+}
+
+void AirQualityJsonDecoder::onNumber(double value) {
+  if (m_depth != 2 || m_field == FIELD_NONE) {
+    return;
+  }
+
+  AirQualityData& data = m_element;
+  switch (m_field) {
+    case FIELD_HUMIDITY:
+      data.humidity = static_cast<float>(value);
+      break;
+    case FIELD_PRESSURE:
+      data.pressure = static_cast<uint32_t>(value);
+      break;
+    case FIELD_TEMPERATURE:
+      data.temperature = static_cast<float>(value);
+      break;
+    case FIELD_GAS_RESISTANCE:
+      data.gas_resistance = static_cast<uint32_t>(value);
+      break;
+    case FIELD_IAQ:
+      data.iaq = static_cast<float>(value);
+      break;
+    case FIELD_CO2_EQUIVALENT:
+      data.co2_equivalent = static_cast<float>(value);
+      break;
+    case FIELD_BREATH_VOC_EQUIVALENT:
+      data.breath_voc_equivalent = static_cast<float>(value);
+      break;
+    default:
+      m_invalid = true;
+      return;
+  }
+  m_fields_found |= m_field;
+}
+
+void AirQualityJsonDecoder::onLiteral(bool /* value */) {
+  // null or boolean values are not expected for the known fields, except a
+  // missing air quality estimate
+  if (m_depth == 2 && m_field != FIELD_NONE && m_field != FIELD_IAQ &&
+      m_field != FIELD_CO2_EQUIVALENT &&
+      m_field != FIELD_BREATH_VOC_EQUIVALENT) {
+    m_invalid = true;
+  }
+}
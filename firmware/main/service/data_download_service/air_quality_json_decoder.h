@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "main/libs/json_stream/json_stream.h"
+#include "main/service/data_download_service/air_quality_store.h"
+
+//! @brief Streaming decoder for the json array of the /sensors/latest endpoint
+//! @note The response is decoded chunk by chunk while it is received, every
+//! completed array element is added to the output store.
+class AirQualityJsonDecoder : public JsonStreamHandler {
+ public:
+  //! @brief Constructor
+  AirQualityJsonDecoder();
+
+  //! @brief Start decoding a new response
+  //! @param air_quality_data The store to add the decoded air quality data to
+  void begin(AirQualityStore* air_quality_data);
+
+  //! @brief Decode the next chunk of the response
+  //! @param data The chunk
+  //! @param length The length of the chunk
+  //! @return True if the response is valid so far, false otherwise
+  bool feed(const char* data, size_t length);
+
+  //! @brief Finish decoding after the last chunk
+  //! @return True if the complete response was decoded, false otherwise
+  bool finish();
+
+  void onStartObject() override;
+  void onEndObject() override;
+  void onStartArray() override;
+  void onEndArray() override;
+  void onKey(const char* key, size_t length) override;
+  void onString(const char* value, size_t length) override;
+  void onNumber(double value) override;
+  void onLiteral(bool value) override;
+
+ private:
+  //! @brief The fields of an air quality data element
+  enum Field {
+    FIELD_NONE = 0,
+    FIELD_DEVICE = 1,
+    FIELD_HUMIDITY = 2,
+    FIELD_PRESSURE = 4,
+    FIELD_TEMPERATURE = 8,
+    FIELD_GAS_RESISTANCE = 16,
+    FIELD_ID = 32,
+    FIELD_IAQ = 64,
+    FIELD_CO2_EQUIVALENT = 128,
+    FIELD_BREATH_VOC_EQUIVALENT = 256
+  };
+
+  //! @brief All fields that an element must contain
+  //! @note Without an id the device is keyed by its name, the air quality
+  //! estimates are only sent for devices running BSEC
+  static constexpr uint16_t FIELDS_REQUIRED =
+      FIELD_DEVICE | FIELD_HUMIDITY | FIELD_PRESSURE | FIELD_TEMPERATURE |
+      FIELD_GAS_RESISTANCE;
+
+  //! @brief The json parser
+  JsonStreamParser m_parser;
+
+  //! @brief The store to add the decoded air quality data to
+  AirQualityStore* m_air_quality_data;
+
+  //! @brief The air quality data of the current element
+  AirQualityData m_element;
+
+  //! @brief The device id of the current element
+  std::string m_device_id;
+
+  //! @brief The device name of the current element
+  std::string m_device_name;
+
+  //! @brief The current nesting depth
+  uint8_t m_depth;
+
+  //! @brief The field of the current key
+  Field m_field;
+
+  //! @brief The fields found in the current element
+  uint16_t m_fields_found;
+
+  //! @brief The number of elements that did not fit into the store
+  uint32_t m_dropped;
+
+  //! @brief Flag if the response has an unexpected format
+  bool m_invalid;
+};
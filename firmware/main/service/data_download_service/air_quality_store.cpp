@@ -0,0 +1,155 @@
+#include "main/service/data_download_service/air_quality_store.h"
+
+#include <cstring>
+#include <utility>
+
+AirQualityStore::AirQualityStore() : m_size(0), m_names_size(0) {}
+
+void AirQualityStore::clear() {
+  m_size = 0;
+  m_names_size = 0;
+}
+
+bool AirQualityStore::add(std::string_view device_id,
+                          std::string_view device_name, float temperature,
+                          float humidity, uint32_t pressure,
+                          uint32_t gas_resistance, float iaq,
+                          float co2_equivalent, float breath_voc_equivalent) {
+  // ids and names longer than the length field are truncated
+  device_id = device_id.substr(0, UINT8_MAX);
+  device_name = device_name.substr(0, UINT8_MAX);
+  const uint32_t device_key = getDeviceKey(device_id);
+  if (m_size == AIR_QUALITY_STORE_CAPACITY ||
+      find(device_key, device_id) >= 0) {
+    return false;
+  }
+
+  // an id interned before the name did not fit is removed again
+  const uint16_t names_size = m_names_size;
+  uint16_t id_offset;
+  uint16_t name_offset;
+  if (!intern(device_id, &id_offset) || !intern(device_name, &name_offset)) {
+    m_names_size = names_size;
+    return false;
+  }
+
+  m_device_keys[m_size] = device_key;
+  m_id_offsets[m_size] = id_offset;
+  m_id_lengths[m_size] = device_id.size();
+  m_name_offsets[m_size] = name_offset;
+  m_name_lengths[m_size] = device_name.size();
+  m_temperatures[m_size] = temperature;
+  m_humidities[m_size] = humidity;
+  m_pressures[m_size] = pressure;
+  m_gas_resistances[m_size] = gas_resistance;
+  m_iaqs[m_size] = iaq;
+  m_co2_equivalents[m_size] = co2_equivalent;
+  m_breath_voc_equivalents[m_size] = breath_voc_equivalent;
+  m_size++;
+  return true;
+}
+
+void AirQualityStore::keepOrderOf(const AirQualityStore& previous) {
+  // move the devices of the previous store to the front, the name table is
+  // shared, so only the per device arrays are permuted
+  size_t ordered = 0;
+  for (size_t i = 0; i < previous.m_size && ordered < m_size; i++) {
+    const int index = find(previous.m_device_keys[i], previous.getId(i));
+    if (index < 0 || (size_t)index < ordered) {
+      continue;
+    }
+
+    // rotate the device at index to position ordered, so the new devices
+    // behind it keep their order
+    for (size_t j = index; j > ordered; j--) {
+      std::swap(m_device_keys[j], m_device_keys[j - 1]);
+      std::swap(m_id_offsets[j], m_id_offsets[j - 1]);
+      std::swap(m_id_lengths[j], m_id_lengths[j - 1]);
+      std::swap(m_name_offsets[j], m_name_offsets[j - 1]);
+      std::swap(m_name_lengths[j], m_name_lengths[j - 1]);
+      std::swap(m_temperatures[j], m_temperatures[j - 1]);
+      std::swap(m_humidities[j], m_humidities[j - 1]);
+      std::swap(m_pressures[j], m_pressures[j - 1]);
+      std::swap(m_gas_resistances[j], m_gas_resistances[j - 1]);
+      std::swap(m_iaqs[j], m_iaqs[j - 1]);
+      std::swap(m_co2_equivalents[j], m_co2_equivalents[j - 1]);
+      std::swap(m_breath_voc_equivalents[j], m_breath_voc_equivalents[j - 1]);
+    }
+    ordered++;
+  }
+}
+
+AirQualityData AirQualityStore::get(size_t index) const {
+  return {.device_key = m_device_keys[index],
+          .device_id = getId(index),
+          .device_name = getName(index),
+          .temperature = m_temperatures[index],
+          .humidity = m_humidities[index],
+          .pressure = m_pressures[index],
+          .gas_resistance = m_gas_resistances[index],
+          .iaq = m_iaqs[index],
+          .co2_equivalent = m_co2_equivalents[index],
+          .breath_voc_equivalent = m_breath_voc_equivalents[index]};
+}
+
+int AirQualityStore::find(std::string_view device_id) const {
+  device_id = device_id.substr(0, UINT8_MAX);
+  return find(getDeviceKey(device_id), device_id);
+}
+
+int AirQualityStore::find(uint32_t device_key,
+                          std::string_view device_id) const {
+  // the key rules out most devices, the id tells apart the devices whose ids
+  // share a key
+  for (size_t i = 0; i < m_size; i++) {
+    if (m_device_keys[i] == device_key && getId(i) == device_id) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+std::string_view AirQualityStore::getId(size_t index) const {
+  return std::string_view(m_names + m_id_offsets[index], m_id_lengths[index]);
+}
+
+std::string_view AirQualityStore::getName(size_t index) const {
+  return std::string_view(m_names + m_name_offsets[index],
+                          m_name_lengths[index]);
+}
+
+size_t AirQualityStore::size() const { return m_size; }
+
+bool AirQualityStore::empty() const { return m_size == 0; }
+
+uint32_t AirQualityStore::getDeviceKey(std::string_view device_id) {
+  uint32_t hash = 2166136261u;
+  for (const char c : device_id) {
+    hash ^= (uint8_t)c;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+bool AirQualityStore::intern(std::string_view value, uint16_t* offset) {
+  // devices with the same name share one entry, a device keyed by its name
+  // shares it with its id
+  for (size_t i = 0; i < m_size; i++) {
+    if (getName(i) == value) {
+      *offset = m_name_offsets[i];
+      return true;
+    }
+    if (getId(i) == value) {
+      *offset = m_id_offsets[i];
+      return true;
+    }
+  }
+
+  if (m_names_size + value.size() > AIR_QUALITY_NAME_TABLE_SIZE) {
+    return false;
+  }
+  memcpy(m_names + m_names_size, value.data(), value.size());
+  *offset = m_names_size;
+  m_names_size += value.size();
+  return true;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "main/config.h"
+
+//! @brief The air quality data of a device
+struct AirQualityData {
+  //! @brief The device key, see AirQualityStore::getDeviceKey
+  uint32_t device_key;
+  //! @brief The backend device id, the name if the backend sent none, points
+  //! into the name table of the store
+  std::string_view device_id;
+  //! @brief The device name, points into the name table of the store
+  std::string_view device_name;
+  //! @brief The temperature in degrees celsius
+  float temperature;
+  //! @brief The humidity in percent
+  float humidity;
+  //! @brief The pressure in pascal
+  uint32_t pressure;
+  //! @brief The gas resistance in ohm
+  uint32_t gas_resistance;
+  //! @brief The indoor air quality index, NAN if the device runs no BSEC
+  float iaq;
+  //! @brief The CO2 equivalent in ppm, NAN if the device runs no BSEC
+  float co2_equivalent;
+  //! @brief The breath VOC equivalent in ppm, NAN if the device runs no BSEC
+  float breath_voc_equivalent;
+};
+
+//! @brief Fixed capacity store of the air quality data of all devices
+//! @note The values are kept in one contiguous array per field and the device
+//! ids and names are interned into a single name table, so the store needs no
+//! heap memory. The devices are found by a hash of their backend id, the id
+//! itself is compared on a match, and accessed by their index in O(1).
+class AirQualityStore {
+ public:
+  //! @brief Constructor
+  AirQualityStore();
+
+  //! @brief Remove all devices
+  void clear();
+
+  //! @brief Add the air quality data of a device
+  //! @param device_id The backend device id, copied into the name table
+  //! @param device_name The device name, copied into the name table
+  //! @param temperature The temperature in degrees celsius
+  //! @param humidity The humidity in percent
+  //! @param pressure The pressure in pascal
+  //! @param gas_resistance The gas resistance in ohm
+  //! @param iaq The indoor air quality index, NAN if unknown
+  //! @param co2_equivalent The CO2 equivalent in ppm, NAN if unknown
+  //! @param breath_voc_equivalent The breath VOC equivalent in ppm, NAN if
+  //! unknown
+  //! @return True if the device was added, false if the store is full or the
+  //! device id is already in use
+  bool add(std::string_view device_id, std::string_view device_name,
+           float temperature, float humidity, uint32_t pressure,
+           uint32_t gas_resistance, float iaq, float co2_equivalent,
+           float breath_voc_equivalent);
+
+  //! @brief Sort the devices into the order of a previous store
+  //! @note Devices of the previous store keep their relative order, new
+  //! devices follow in the order they were added. This keeps the index of a
+  //! device stable between downloads.
+  //! @param previous The previous store
+  void keepOrderOf(const AirQualityStore& previous);
+
+  //! @brief Get the air quality data of a device
+  //! @param index The index of the device, must be less than size()
+  //! @return The air quality data, the device name is only valid as long as
+  //! the store
+  AirQualityData get(size_t index) const;
+
+  //! @brief Find a device by its id
+  //! @param device_id The backend device id
+  //! @return The index of the device, -1 if it is not in the store
+  int find(std::string_view device_id) const;
+
+  //! @brief Get the number of devices
+  size_t size() const;
+
+  //! @brief Check if the store contains no devices
+  bool empty() const;
+
+  //! @brief Get the key of a device from its backend id
+  //! @note The key is the 32 bit FNV-1a hash of the id, different ids may
+  //! share a key
+  //! @param device_id The backend device id
+  //! @return The device key
+  static uint32_t getDeviceKey(std::string_view device_id);
+
+ private:
+  //! @brief Find a device by its key and id
+  //! @param device_key The device key of the id
+  //! @param device_id The backend device id
+  //! @return The index of the device, -1 if it is not in the store
+  int find(uint32_t device_key, std::string_view device_id) const;
+
+  //! @brief Get the id of a device
+  //! @param index The index of the device
+  //! @return The id, only valid as long as the store
+  std::string_view getId(size_t index) const;
+
+  //! @brief Get the name of a device
+  //! @param index The index of the device
+  //! @return The name, only valid as long as the store
+  std::string_view getName(size_t index) const;
+
+  //! @brief Intern a string into the name table
+  //! @param value The device id or name
+  //! @param offset The offset of the string in the name table
+  //! @return True if the string was interned, false if the name table is full
+  bool intern(std::string_view value, uint16_t* offset);
+
+  //! @brief The number of devices
+  size_t m_size;
+
+  //! @brief The device keys
+  uint32_t m_device_keys[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The offsets of the device ids in the name table
+  uint16_t m_id_offsets[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The lengths of the device ids
+  uint8_t m_id_lengths[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The offsets of the device names in the name table
+  uint16_t m_name_offsets[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The lengths of the device names
+  uint8_t m_name_lengths[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The temperatures in degrees celsius
+  float m_temperatures[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The humidities in percent
+  float m_humidities[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The pressures in pascal
+  uint32_t m_pressures[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The gas resistances in ohm
+  uint32_t m_gas_resistances[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The indoor air quality indexes
+  float m_iaqs[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The CO2 equivalents in ppm
+  float m_co2_equivalents[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The breath VOC equivalents in ppm
+  float m_breath_voc_equivalents[AIR_QUALITY_STORE_CAPACITY];
+
+  //! @brief The interned device ids and names
+  char m_names[AIR_QUALITY_NAME_TABLE_SIZE];
+
+  //! @brief The used size of the name table
+  uint16_t m_names_size;
+};
+
+//! @brief Immutable snapshot of the cached air quality data
+using AirQualitySnapshot = AirQualityStore;
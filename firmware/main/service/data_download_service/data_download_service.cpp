@@ -1,158 +1,211 @@
 #include "main/service/data_download_service/data_download_service.h"
 
 #include "main/config.h"
-#include "main/hal/timer/timer.h"
-#include "main/libs/cJson/cJSON.h"
+#include "main/libs/cbor/cbor.h"
+#include "main/service/data_download_service/air_quality_cbor_decoder.h"
 
-DataDownloadService::DataDownloadService(HTTPClient *http_client,
+DataDownloadService::DataDownloadService(NetworkService *network_service,
                                          AuthenticationService *auth_service)
-    : m_http_client(http_client),
+    : m_network_service(network_service),
       m_auth_service(auth_service),
-      m_data_download_task_handle(NULL),
+      m_data_download_timer(NULL),
+      m_air_quality_data(std::make_shared<const AirQualitySnapshot>()),
+      m_snapshot_mutex(xSemaphoreCreateMutex()),
+      m_download_pending(false),
+      m_data_version(0),
+      m_new_data_task(NULL),
+      m_body_started(false),
+      m_body_cbor(false),
+      m_body_valid(false),
       m_mutex(xSemaphoreCreateMutex()) {}
 
-DataDownloadService::~DataDownloadService() {}
+DataDownloadService::~DataDownloadService() { stopDataDownloadTask(); }
 
 bool DataDownloadService::startDataDownloadTask() {
   Logger::info("Starting data download task...");
-  if (m_data_download_task_handle != NULL) {
-    Logger::error("Data upload task already running");
+  if (m_data_download_timer != NULL) {
+    Logger::error("Data download task already running");
     return false;
   }
 
-  // create task for sendAirQualityData
-  xTaskCreate(
-      [](void *data_download_service_ptr) {
-        DataDownloadService *data_download_service =
-            (DataDownloadService *)data_download_service_ptr;
-        while (true) {
-          if (!data_download_service->downloadAirQualityData()) {
-            Logger::error("Failed to download air quality data");
-          }
-          Timer::sleepMS(30000);
-        }
-      },
-      "data_download_task", 8192, this, 5, &m_data_download_task_handle);
+  // the download runs on the network task, the timer only queues it
+  const esp_timer_create_args_t timer_args = {
+      .callback =
+          [](void *data_download_service_ptr) {
+            DataDownloadService *data_download_service =
+                (DataDownloadService *)data_download_service_ptr;
+            if (!data_download_service->downloadAirQualityData()) {
+              Logger::error("Failed to download air quality data");
+            }
+          },
+      .arg = this,
+      .name = "data_download_timer"};
+
+  if (esp_timer_create(&timer_args, &m_data_download_timer) != ESP_OK) {
+    Logger::error("Failed to create data download timer");
+    m_data_download_timer = NULL;
+    return false;
+  }
+
+  downloadAirQualityData();
+  esp_timer_start_periodic(m_data_download_timer, 30000000);
   Logger::info("Finished starting data download task");
   return true;
 }
 
 bool DataDownloadService::stopDataDownloadTask() {
-  if (m_data_download_task_handle == NULL) {
+  if (m_data_download_timer == NULL) {
     Logger::info("Data download task not running");
     return true;
   }
 
-  vTaskDelete(m_data_download_task_handle);
-  m_data_download_task_handle = NULL;
+  esp_timer_stop(m_data_download_timer);
+  esp_timer_delete(m_data_download_timer);
+  m_data_download_timer = NULL;
   return true;
 }
 
-std::map<uint32_t, AirQualityData> DataDownloadService::getAirQualityData() {
-  std::map<uint32_t, AirQualityData> air_quality_data;
-  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
-    air_quality_data = m_air_quality_data;
-    xSemaphoreGive(m_mutex);
-  } else {
-    Logger::error("Failed to take mutex lock for getting data");
-  }
-  return air_quality_data;
+std::shared_ptr<const AirQualitySnapshot>
+DataDownloadService::getAirQualityData() {
+  xSemaphoreTake(m_snapshot_mutex, portMAX_DELAY);
+  std::shared_ptr<const AirQualitySnapshot> snapshot = m_air_quality_data;
+  xSemaphoreGive(m_snapshot_mutex);
+  return snapshot;
+}
+
+uint32_t DataDownloadService::getDataVersion() { return m_data_version; }
+
+void DataDownloadService::notifyOnNewData(TaskHandle_t task_handle) {
+  m_new_data_task = task_handle;
 }
 
 bool DataDownloadService::downloadAirQualityData() {
-  std::map<uint32_t, AirQualityData> air_quality_data;
   if (!m_auth_service->isAuthenticated()) {
     Logger::error("Not authenticated");
     return false;
   }
 
-  auto response = m_http_client->getJSON(
-      API_BASE_URL "/sensors/latest", m_auth_service->getAuthenticationToken());
-
-  if (response.httpStatusCode != 200) {
-    Logger::error("Failed to send air quality data, status code: " +
-                  std::to_string(response.httpStatusCode));
-
-    if (response.httpStatusCode == 401) {
-      m_auth_service->reset();
-    }
+  // the response body is decoded into the service, so only one download can
+  // be queued at a time
+  if (m_download_pending.exchange(true)) {
+    return true;
+  }
 
-    return false;
+  // send the validators of the cached data, so the server can answer with
+  // 304 Not Modified
+  std::string etag;
+  std::string last_modified;
+  if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
+    etag = m_etag;
+    last_modified = m_last_modified;
+    xSemaphoreGive(m_mutex);
   }
 
-  cJSON *json = cJSON_Parse(response.response_content.c_str());
-  if (json == NULL) {
-    const char *error_ptr = cJSON_GetErrorPtr();
-    if (error_ptr != NULL) {
-      Logger::error("Error before: " + std::string(error_ptr));
-    }
-    return false;
+  const bool queued = m_network_service->send(
+      {.method = HTTP_METHOD_GET,
+       .url = API_BASE_URL "/sensors/latest",
+       .token = m_auth_service->getAuthenticationToken(),
+       .content_type = "application/json",
+       .accept = PAYLOAD_CBOR_ENABLED
+                     ? CBOR_CONTENT_TYPE ", application/json;q=0.9"
+                     : "",
+       .if_none_match = etag,
+       .if_modified_since = last_modified,
+       .sink = this},
+      PRIORITY_DISPLAY, [this](const HTTPResponse &response) {
+        if (!handleAirQualityData(response)) {
+          Logger::error("Failed to download air quality data");
+        }
+      });
+  if (!queued) {
+    m_download_pending = false;
   }
+  return queued;
+}
 
-  if (!cJSON_IsArray(json)) {
-    Logger::debug("Error: Expected an array\n");
-    cJSON_Delete(json);
-    return false;
+void DataDownloadService::begin(const std::string &content_type) {
+  m_body_started = true;
+  m_body_valid = true;
+  m_body_cbor = content_type.rfind(CBOR_CONTENT_TYPE, 0) == 0;
+  m_cbor_content.clear();
+  m_decoded_air_quality_data.clear();
+  if (!m_body_cbor) {
+    m_json_decoder.begin(&m_decoded_air_quality_data);
   }
+}
 
-  cJSON *element;
-  uint32_t index = 0;
+void DataDownloadService::write(const char *data, size_t length) {
+  if (!m_body_valid) {
+    return;
+  }
+  if (m_body_cbor) {
+    m_cbor_content.append(data, length);
+  } else {
+    m_body_valid = m_json_decoder.feed(data, length);
+  }
+}
 
-  cJSON_ArrayForEach(element, json) {
-    cJSON *device = cJSON_GetObjectItem(element, "device");
-    if ((device == NULL) || (!cJSON_IsString(device))) {
-      Logger::error("Wrong data format");
-      cJSON_Delete(json);
-      return false;
-    }
+bool DataDownloadService::handleAirQualityData(const HTTPResponse &response) {
+  // the body was decoded by the sink, it is consumed by this response
+  const bool body_started = m_body_started;
+  m_body_started = false;
+  m_download_pending = false;
 
-    cJSON *humidity = cJSON_GetObjectItem(element, "humidity");
-    if ((humidity == NULL) || (!cJSON_IsNumber(humidity))) {
-      Logger::error("Wrong data format");
-      cJSON_Delete(json);
-      return false;
-    }
+  // the cached data is still up to date
+  if (response.httpStatusCode == 304) {
+    Logger::debug("Air quality data not modified");
+    return true;
+  }
 
-    cJSON *pressure = cJSON_GetObjectItem(element, "pressure");
-    if ((pressure == NULL) || (!cJSON_IsNumber(pressure))) {
-      Logger::error("Wrong data format");
-      cJSON_Delete(json);
-      return false;
-    }
+  if (response.httpStatusCode != 200) {
+    Logger::error("Failed to download air quality data, status code: " +
+                  std::to_string(response.httpStatusCode));
 
-    cJSON *temperature = cJSON_GetObjectItem(element, "temperature");
-    if ((temperature == NULL) || (!cJSON_IsNumber(temperature))) {
-      Logger::error("Wrong data format");
-      cJSON_Delete(json);
-      return false;
+    if (response.httpStatusCode == 401) {
+      m_auth_service->reset();
     }
 
-    cJSON *gasResistance = cJSON_GetObjectItem(element, "gasResistance");
-    if ((gasResistance == NULL) || (!cJSON_IsNumber(gasResistance))) {
-      Logger::error("Wrong data format");
-      cJSON_Delete(json);
-      return false;
-    }
+    return false;
+  }
 
-    air_quality_data[index] = AirQualityData{
-        .device_name = std::string(device->valuestring),
-        .temperature = static_cast<float>(temperature->valuedouble),
-        .humidity = static_cast<float>(humidity->valuedouble),
-        .pressure = static_cast<uint32_t>(pressure->valueint),
-        .gas_resistance = static_cast<uint32_t>(gasResistance->valueint),
-    };
-    index++;
+  bool decoded = false;
+  if (!body_started) {
+    Logger::error("Empty air quality data response");
+  } else if (m_body_cbor) {
+    decoded = AirQualityCborDecoder::decode(
+        reinterpret_cast<const uint8_t *>(m_cbor_content.data()),
+        m_cbor_content.size(), &m_decoded_air_quality_data);
+    m_cbor_content.clear();
+  } else {
+    decoded = m_body_valid && m_json_decoder.finish();
+  }
+  if (!decoded) {
+    return false;
   }
 
-  cJSON_Delete(json);
+  // publish the decoded data as new snapshot, readers of the previous
+  // snapshot keep it until they drop their reference, this task drops its
+  // reference after releasing the lock. The devices keep their position, so
+  // the shown page does not change with the order of the response.
+  m_decoded_air_quality_data.keepOrderOf(*getAirQualityData());
+  std::shared_ptr<const AirQualitySnapshot> snapshot =
+      std::make_shared<const AirQualitySnapshot>(m_decoded_air_quality_data);
+  xSemaphoreTake(m_snapshot_mutex, portMAX_DELAY);
+  m_air_quality_data.swap(snapshot);
+  xSemaphoreGive(m_snapshot_mutex);
+  m_decoded_air_quality_data.clear();
+  m_data_version++;
+  const TaskHandle_t new_data_task = m_new_data_task;
+  if (new_data_task != NULL) {
+    xTaskNotifyGive(new_data_task);
+  }
 
   if (xSemaphoreTake(m_mutex, (TickType_t)10) == pdTRUE) {
-    m_air_quality_data = air_quality_data;
+    m_etag = response.etag;
+    m_last_modified = response.last_modified;
     xSemaphoreGive(m_mutex);
   } else {
-    Logger::error("Failed to take mutex lock for setting data");
-    return false;
+    Logger::error("Failed to take mutex lock for setting validators");
   }
-
   return true;
-}
\ No newline at end of file
+}
@@ -1,71 +1,133 @@
 #pragma once
 
-#include <map>
+#include <atomic>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "main/driver/bme680/bme680.h"
-#include "main/hal/http_client/http_client.h"
 #include "main/service/authentication_service/authentication_service.h"
+#include "main/service/data_download_service/air_quality_json_decoder.h"
+#include "main/service/data_download_service/air_quality_store.h"
+#include "main/service/network_service/network_service.h"
 
-//! @brief The air quality data of a device
-struct AirQualityData {
-  //! @brief The device name
-  std::string device_name;
-  //! @brief The temperature in degrees celsius
-  float temperature;
-  //! @brief The humidity in percent
-  float humidity;
-  //! @brief The pressure in pascal
-  uint32_t pressure;
-  //! @brief The gas resistance in ohm
-  uint32_t gas_resistance;
-};
-
-class DataDownloadService {
+//! @brief Service that periodically downloads the latest air quality data of
+//! all devices
+//! @note The response body is decoded while it is received, a json body is
+//! parsed chunk by chunk so the memory use does not grow with its size.
+//! The download is a conditional GET, if the data did not change the server
+//! answers with 304 Not Modified and the cached data is kept.
+//! The cached data is published as an immutable snapshot, readers keep a
+//! reference to a snapshot instead of copying it. The mutex guarding the
+//! snapshot pointer is only held to copy or swap it, not while decoding or
+//! rendering.
+class DataDownloadService : public ResponseSink {
  public:
   //! @brief Constructor
-  //! @param http_client The http client
+  //! @param network_service The network service
   //! @param auth_service The authentication service
-  DataDownloadService(HTTPClient* http_client,
+  DataDownloadService(NetworkService* network_service,
                       AuthenticationService* auth_service);
 
   //! @brief Destructor
   ~DataDownloadService();
 
-  //! @brief Start the air quality data download task
+  //! @brief Start the periodic air quality data download
   bool startDataDownloadTask();
 
-  //! @brief Stop the air quality data download task
+  //! @brief Stop the periodic air quality data download
   bool stopDataDownloadTask();
 
   //! @brief retrieve the cached air quality data
   //! @note using cached data is faster than downloading the data from the
-  //! server
-  //! @return a map of the air quality data
-  //! @note the map key is the device id
-  std::map<uint32_t, AirQualityData> getAirQualityData();
+  //! server. The snapshot is never modified, a download publishes a new one.
+  //! Take it once and use it for the whole render to get a consistent view.
+  //! @return the snapshot of the air quality data, never null
+  std::shared_ptr<const AirQualitySnapshot> getAirQualityData();
+
+  //! @brief get the version of the cached air quality data
+  //! @note the version changes whenever new data was downloaded, a response
+  //! with 304 Not Modified keeps the version
+  //! @return the data version
+  uint32_t getDataVersion();
+
+  //! @brief Notify a task whenever new data was downloaded
+  //! @param task_handle The task, woken with a task notification
+  void notifyOnNewData(TaskHandle_t task_handle);
+
+  //! @brief Start receiving a downloaded response body
+  //! @param content_type The content type of the response
+  void begin(const std::string& content_type) override;
+
+  //! @brief Receive the next chunk of a downloaded response body
+  //! @param data The chunk
+  //! @param length The length of the chunk
+  void write(const char* data, size_t length) override;
 
  private:
-  //! @brief retrieve the air quality data from the server and cache it
-  //! @return True if the air quality data was downloaded successfully, false
-  //! otherwise
+  //! @brief queue the download of the air quality data from the server
+  //! @return True if the download was queued successfully, false otherwise
   bool downloadAirQualityData();
 
-  //! @brief Pointer to the http client
-  HTTPClient* m_http_client;
+  //! @brief finish decoding the downloaded air quality data and cache it
+  //! @param response The http response, the body was passed to the sink
+  //! @return True if the air quality data was cached successfully, false
+  //! otherwise
+  bool handleAirQualityData(const HTTPResponse& response);
+
+  //! @brief Pointer to the network service
+  NetworkService* m_network_service;
 
   //! @brief Pointer to the authentication service
   AuthenticationService* m_auth_service;
 
-  //! @brief The air quality data download task handle
-  TaskHandle_t m_data_download_task_handle;
+  //! @brief The timer triggering the periodic download
+  esp_timer_handle_t m_data_download_timer;
+
+  //! @brief The snapshot of the cached air quality data
+  //! @note Guarded by m_snapshot_mutex
+  std::shared_ptr<const AirQualitySnapshot> m_air_quality_data;
+
+  //! @brief Mutex to protect the snapshot pointer
+  SemaphoreHandle_t m_snapshot_mutex;
+
+  //! @brief The streaming decoder for json response bodies
+  AirQualityJsonDecoder m_json_decoder;
+
+  //! @brief The air quality data decoded from the current response
+  AirQualityStore m_decoded_air_quality_data;
+
+  //! @brief Flag if a download is queued or in flight
+  std::atomic<bool> m_download_pending;
+
+  //! @brief The version of the cached air quality data
+  std::atomic<uint32_t> m_data_version;
+
+  //! @brief The task notified on new data, NULL if none
+  std::atomic<TaskHandle_t> m_new_data_task;
+
+  //! @brief The entity tag of the cached air quality data
+  std::string m_etag;
+
+  //! @brief The last modification date of the cached air quality data
+  std::string m_last_modified;
+
+  //! @brief Flag if a response body was received
+  bool m_body_started;
+
+  //! @brief Flag if the current response body is CBOR encoded
+  bool m_body_cbor;
+
+  //! @brief Flag if the current response body is valid so far
+  bool m_body_valid;
 
-  //! @brief The cached air quality data
-  //! @note the map key is the device id
-  std::map<uint32_t, AirQualityData> m_air_quality_data;
+  //! @brief The current CBOR response body, decoded once it is complete
+  std::string m_cbor_content;
 
-  //! mutex to protect the cached air quality data
+  //! mutex to protect the validators of the cached air quality data
   SemaphoreHandle_t m_mutex;
 };
\ No newline at end of file
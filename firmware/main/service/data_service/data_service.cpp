@@ -1,15 +1,55 @@
 #include "main/service/data_service/data_service.h"
 
+#include <algorithm>
+#include <cmath>
+
+#include "esp_timer.h"
 #include "main/config.h"
-#include "main/hal/http_client/http_client.h"
+#include "main/hal/timer/timer.h"
 #include "main/logger/logger.h"
+#include "main/service/data_service/sample_encoder.h"
 
-DataService::DataService(HTTPClient* http_client,
-                         AuthenticationService* auth_service, BME680* bme680)
-    : m_http_client(http_client),
+DataService::DataService(NetworkService* network_service,
+                         AuthenticationService* auth_service, BME680* bme680,
+                         SampleBuffer* sample_buffer,
+                         NonVolatileStorage* non_volatile_storage,
+                         BsecService* bsec_service)
+    : m_network_service(network_service),
       m_auth_service(auth_service),
       m_bme680(bme680),
-      m_data_upload_task_handle(NULL) {}
+      m_sample_buffer(sample_buffer),
+      m_non_volatile_storage(non_volatile_storage),
+      m_bsec_service(bsec_service),
+      m_batch_wait_start(0),
+      m_use_cbor(PAYLOAD_CBOR_ENABLED),
+      m_uploading_cbor(false),
+      m_upload_in_progress(false),
+      m_uploaded_in_cycle(0),
+      m_measurement_timestamp(0),
+      m_measurement_uptime(0),
+      m_boot_id(0),
+      m_time_anchors{},
+      m_time_anchor_saved(false),
+      m_data_upload_task_handle(NULL) {
+  // every boot gets a new number, samples of an earlier boot are converted
+  // with the unix time stored for it
+  uint32_t value;
+  if (m_non_volatile_storage->getValue(STORAGE_USERCONFIG, KEY_BOOTID,
+                                       &value)) {
+    m_boot_id = value + 1;
+  }
+  if (!m_non_volatile_storage->setValue(STORAGE_USERCONFIG, KEY_BOOTID,
+                                        m_boot_id)) {
+    Logger::error("Failed to persist the boot number");
+  }
+  size_t length = sizeof(m_time_anchors);
+  if (!m_non_volatile_storage->getBlob(STORAGE_USERCONFIG, KEY_TIMEANCHORS,
+                                       m_time_anchors, &length) ||
+      length != sizeof(m_time_anchors)) {
+    std::fill(std::begin(m_time_anchors), std::end(m_time_anchors),
+              TimeAnchor{});
+  }
+}
 
 DataService::~DataService() {}
 
@@ -25,9 +65,19 @@ bool DataService::startDataUploadTask() {
       [](void* data_service_ptr) {
         DataService* data_service = (DataService*)data_service_ptr;
 
+        uint32_t iteration = 0;
         while (true) {
-          if (!data_service->sendAirQualityData()) {
-            Logger::error("Failed to send air quality data");
+          data_service->runCycle();
+
+          // report the connection statistics every 5 minutes
+          if (++iteration % 30 == 0) {
+            data_service->m_network_service->logStatistics();
+            Logger::info(
+                "Buffered samples: " +
+                std::to_string(data_service->m_sample_buffer->size()) +
+                " dropped: " +
+                std::to_string(
+                    data_service->m_sample_buffer->getDroppedCount()));
           }
 
           vTaskDelay(10000 / portTICK_PERIOD_MS);
@@ -49,32 +99,294 @@ bool DataService::stopDataUploadTask() {
   return true;
 }
 
+void DataService::runCycle() {
+  if (isBsecRunning()) {
+    collectBsecData();
+    sendAirQualityData();
+    return;
+  }
+
+  // the backlog is uploaded while the sensor heats up and converts, a running
+  // upload picks up the new sample once it is buffered
+  const bool measuring = startMeasurement();
+  sendAirQualityData();
+  if (measuring) {
+    collectAirQualityData();
+    sendAirQualityData();
+  }
+}
+
+bool DataService::startMeasurement() {
+  m_measurement_timestamp = Timer::getUnixTime();
+  m_measurement_uptime = getUptime();
+  if (m_bme680->beginReading() == 0) {
+    Logger::error("Failed to start air quality measurement");
+    return false;
+  }
+  return true;
+}
+
+void DataService::collectAirQualityData() {
+  // wait for the deadline of the measurement without blocking other tasks,
+  // the sensor may need a few more ticks than calculated
+  BME680::ReadingState state;
+  while (true) {
+    const int remaining_millis = m_bme680->remainingReadingMillis();
+    if (remaining_millis > 0) {
+      vTaskDelay(pdMS_TO_TICKS(remaining_millis) + 1);
+    }
+    state = m_bme680->pollReading();
+    if (state != BME680::READING_PENDING) {
+      break;
+    }
+    vTaskDelay(1);
+  }
+  if (state != BME680::READING_DONE) {
+    Logger::error("Failed to read air quality data");
+    return;
+  }
+
+  const AirQualitySample sample = {
+      .timestamp = m_measurement_timestamp,
+      .temperature = m_bme680->getTemperature(),
+      .humidity = m_bme680->getHumidity(),
+      .pressure = m_bme680->getPressure(),
+      .gas_resistance = m_bme680->getGas(),
+      .iaq = NAN,
+      .co2_equivalent = NAN,
+      .breath_voc_equivalent = NAN,
+      .iaq_accuracy = 0,
+      .boot_id = m_boot_id,
+      .uptime = m_measurement_uptime};
+
+  if (!m_sample_buffer->push(sample)) {
+    Logger::warn("Sample buffer is full, dropped air quality data");
+  }
+}
+
+bool DataService::isBsecRunning() {
+  return m_bsec_service != nullptr && m_bsec_service->isRunning();
+}
+
+void DataService::collectBsecData() {
+  // the driver values are written by the BSEC task, so the sample is built
+  // from the estimate only
+  BsecOutput output;
+  if (!m_bsec_service->getOutput(&output)) {
+    Logger::debug("No BSEC estimate available yet");
+    return;
+  }
+
+  const AirQualitySample sample = {
+      .timestamp = Timer::getUnixTime(),
+      .temperature = output.temperature,
+      .humidity = output.humidity,
+      .pressure = output.pressure,
+      .gas_resistance = output.gas_resistance,
+      .iaq = output.iaq,
+      .co2_equivalent = output.co2_equivalent,
+      .breath_voc_equivalent = output.breath_voc_equivalent,
+      .iaq_accuracy = output.iaq_accuracy,
+      .boot_id = m_boot_id,
+      .uptime = getUptime()};
+
+  if (!m_sample_buffer->push(sample)) {
+    Logger::warn("Sample buffer is full, dropped air quality data");
+  }
+}
+
 bool DataService::sendAirQualityData() {
+  if (m_upload_in_progress) {
+    return true;
+  }
+
   if (!m_auth_service->isAuthenticated()) {
     Logger::error("Not authenticated");
     return false;
   }
 
-  m_bme680->readData();
+  if (!updateTimeAnchor()) {
+    Logger::debug("Clock not synchronized, holding the upload");
+    return false;
+  }
 
-  const std::string body =
-      "{\"temp\":" + std::to_string(m_bme680->getTemperature()) +
-      ",\"humidity\":" + std::to_string(m_bme680->getHumidity()) +
-      ",\"pressure\":" + std::to_string(m_bme680->getPressure()) +
-      ",\"gasResistance\":" + std::to_string(m_bme680->getGas()) + "}";
+  if (!isUploadDue()) {
+    return false;
+  }
 
-  auto response = m_http_client->postJSON(
-      API_BASE_URL "/data", body, m_auth_service->getAuthenticationToken());
+  m_batch_wait_start = 0;
+  m_upload_in_progress = true;
+  m_uploaded_in_cycle = 0;
+  if (!uploadNextSamples()) {
+    m_upload_in_progress = false;
+    return false;
+  }
+  return true;
+}
 
-  if (response.httpStatusCode != 200) {
-    Logger::error("Failed to send air quality data, status code: " +
-                  std::to_string(response.httpStatusCode));
+bool DataService::isUploadDue() {
+  const size_t pending = m_sample_buffer->size();
+  if (pending == 0) {
+    m_batch_wait_start = 0;
+    return false;
+  }
+  if (pending >= UPLOAD_BATCH_SIZE) {
+    return true;
+  }
 
-    if (response.httpStatusCode == 401) {
-      m_auth_service->reset();
-    }
+  // an incomplete batch is sent once it waited for the maximum delay
+  const int64_t now = esp_timer_get_time();
+  if (m_batch_wait_start == 0) {
+    m_batch_wait_start = now;
+  }
+  return now - m_batch_wait_start >=
+         static_cast<int64_t>(UPLOAD_BATCH_MAX_DELAY_S) * 1000000;
+}
 
+bool DataService::updateTimeAnchor() {
+  const uint32_t now = Timer::getUnixTime();
+  if (now == 0) {
     return false;
   }
+  if (m_time_anchor_saved) {
+    return true;
+  }
+
+  m_time_anchors[m_boot_id % TIME_ANCHOR_COUNT] = {
+      .boot_id = m_boot_id, .boot_time = now - getUptime()};
+  m_time_anchor_saved = m_non_volatile_storage->setBlob(
+      STORAGE_USERCONFIG, KEY_TIMEANCHORS, m_time_anchors,
+      sizeof(m_time_anchors));
+  if (!m_time_anchor_saved) {
+    Logger::error("Failed to persist the time of this boot");
+  }
   return true;
-}
\ No newline at end of file
+}
+
+void DataService::resolveTimestamp(AirQualitySample* sample) {
+  if (sample->timestamp != 0) {
+    return;
+  }
+  const TimeAnchor& anchor =
+      m_time_anchors[sample->boot_id % TIME_ANCHOR_COUNT];
+  if (anchor.boot_time == 0 || anchor.boot_id != sample->boot_id) {
+    Logger::warn("Clock of boot " + std::to_string(sample->boot_id) +
+                 " was never synchronized, sample has no timestamp");
+    return;
+  }
+  sample->timestamp = anchor.boot_time + sample->uptime;
+}
+
+uint32_t DataService::getUptime() { return esp_timer_get_time() / 1000000; }
+
+bool DataService::uploadNextSamples(bool allow_cbor) {
+  // the batch is read and marked as in flight at once, so samples the upload
+  // task drops in the meantime are not removed by the response
+  const size_t count = m_sample_buffer->peekBatch(UPLOAD_BATCH_SIZE, m_batch);
+  if (count == 0) {
+    return false;
+  }
+  for (size_t index = 0; index < count; index++) {
+    resolveTimestamp(&m_batch[index]);
+  }
+
+  m_uploading_cbor = allow_cbor && m_use_cbor;
+  if (m_uploading_cbor) {
+    CborWriter writer(m_cbor_buffer, sizeof(m_cbor_buffer));
+    if (UPLOAD_BATCH_SIZE > 1) {
+      writer.writeArray(count);
+    }
+    for (size_t index = 0; index < count; index++) {
+      SampleEncoder::writeCbor(writer, m_batch[index]);
+    }
+
+    if (!writer.ok()) {
+      Logger::error("CBOR buffer too small for the upload batch");
+      return false;
+    }
+
+    return m_network_service->post(
+        API_BASE_URL "/data",
+        std::string(reinterpret_cast<const char*>(m_cbor_buffer),
+                    writer.size()),
+        m_auth_service->getAuthenticationToken(), PRIORITY_UPLOAD,
+        [this](const HTTPResponse& response) {
+          handleUploadResponse(response);
+        },
+        CBOR_CONTENT_TYPE, CBOR_CONTENT_TYPE);
+  }
+
+  std::string body;
+  if (UPLOAD_BATCH_SIZE <= 1) {
+    // single sample path for backends without batch support
+    SampleEncoder::appendJson(body, m_batch[0]);
+  } else {
+    body = "[";
+    for (size_t index = 0; index < count; index++) {
+      if (index > 0) {
+        body += ",";
+      }
+      SampleEncoder::appendJson(body, m_batch[index]);
+    }
+    body += "]";
+  }
+
+  return m_network_service->post(
+      API_BASE_URL "/data", body, m_auth_service->getAuthenticationToken(),
+      PRIORITY_UPLOAD, [this](const HTTPResponse& response) {
+        handleUploadResponse(response);
+      });
+}
+
+void DataService::handleUploadResponse(const HTTPResponse& response) {
+  if (m_uploading_cbor) {
+    // a backend without CBOR support rejects the media type, a bad request
+    // may be caused by the samples as well, so that batch is retried once as
+    // json without giving up on CBOR
+    if (response.httpStatusCode == 415 || response.httpStatusCode == 400) {
+      if (response.httpStatusCode == 415) {
+        Logger::warn("Backend does not support CBOR, falling back to json");
+        m_use_cbor = false;
+      } else {
+        Logger::warn("Backend rejected CBOR batch, retrying it as json");
+      }
+      if (uploadNextSamples(false)) {
+        return;
+      }
+      m_upload_in_progress = false;
+      return;
+    }
+
+    if (response.httpStatusCode == 200 &&
+        response.content_type.rfind(CBOR_CONTENT_TYPE, 0) != 0) {
+      Logger::warn("Backend does not answer with CBOR, falling back to json");
+      m_use_cbor = false;
+    }
+  }
+
+  if (response.httpStatusCode == 200 || response.httpStatusCode == 400) {
+    // rejected samples would block the buffer, so they are dropped as well
+    if (response.httpStatusCode == 400) {
+      Logger::error("Air quality data rejected by the backend");
+    }
+    m_sample_buffer->popInFlight();
+    m_uploaded_in_cycle++;
+
+    // continue with complete batches of the backlog until the budget of this
+    // cycle is used up
+    if (m_uploaded_in_cycle < SAMPLE_DRAIN_MAX_PER_CYCLE &&
+        m_sample_buffer->size() >= UPLOAD_BATCH_SIZE && uploadNextSamples()) {
+      return;
+    }
+    m_upload_in_progress = false;
+    return;
+  }
+
+  Logger::error("Failed to send air quality data, status code: " +
+                std::to_string(response.httpStatusCode));
+
+  if (response.httpStatusCode == 401) {
+    m_auth_service->reset();
+  }
+  m_upload_in_progress = false;
+}
@@ -1,17 +1,55 @@
 #pragma once
 
+#include <atomic>
+#include <string>
+
+#include "main/config.h"
 #include "main/driver/bme680/bme680.h"
-#include "main/hal/http_client/http_client.h"
+#include "main/hal/non_volatile_storage/non_volatile_storage.h"
+#include "main/libs/cbor/cbor.h"
 #include "main/service/authentication_service/authentication_service.h"
+#include "main/service/bsec_service/bsec_service.h"
+#include "main/service/data_service/sample_encoder.h"
+#include "main/service/network_service/network_service.h"
+#include "main/service/sample_buffer/sample_buffer.h"
+
+//! @brief The unix time of a boot, converts the uptime of its samples
+struct TimeAnchor {
+  //! @brief The number of the boot
+  uint32_t boot_id;
+  //! @brief The unix time of the boot
+  uint32_t boot_time;
+};
 
+//! @brief Service that samples the air quality and uploads it to the backend
+//! @note Every sample is timestamped and buffered first, so samples taken
+//! while the backend is unreachable are uploaded once it is back. Samples
+//! measured before the clock is synchronized keep their boot and uptime, they
+//! get their unix time from the time of that boot once it is known, so no
+//! upload starts before the clock is synchronized. The backlog
+//! is drained with at most SAMPLE_DRAIN_MAX_PER_CYCLE uploads per cycle.
+//! With UPLOAD_BATCH_SIZE above 1 the samples are collected until the batch is
+//! full or the oldest sample waited for the maximum delay, and then uploaded
+//! as one json array. With PAYLOAD_CBOR_ENABLED the samples are encoded as
+//! CBOR instead, if the backend rejects it the service falls back to json.
+//! While the BSEC service runs it owns the sensor, the samples are then taken
+//! from its latest estimate including the indoor air quality.
 class DataService {
  public:
   //! @brief Constructor
-  //! @param http_client The http client
+  //! @param network_service The network service
   //! @param auth_service The authentication service
   //! @param bme680 The BME680 driver
-  DataService(HTTPClient* http_client, AuthenticationService* auth_service,
-              BME680* bme680);
+  //! @param sample_buffer The buffer of samples to upload
+  //! @param non_volatile_storage The non volatile storage to persist the
+  //! boot number and the time of the boots
+  //! @param bsec_service The BSEC service, nullptr to measure the sensor
+  //! directly
+  DataService(NetworkService* network_service,
+              AuthenticationService* auth_service, BME680* bme680,
+              SampleBuffer* sample_buffer,
+              NonVolatileStorage* non_volatile_storage,
+              BsecService* bsec_service = nullptr);
 
   //! @brief Destructor
   ~DataService();
@@ -22,14 +60,62 @@ class DataService {
   //! @brief Stop the air quality data upload task
   bool stopDataUploadTask();
 
+  //! @brief Take a sample and upload the buffered samples that are due
+  //! @note Called by the upload task every 10 seconds
+  void runCycle();
+
  private:
-  //! @brief Send the air quality data to the server
-  //! @return True if the air quality data was sent successfully, false
-  //! otherwise
+  //! @brief Start a measurement of the sensor without waiting for it
+  //! @return True if the measurement was started, false otherwise
+  bool startMeasurement();
+
+  //! @brief Wait for the measurement to complete and add the air quality data
+  //! to the buffer
+  void collectAirQualityData();
+
+  //! @brief Check if the BSEC service owns the sensor
+  //! @return True if the BSEC task is running, false otherwise
+  bool isBsecRunning();
+
+  //! @brief Add the latest estimate of the BSEC service to the buffer
+  void collectBsecData();
+
+  //! @brief Start uploading the buffered air quality data if no upload is in
+  //! progress
+  //! @return True if an upload is in progress, false otherwise
   bool sendAirQualityData();
 
-  //! @brief Pointer to the http client
-  HTTPClient* m_http_client;
+  //! @brief Check if the buffered samples should be uploaded now
+  //! @return True if a single sample or a complete batch is pending, or the
+  //! batch waited for the maximum delay
+  bool isUploadDue();
+
+  //! @brief Store the unix time of this boot once the clock is synchronized
+  //! @return True if the clock is synchronized, false otherwise
+  bool updateTimeAnchor();
+
+  //! @brief Set the unix time of a sample measured before the clock was
+  //! synchronized
+  //! @note A sample of a boot whose clock was never synchronized keeps the
+  //! timestamp 0, the backend then uses the time of reception.
+  //! @param sample The sample
+  void resolveTimestamp(AirQualitySample* sample);
+
+  //! @brief Get the time since boot
+  //! @return The seconds since boot
+  static uint32_t getUptime();
+
+  //! @brief Queue the upload of the oldest buffered samples
+  //! @param allow_cbor False to send this batch as json in any case.
+  //! @return True if the upload was queued, false otherwise
+  bool uploadNextSamples(bool allow_cbor = true);
+
+  //! @brief Handle the response of an air quality data upload
+  //! @param response The http response
+  void handleUploadResponse(const HTTPResponse& response);
+
+  //! @brief Pointer to the network service
+  NetworkService* m_network_service;
 
   //! @brief Pointer to the authentication service
   AuthenticationService* m_auth_service;
@@ -37,6 +123,53 @@ class DataService {
   //! @brief Pointer to the BME680 driver
   BME680* m_bme680;
 
+  //! @brief Pointer to the buffer of samples to upload
+  SampleBuffer* m_sample_buffer;
+
+  //! @brief Pointer to the non volatile storage
+  NonVolatileStorage* m_non_volatile_storage;
+
+  //! @brief Pointer to the BSEC service, nullptr if not used
+  BsecService* m_bsec_service;
+
+  //! @brief Time in microseconds since the current batch is waiting, 0 if
+  //! no batch is waiting
+  int64_t m_batch_wait_start;
+
+  //! @brief Flag if the samples are uploaded as CBOR
+  std::atomic<bool> m_use_cbor;
+
+  //! @brief Flag if the upload in flight is CBOR encoded
+  bool m_uploading_cbor;
+
+  //! @brief The samples of the upload in flight
+  AirQualitySample m_batch[UPLOAD_BATCH_SIZE];
+
+  //! @brief Preallocated buffer to encode the CBOR request body
+  uint8_t m_cbor_buffer[UPLOAD_BATCH_SIZE * CBOR_SAMPLE_MAX_SIZE + 1];
+
+  //! @brief Flag if an upload is queued or in flight
+  std::atomic<bool> m_upload_in_progress;
+
+  //! @brief Number of requests sent in the current cycle
+  uint32_t m_uploaded_in_cycle;
+
+  //! @brief Unix time when the current measurement was started
+  uint32_t m_measurement_timestamp;
+
+  //! @brief Seconds since boot when the current measurement was started
+  uint32_t m_measurement_uptime;
+
+  //! @brief Number of this boot
+  uint32_t m_boot_id;
+
+  //! @brief The unix times of the last boots, indexed by the boot number
+  //! modulo TIME_ANCHOR_COUNT
+  TimeAnchor m_time_anchors[TIME_ANCHOR_COUNT];
+
+  //! @brief Flag if the unix time of this boot is known
+  bool m_time_anchor_saved;
+
   //! @brief The air quality data upload task handle
   TaskHandle_t m_data_upload_task_handle;
-};
\ No newline at end of file
+};
@@ -0,0 +1,64 @@
+#include "main/service/data_service/sample_encoder.h"
+
+#include <cmath>
+
+void SampleEncoder::appendJson(std::string& body,
+                               const AirQualitySample& sample) {
+  body += "{\"temp\":" + std::to_string(sample.temperature) +
+          ",\"humidity\":" + std::to_string(sample.humidity) +
+          ",\"pressure\":" + std::to_string(sample.pressure) +
+          ",\"gasResistance\":" + std::to_string(sample.gas_resistance);
+  // without a timestamp the backend uses the time of reception
+  if (sample.timestamp != 0) {
+    body += ",\"timestamp\":" + std::to_string(sample.timestamp);
+  }
+  // the air quality estimates are only known while BSEC runs, and each of
+  // them only after BSEC output it once, NAN is no valid json number
+  if (!std::isnan(sample.iaq)) {
+    body += ",\"iaq\":" + std::to_string(sample.iaq) +
+            ",\"iaqAccuracy\":" + std::to_string(sample.iaq_accuracy);
+  }
+  if (!std::isnan(sample.co2_equivalent)) {
+    body += ",\"co2Equivalent\":" + std::to_string(sample.co2_equivalent);
+  }
+  if (!std::isnan(sample.breath_voc_equivalent)) {
+    body += ",\"breathVocEquivalent\":" +
+            std::to_string(sample.breath_voc_equivalent);
+  }
+  body += "}";
+}
+
+void SampleEncoder::writeCbor(CborWriter& writer,
+                              const AirQualitySample& sample) {
+  const bool has_iaq = !std::isnan(sample.iaq);
+  const bool has_co2 = !std::isnan(sample.co2_equivalent);
+  const bool has_breath_voc = !std::isnan(sample.breath_voc_equivalent);
+  writer.writeMap(4 + (sample.timestamp != 0 ? 1 : 0) + (has_iaq ? 2 : 0) +
+                  (has_co2 ? 1 : 0) + (has_breath_voc ? 1 : 0));
+  writer.writeString("temp");
+  writer.writeFloat(sample.temperature);
+  writer.writeString("humidity");
+  writer.writeFloat(sample.humidity);
+  writer.writeString("pressure");
+  writer.writeFloat(sample.pressure);
+  writer.writeString("gasResistance");
+  writer.writeUInt(sample.gas_resistance);
+  if (sample.timestamp != 0) {
+    writer.writeString("timestamp");
+    writer.writeUInt(sample.timestamp);
+  }
+  if (has_iaq) {
+    writer.writeString("iaq");
+    writer.writeFloat(sample.iaq);
+    writer.writeString("iaqAccuracy");
+    writer.writeUInt(sample.iaq_accuracy);
+  }
+  if (has_co2) {
+    writer.writeString("co2Equivalent");
+    writer.writeFloat(sample.co2_equivalent);
+  }
+  if (has_breath_voc) {
+    writer.writeString("breathVocEquivalent");
+    writer.writeFloat(sample.breath_voc_equivalent);
+  }
+}
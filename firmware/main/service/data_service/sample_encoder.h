@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include "main/hal/sample_storage/sample_storage.h"
+#include "main/libs/cbor/cbor.h"
+
+//! @brief Maximum size of one CBOR encoded sample in bytes
+#define CBOR_SAMPLE_MAX_SIZE 160
+
+//! @brief Encoder of the air quality samples of the /data endpoint
+class SampleEncoder {
+ public:
+  //! @brief Append a sample as json object to the body
+  //! @param body The request body
+  //! @param sample The sample to append
+  static void appendJson(std::string& body, const AirQualitySample& sample);
+
+  //! @brief Write a sample as CBOR map
+  //! @param writer The CBOR writer
+  //! @param sample The sample to write
+  static void writeCbor(CborWriter& writer, const AirQualitySample& sample);
+
+ private:
+  //! @brief Private constructor to prevent instantiation.
+  SampleEncoder();
+};
@@ -0,0 +1,182 @@
+#include "main/service/network_service/network_service.h"
+
+#include "main/logger/logger.h"
+
+NetworkService::NetworkService(HTTPClient *http_client)
+    : m_http_client(http_client),
+      m_request_active(false),
+      m_network_task_handle(NULL),
+      m_mutex(xSemaphoreCreateMutex()) {}
+
+NetworkService::~NetworkService() { stopNetworkTask(); }
+
+bool NetworkService::startNetworkTask() {
+  Logger::info("Starting network task...");
+  if (m_network_task_handle != NULL) {
+    Logger::error("Network task already running");
+    return false;
+  }
+
+  xTaskCreate(
+      [](void *network_service_ptr) {
+        NetworkService *network_service =
+            (NetworkService *)network_service_ptr;
+        while (true) {
+          // wait until a request was queued
+          ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+          network_service->processRequests();
+        }
+      },
+      "network_task", 8192, this, 5, &m_network_task_handle);
+  Logger::info("Finished starting network task");
+  return true;
+}
+
+bool NetworkService::stopNetworkTask() {
+  if (m_network_task_handle == NULL) {
+    Logger::info("Network task not running");
+    return true;
+  }
+
+  vTaskDelete(m_network_task_handle);
+  m_network_task_handle = NULL;
+  return true;
+}
+
+bool NetworkService::get(const std::string &url, const std::string &token,
+                         RequestPriority priority, ResponseCallback callback,
+                         const std::string &accept, ResponseSink *sink) {
+  return send({.method = HTTP_METHOD_GET,
+               .url = url,
+               .token = token,
+               .content_type = "application/json",
+               .accept = accept,
+               .sink = sink},
+              priority, callback);
+}
+
+bool NetworkService::post(const std::string &url, const std::string &data,
+                          const std::string &token, RequestPriority priority,
+                          ResponseCallback callback,
+                          const std::string &content_type,
+                          const std::string &accept) {
+  return send({.method = HTTP_METHOD_POST,
+               .url = url,
+               .data = data,
+               .token = token,
+               .content_type = content_type,
+               .accept = accept,
+               .sink = nullptr},
+              priority, callback);
+}
+
+bool NetworkService::send(const HTTPRequest &request, RequestPriority priority,
+                          ResponseCallback callback) {
+  return submit({.request = request, .callbacks = {callback}}, priority);
+}
+
+HTTPResponse NetworkService::postAndWait(const std::string &url,
+                                         const std::string &data,
+                                         const std::string &token,
+                                         RequestPriority priority) {
+  HTTPResponse response = {0, ""};
+  SemaphoreHandle_t done = xSemaphoreCreateBinary();
+
+  if (!post(url, data, token, priority,
+            [&response, done](const HTTPResponse &result) {
+              response = result;
+              xSemaphoreGive(done);
+            })) {
+    vSemaphoreDelete(done);
+    return response;
+  }
+
+  xSemaphoreTake(done, portMAX_DELAY);
+  vSemaphoreDelete(done);
+  return response;
+}
+
+void NetworkService::logStatistics() { m_http_client->logStatistics(); }
+
+bool NetworkService::submit(NetworkRequest request, RequestPriority priority) {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+
+  // merge identical GET requests, the response is delivered to all callbacks
+  if (request.request.method == HTTP_METHOD_GET) {
+    auto is_duplicate = [&request](const NetworkRequest &other) {
+      const HTTPRequest &a = request.request;
+      const HTTPRequest &b = other.request;
+      return b.method == HTTP_METHOD_GET && b.url == a.url &&
+             b.token == a.token && b.accept == a.accept &&
+             b.if_none_match == a.if_none_match &&
+             b.if_modified_since == a.if_modified_since && b.sink == a.sink;
+    };
+
+    if (m_request_active && is_duplicate(m_active_request)) {
+      m_active_request.callbacks.push_back(request.callbacks.front());
+      xSemaphoreGive(m_mutex);
+      return true;
+    }
+
+    for (auto &queue : m_queues) {
+      for (auto &queued_request : queue) {
+        if (is_duplicate(queued_request)) {
+          queued_request.callbacks.push_back(request.callbacks.front());
+          xSemaphoreGive(m_mutex);
+          return true;
+        }
+      }
+    }
+  }
+
+  if (m_queues[priority].size() >= REQUEST_QUEUE_MAX_LENGTH) {
+    xSemaphoreGive(m_mutex);
+    Logger::error("Network request queue is full, dropping " +
+                  request.request.url);
+    return false;
+  }
+
+  m_queues[priority].push_back(std::move(request));
+  xSemaphoreGive(m_mutex);
+
+  if (m_network_task_handle != NULL) {
+    xTaskNotifyGive(m_network_task_handle);
+  }
+  return true;
+}
+
+bool NetworkService::takeNextRequest() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  for (auto &queue : m_queues) {
+    if (!queue.empty()) {
+      m_active_request = std::move(queue.front());
+      queue.pop_front();
+      m_request_active = true;
+      xSemaphoreGive(m_mutex);
+      return true;
+    }
+  }
+  xSemaphoreGive(m_mutex);
+  return false;
+}
+
+void NetworkService::processRequests() {
+  while (takeNextRequest()) {
+    // the active request is only modified by this task, submit only appends
+    // callbacks, so it can be read without holding the mutex
+    const HTTPResponse response =
+        m_http_client->request(m_active_request.request);
+
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    std::vector<ResponseCallback> callbacks =
+        std::move(m_active_request.callbacks);
+    m_request_active = false;
+    xSemaphoreGive(m_mutex);
+
+    for (auto &callback : callbacks) {
+      if (callback) {
+        callback(response);
+      }
+    }
+  }
+}
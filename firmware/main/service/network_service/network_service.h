@@ -0,0 +1,145 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "main/hal/http_client/http_client.h"
+
+//! @brief Priority of a network request, lower values are sent first
+enum RequestPriority {
+  PRIORITY_UPLOAD = 0,
+  PRIORITY_DISPLAY = 1,
+  PRIORITY_AUTH = 2
+};
+
+//! @brief Number of request priorities
+#define REQUEST_PRIORITIES 3
+
+//! @brief Maximum number of queued requests per priority
+#define REQUEST_QUEUE_MAX_LENGTH 8
+
+//! @brief Callback to receive the response of a network request
+using ResponseCallback = std::function<void(const HTTPResponse&)>;
+
+//! @brief A queued network request
+struct NetworkRequest {
+  //! @brief The http request
+  HTTPRequest request;
+  //! @brief The callbacks to notify, more than one if GET requests were merged
+  std::vector<ResponseCallback> callbacks;
+};
+
+//! @brief Service that owns the http client and sends all requests from a
+//! single network task over one keep alive connection.
+//! @note Queued requests are sent in order of their priority, identical GET
+//! requests that are queued or in flight are merged into one request.
+class NetworkService {
+ public:
+  //! @brief Constructor
+  //! @param http_client The http client
+  NetworkService(HTTPClient* http_client);
+
+  //! @brief Destructor
+  ~NetworkService();
+
+  //! @brief Start the network task
+  bool startNetworkTask();
+
+  //! @brief Stop the network task
+  bool stopNetworkTask();
+
+  //! @brief Queue a GET request.
+  //! @param url The URL to get the data from.
+  //! @param token The token to use for authentication, empty string if no token
+  //! is needed.
+  //! @param priority The request priority.
+  //! @param callback The callback to call with the response on the network
+  //! task.
+  //! @param accept The accepted response content types, empty string to omit
+  //! the Accept header.
+  //! @param sink The receiver of the response body, nullptr to collect the body
+  //! in the response. The body is streamed to the sink on the network task.
+  //! @return True if the request was queued, false if the queue is full.
+  bool get(const std::string& url, const std::string& token,
+           RequestPriority priority, ResponseCallback callback,
+           const std::string& accept = "", ResponseSink* sink = nullptr);
+
+  //! @brief Queue a POST request.
+  //! @param url The URL to post the data to.
+  //! @param data The data to post.
+  //! @param token The token to use for authentication, empty string if no token
+  //! is needed.
+  //! @param priority The request priority.
+  //! @param callback The callback to call with the response on the network
+  //! task.
+  //! @param content_type The content type of the data.
+  //! @param accept The accepted response content types, empty string to omit
+  //! the Accept header.
+  //! @return True if the request was queued, false if the queue is full.
+  bool post(const std::string& url, const std::string& data,
+            const std::string& token, RequestPriority priority,
+            ResponseCallback callback,
+            const std::string& content_type = "application/json",
+            const std::string& accept = "");
+
+  //! @brief Queue a request.
+  //! @param request The http request, a sink receives the body on the network
+  //! task.
+  //! @param priority The request priority.
+  //! @param callback The callback to call with the response on the network
+  //! task.
+  //! @return True if the request was queued, false if the queue is full.
+  bool send(const HTTPRequest& request, RequestPriority priority,
+            ResponseCallback callback);
+
+  //! @brief Queue a POST request and wait for its response.
+  //! @note Must not be called from a response callback.
+  //! @param url The URL to post the data to.
+  //! @param data The json data to post.
+  //! @param token The token to use for authentication, empty string if no token
+  //! is needed.
+  //! @param priority The request priority.
+  //! @return The http response, status code 0 if the request failed.
+  HTTPResponse postAndWait(const std::string& url, const std::string& data,
+                           const std::string& token, RequestPriority priority);
+
+  //! @brief Log the connection statistics of the http client.
+  void logStatistics();
+
+ private:
+  //! @brief Queue a request.
+  //! @param request The request to queue.
+  //! @param priority The request priority.
+  //! @return True if the request was queued, false if the queue is full.
+  bool submit(NetworkRequest request, RequestPriority priority);
+
+  //! @brief Take the next request with the highest priority from the queues.
+  //! @return True if a request was taken, false if all queues are empty.
+  bool takeNextRequest();
+
+  //! @brief Send all queued requests, called by the network task.
+  void processRequests();
+
+  //! @brief Pointer to the http client
+  HTTPClient* m_http_client;
+
+  //! @brief The queued requests, one queue per priority
+  std::deque<NetworkRequest> m_queues[REQUEST_PRIORITIES];
+
+  //! @brief The request currently sent by the network task
+  NetworkRequest m_active_request;
+
+  //! @brief Flag if a request is currently sent by the network task
+  bool m_request_active;
+
+  //! @brief The network task handle
+  TaskHandle_t m_network_task_handle;
+
+  //! @brief Mutex to protect the queues and the active request
+  SemaphoreHandle_t m_mutex;
+};
@@ -0,0 +1,127 @@
+#include "main/service/sample_buffer/sample_buffer.h"
+
+SampleBuffer::SampleBuffer(size_t capacity, DropPolicy drop_policy,
+                           SampleStorage* storage)
+    : m_samples(nullptr),
+      m_capacity(capacity),
+      m_drop_policy(drop_policy),
+      m_storage(storage),
+      m_head(0),
+      m_count(0),
+      m_dropped(0),
+      m_in_flight(0),
+      m_mutex(xSemaphoreCreateMutex()) {
+  if (!useStorage()) {
+    m_samples = new AirQualitySample[m_capacity];
+  }
+}
+
+SampleBuffer::~SampleBuffer() {
+  delete[] m_samples;
+  vSemaphoreDelete(m_mutex);
+}
+
+bool SampleBuffer::useStorage() {
+  return m_storage != nullptr && m_storage->isAvailable();
+}
+
+bool SampleBuffer::push(const AirQualitySample& sample) {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  if (useStorage()) {
+    const uint32_t dropped = m_storage->getDroppedCount();
+    const bool stored = m_storage->append(sample, m_drop_policy == DROP_OLDEST);
+    if (m_drop_policy == DROP_OLDEST) {
+      evictInFlight(m_storage->getDroppedCount() - dropped);
+    }
+    xSemaphoreGive(m_mutex);
+    return stored;
+  }
+
+  if (m_count == m_capacity) {
+    m_dropped++;
+    if (m_drop_policy == DROP_NEWEST) {
+      xSemaphoreGive(m_mutex);
+      return false;
+    }
+    m_head = (m_head + 1) % m_capacity;
+    m_count--;
+    evictInFlight(1);
+  }
+
+  m_samples[(m_head + m_count) % m_capacity] = sample;
+  m_count++;
+  xSemaphoreGive(m_mutex);
+  return true;
+}
+
+bool SampleBuffer::peek(size_t index, AirQualitySample* sample) {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const bool found = readSample(index, sample);
+  xSemaphoreGive(m_mutex);
+  return found;
+}
+
+size_t SampleBuffer::peekBatch(size_t max_count, AirQualitySample* samples) {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  size_t count = 0;
+  while (count < max_count && readSample(count, &samples[count])) {
+    count++;
+  }
+  m_in_flight = count;
+  xSemaphoreGive(m_mutex);
+  return count;
+}
+
+void SampleBuffer::pop(size_t count) {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  removeOldest(count);
+  xSemaphoreGive(m_mutex);
+}
+
+void SampleBuffer::popInFlight() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  removeOldest(m_in_flight);
+  m_in_flight = 0;
+  xSemaphoreGive(m_mutex);
+}
+
+bool SampleBuffer::readSample(size_t index, AirQualitySample* sample) {
+  if (useStorage()) {
+    return m_storage->read(index, sample);
+  }
+  if (index >= m_count) {
+    return false;
+  }
+  *sample = m_samples[(m_head + index) % m_capacity];
+  return true;
+}
+
+void SampleBuffer::removeOldest(size_t count) {
+  if (useStorage()) {
+    m_storage->consume(count);
+  } else {
+    count = count < m_count ? count : m_count;
+    m_head = (m_head + count) % m_capacity;
+    m_count -= count;
+  }
+  evictInFlight(count);
+}
+
+void SampleBuffer::evictInFlight(size_t count) {
+  m_in_flight -= count < m_in_flight ? count : m_in_flight;
+}
+
+size_t SampleBuffer::size() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const size_t count = useStorage() ? m_storage->size() : m_count;
+  xSemaphoreGive(m_mutex);
+  return count;
+}
+
+uint32_t SampleBuffer::getDroppedCount() {
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const uint32_t dropped =
+      useStorage() ? m_storage->getDroppedCount() : m_dropped;
+  xSemaphoreGive(m_mutex);
+  return dropped;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "main/hal/sample_storage/sample_storage.h"
+
+//! @brief What to drop if the sample buffer is full
+enum DropPolicy {
+  //! drop the oldest sample to make room for the new one
+  DROP_OLDEST = 0,
+  //! keep the buffered samples and drop the new one
+  DROP_NEWEST = 1
+};
+
+//! @brief Buffer of air quality samples that were not uploaded yet
+//! @note Without a flash storage the samples are kept in a fixed size RAM ring
+//! that is allocated once. If a flash storage is available it holds the
+//! samples instead, so the backlog survives a reboot.
+class SampleBuffer {
+ public:
+  //! @brief Constructor
+  //! @param capacity The number of samples of the RAM ring.
+  //! @param drop_policy What to drop if the buffer is full.
+  //! @param storage The flash storage, nullptr to buffer in RAM only.
+  SampleBuffer(size_t capacity, DropPolicy drop_policy,
+               SampleStorage* storage = nullptr);
+
+  //! @brief Destructor
+  ~SampleBuffer();
+
+  //! @brief Add a sample to the end of the buffer.
+  //! @param sample The sample to add.
+  //! @return True if the sample was buffered, false if it was dropped.
+  bool push(const AirQualitySample& sample);
+
+  //! @brief Read a buffered sample without removing it.
+  //! @param index The position of the sample, 0 is the oldest sample.
+  //! @param sample The sample to store the result in.
+  //! @return True if the sample was read, false otherwise.
+  bool peek(size_t index, AirQualitySample* sample);
+
+  //! @brief Remove the oldest samples.
+  //! @param count The number of samples to remove.
+  void pop(size_t count = 1);
+
+  //! @brief Read the oldest samples and mark them as being uploaded.
+  //! @note The samples are read and marked under one lock, so a sample
+  //! dropped by push() in between is never counted as uploaded. The marking
+  //! replaces the one of a previous batch.
+  //! @param max_count The maximum number of samples to read.
+  //! @param samples The array to store the samples in, at least max_count.
+  //! @return The number of samples read and marked.
+  size_t peekBatch(size_t max_count, AirQualitySample* samples);
+
+  //! @brief Remove the samples that were marked as being uploaded.
+  //! @note Samples dropped by push() in the meantime are not removed twice,
+  //! so newer samples that were not uploaded are kept.
+  void popInFlight();
+
+  //! @brief Get the number of buffered samples.
+  size_t size();
+
+  //! @brief Get the number of samples dropped because the buffer was full.
+  uint32_t getDroppedCount();
+
+ private:
+  //! @brief Check if the flash storage is used.
+  bool useStorage();
+
+  //! @brief Read a buffered sample, the mutex has to be taken.
+  //! @param index The position of the sample, 0 is the oldest sample.
+  //! @param sample The sample to store the result in.
+  //! @return True if the sample was read, false otherwise.
+  bool readSample(size_t index, AirQualitySample* sample);
+
+  //! @brief Remove the oldest samples, the mutex has to be taken.
+  //! @param count The number of samples to remove.
+  void removeOldest(size_t count);
+
+  //! @brief Forget the in flight samples that were dropped from the head.
+  //! @param count The number of samples dropped from the head.
+  void evictInFlight(size_t count);
+
+  //! @brief The RAM ring
+  AirQualitySample* m_samples;
+
+  //! @brief The number of samples of the RAM ring
+  const size_t m_capacity;
+
+  //! @brief What to drop if the buffer is full
+  const DropPolicy m_drop_policy;
+
+  //! @brief Pointer to the flash storage, nullptr if not used
+  SampleStorage* m_storage;
+
+  //! @brief Index of the oldest sample in the RAM ring
+  size_t m_head;
+
+  //! @brief Number of samples in the RAM ring
+  size_t m_count;
+
+  //! @brief Number of samples dropped from the RAM ring
+  uint32_t m_dropped;
+
+  //! @brief Number of the oldest samples that are being uploaded
+  size_t m_in_flight;
+
+  //! @brief Mutex to protect the buffer
+  SemaphoreHandle_t m_mutex;
+};
@@ -1,7 +1,27 @@
 #include "main/service/ui_service/ui_service.h"
 
+#include <algorithm>
+
 #include "main/logger/logger.h"
 
+//! @brief FNV-1a offset basis and prime of the 64 bit hash
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+//! @brief Add bytes to a FNV-1a hash
+//! @param hash The hash
+//! @param data The bytes
+//! @param len The number of bytes
+//! @return The updated hash
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t len) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
 UIService::UIService(EInk* eink, DataDownloadService* data_download_service,
                      HomeUI* home_ui, ImageUI* image_ui)
     : m_eink(eink),
@@ -9,9 +29,39 @@ UIService::UIService(EInk* eink, DataDownloadService* data_download_service,
       m_home_ui(home_ui),
       m_image_ui(image_ui),
       m_x_pos(0),
-      m_y_pos(0) {}
+      m_y_pos(0),
+      m_shown_data_version(0),
+      m_shown_x_pos(0),
+      m_prepare_task_handle(NULL),
+      m_mutex(xSemaphoreCreateMutex()) {}
 
-UIService::~UIService() {}
+UIService::~UIService() {
+  if (m_prepare_task_handle != NULL) {
+    m_data_download_service->notifyOnNewData(NULL);
+    vTaskDelete(m_prepare_task_handle);
+  }
+  vSemaphoreDelete(m_mutex);
+}
+
+bool UIService::startPrepareTask() {
+  if (m_prepare_task_handle != NULL) {
+    Logger::error("UI prepare task already running");
+    return false;
+  }
+
+  xTaskCreate(
+      [](void* ui_service_ptr) {
+        UIService* ui_service = (UIService*)ui_service_ptr;
+        while (true) {
+          // wait for new data or a move to another page
+          ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+          ui_service->prepareNeighbourPages();
+        }
+      },
+      "ui_prepare_task", 4096, this, 2, &m_prepare_task_handle);
+  m_data_download_service->notifyOnNewData(m_prepare_task_handle);
+  return true;
+}
 
 void UIService::show() {
   Logger::debug("Min: " + std::to_string(getMinXPos()) +
@@ -20,6 +70,14 @@ void UIService::show() {
   update();
 }
 
+void UIService::refresh() {
+  if (m_data_download_service->getDataVersion() == m_shown_data_version) {
+    Logger::debug("Air quality data unchanged, skipping refresh");
+    return;
+  }
+  show();
+}
+
 void UIService::moveLeft() {
   if (m_x_pos == getMinXPos()) {
     m_x_pos = getMaxXPos();
@@ -43,16 +101,106 @@ void UIService::moveRight() {
 }
 
 void UIService::update() {
-  if (m_x_pos == 0) {
-    m_home_ui->show();
-    return;
+  // the version is read first, data newer than the snapshot is only shown
+  // once more
+  m_shown_data_version = m_data_download_service->getDataVersion();
+  const auto snapshot = m_data_download_service->getAirQualityData();
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  m_shown_x_pos = m_x_pos;
+  const bool rendered = m_eink->render(getPage(m_x_pos, *snapshot));
+  xSemaphoreGive(m_mutex);
+
+  if (!rendered) {
+    Logger::debug("Screen unchanged, skipped " +
+                  std::to_string(m_eink->getSkippedRenders()) + " of " +
+                  std::to_string(m_eink->getRenders() +
+                                 m_eink->getSkippedRenders()) +
+                  " renders");
   }
-  m_home_ui->showSensorHome(m_x_pos - 1);
-};
+
+  if (m_prepare_task_handle != NULL) {
+    xTaskNotifyGive(m_prepare_task_handle);
+  }
+}
+
+void UIService::prepareNeighbourPages() {
+  const auto snapshot = m_data_download_service->getAirQualityData();
+  const int8_t min_x_pos = getMinXPos();
+  const int8_t max_x_pos = getMaxXPos();
+
+  xSemaphoreTake(m_mutex, portMAX_DELAY);
+  const int8_t x_pos = m_shown_x_pos;
+  xSemaphoreGive(m_mutex);
+
+  // the pages a gesture moves to, wrapping around like moveLeft and moveRight
+  const int8_t neighbours[] = {
+      x_pos <= min_x_pos ? max_x_pos : (int8_t)(x_pos - 1),
+      x_pos >= max_x_pos ? min_x_pos : (int8_t)(x_pos + 1)};
+  for (const int8_t neighbour : neighbours) {
+    // the mutex is released between the pages, so a gesture waits for one
+    // page at most
+    xSemaphoreTake(m_mutex, portMAX_DELAY);
+    getPage(neighbour, *snapshot);
+    xSemaphoreGive(m_mutex);
+  }
+}
+
+const DisplayList& UIService::getPage(int8_t x_pos,
+                                      const AirQualitySnapshot& data) {
+  const size_t page_count = std::max<size_t>(data.size() + 1, x_pos + 1);
+  if (m_pages.size() != page_count) {
+    m_pages.resize(page_count);
+  }
+
+  UIPage& page = m_pages[x_pos];
+  const uint64_t data_hash = getPageDataHash(x_pos, data);
+  if (!page.recorded || page.data_hash != data_hash) {
+    page.display_list.reset();
+    if (x_pos == 0) {
+      m_home_ui->recordHome(data, page.display_list);
+    } else {
+      m_home_ui->recordSensorHome(data, x_pos - 1, page.display_list);
+    }
+    page.data_hash = data_hash;
+    page.recorded = true;
+  }
+  return page.display_list;
+}
+
+uint64_t UIService::getPageDataHash(int8_t x_pos,
+                                    const AirQualitySnapshot& data) {
+  // the home page shows up to three devices, a sensor page one device or
+  // the screen without sensors
+  size_t first = 0;
+  size_t count = std::min<size_t>(data.size(), 3);
+  if (x_pos > 0) {
+    first = x_pos - 1;
+    count = first < data.size() ? 1 : 0;
+  }
+
+  uint64_t hash = FNV_OFFSET_BASIS;
+  hash = hashBytes(hash, &count, sizeof(count));
+  for (size_t i = first; i < first + count; i++) {
+    // the fields are hashed one by one, the padding of the struct is
+    // undefined
+    const AirQualityData air_data = data.get(i);
+    hash = hashBytes(hash, air_data.device_name.data(),
+                     air_data.device_name.size());
+    hash = hashBytes(hash, &air_data.temperature, sizeof(float));
+    hash = hashBytes(hash, &air_data.humidity, sizeof(float));
+    hash = hashBytes(hash, &air_data.pressure, sizeof(uint32_t));
+    hash = hashBytes(hash, &air_data.gas_resistance, sizeof(uint32_t));
+    hash = hashBytes(hash, &air_data.iaq, sizeof(float));
+    hash = hashBytes(hash, &air_data.co2_equivalent, sizeof(float));
+    hash = hashBytes(hash, &air_data.breath_voc_equivalent, sizeof(float));
+  }
+  return hash;
+}
 
 int8_t UIService::getMaxXPos() {
   // count of sensors + 1 for the home screen
-  return m_data_download_service->getAirQualityData().size();
+  return m_data_download_service->getAirQualityData()->size();
 }
 
 int8_t UIService::getMinXPos() { return 0; }
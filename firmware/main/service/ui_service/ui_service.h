@@ -1,12 +1,35 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "main/driver/eink/display_list.h"
 #include "main/driver/eink/eink.h"
 #include "main/service/data_download_service/data_download_service.h"
 #include "main/ui/home_ui/home_ui.h"
 #include "main/ui/image_ui/image_ui.h"
 
+//! @brief A prerendered page of the UI
+struct UIPage {
+  //! @brief The recorded screen of the page
+  DisplayList display_list;
+  //! @brief The hash of the air quality data the page was recorded from
+  uint64_t data_hash = 0;
+  //! @brief Flag if the page was recorded
+  bool recorded = false;
+};
+
+//! @brief Service that shows the pages of the UI
+//! @note Every page (the home screen and one screen per sensor) is recorded
+//! into its own display list, which is kept until the air quality data shown
+//! on that page changes. After a download or a move the prepare task records
+//! the neighbouring pages in the background, so a gesture only replays a
+//! prerendered page. The pages keep display lists rather than serialized
+//! frames, so EInk::render can still skip an unchanged screen or redraw only
+//! the changed texts.
 class UIService {
  public:
   //! @brief Constructor
@@ -20,9 +43,18 @@ class UIService {
   //! @brief Destructor
   ~UIService();
 
+  //! @brief Start the task preparing the neighbouring pages
+  //! @return True if the task was started, false otherwise
+  bool startPrepareTask();
+
   //! @brief Show the initial screen
   void show();
 
+  //! @brief Show the current screen again if the air quality data changed
+  //! @note The e-ink refresh is slow and power hungry, so it is skipped if
+  //! the screen would not change.
+  void refresh();
+
   //! @brief Move the screen to the left
   void moveLeft();
 
@@ -33,6 +65,27 @@ class UIService {
   //! @brief Update the display with the new position
   void update();
 
+  //! @brief Record the neighbouring pages of the shown page if their data
+  //! changed
+  //! @note Runs in the prepare task
+  void prepareNeighbourPages();
+
+  //! @brief Get a page, recorded again if the data shown on it changed
+  //! @note The mutex has to be held, the page is valid until it is released
+  //! @param x_pos The x position of the page
+  //! @param data The air quality data
+  //! @return The display list of the page
+  const DisplayList& getPage(int8_t x_pos, const AirQualitySnapshot& data);
+
+  //! @brief Get the hash of the air quality data shown on a page
+  //! @note FNV-1a over the devices of the page, a download that changes other
+  //! devices keeps the page
+  //! @param x_pos The x position of the page
+  //! @param data The air quality data
+  //! @return The hash of the data of the page
+  static uint64_t getPageDataHash(int8_t x_pos,
+                                  const AirQualitySnapshot& data);
+
   //! @brief Get the maximum x position
   //! @return The maximum x position
   int8_t getMaxXPos();
@@ -58,4 +111,19 @@ class UIService {
 
   //! @brief The y position of the current screen
   int8_t m_y_pos;
+
+  //! @brief The version of the air quality data that is shown
+  uint32_t m_shown_data_version;
+
+  //! @brief The prerendered pages, indexed by the x position
+  std::vector<UIPage> m_pages;
+
+  //! @brief The x position of the shown page, read by the prepare task
+  int8_t m_shown_x_pos;
+
+  //! @brief Handle of the prepare task
+  TaskHandle_t m_prepare_task_handle;
+
+  //! @brief Mutex to protect the pages
+  SemaphoreHandle_t m_mutex;
 };
@@ -1,203 +1,241 @@
 #include "main/ui/home_ui/home_ui.h"
 
-#include <iomanip>
-#include <sstream>
+#include <cmath>
+#include <cstdio>
 
 #include "main/logger/logger.h"
 
-HomeUI::HomeUI(EInk* eink, DataDownloadService* data_download_service)
-    : m_eink(eink), m_data_download_service(data_download_service) {}
+HomeUI::HomeUI() {}
 
 HomeUI::~HomeUI() {}
 
-void HomeUI::show() {
-  Logger::debug("Showing home screen");
-
-  auto data = m_data_download_service->getAirQualityData();
-  Logger::debug("Showing home screen with " + std::to_string(data.size()) +
+void HomeUI::recordHome(const AirQualitySnapshot& data,
+                        DisplayList& display_list) {
+  Logger::debug("Recording home screen with " + std::to_string(data.size()) +
                 " sensors");
   // switch data size to show the different screens
   switch (data.size()) {
     case 0:
-      showZeroSensorScreen();
+      showZeroSensorScreen(display_list);
       break;
     case 1:
-      showOneSensorScreen(data[0]);
+      showOneSensorScreen(data.get(0), display_list);
       break;
     case 2:
-      showTwoSensorScreen(data[0], data[1]);
+      showTwoSensorScreen(data.get(0), data.get(1), display_list);
       break;
     case 3:
-      showThreeSensorScreen(data[0], data[1], data[2]);
+      showThreeSensorScreen(data.get(0), data.get(1), data.get(2),
+                            display_list);
       break;
     default:
-      showThreeSensorScreen(data[0], data[1], data[2]);
+      showThreeSensorScreen(data.get(0), data.get(1), data.get(2),
+                            display_list);
       break;
   }
 }
 
-void HomeUI::showSensorHome(const uint8_t sensor_id) {
-  Logger::debug("Showing home screen with sensor " + std::to_string(sensor_id));
-  auto data = m_data_download_service->getAirQualityData()[sensor_id];
-  showOneSensorScreen(data);
+void HomeUI::recordSensorHome(const AirQualitySnapshot& data,
+                              const uint8_t sensor_id,
+                              DisplayList& display_list) {
+  Logger::debug("Recording home screen with sensor " +
+                std::to_string(sensor_id));
+  if (sensor_id >= data.size()) {
+    showZeroSensorScreen(display_list);
+    return;
+  }
+  showOneSensorScreen(data.get(sensor_id), display_list);
 }
 
-void HomeUI::showZeroSensorScreen() {
-  m_eink->clearDisplay();
-  m_eink->drawBitmap(0, 0, "serror.bmp");
-  m_eink->updateDisplay();
+void HomeUI::showZeroSensorScreen(DisplayList& display_list) {
+  display_list.clearDisplay();
+  display_list.drawBitmap(0, 0, "serror.bmp");
+  display_list.updateDisplay();
 }
 
-void HomeUI::showOneSensorScreen(const AirQualityData& air_data) {
-  m_eink->clearDisplay();
+void HomeUI::showOneSensorScreen(const AirQualityData& air_data,
+                                 DisplayList& display_list) {
+  display_list.clearDisplay();
 
-  m_eink->drawBitmap(0, 0, "homeone.bmp");
+  display_list.drawBitmap(0, 0, "homeone.bmp");
 
   // draw the sensor name
-  m_eink->setFontSize(FontSize::LARGE);
+  display_list.setFontSize(FontSize::LARGE);
 
   // calucate size of text, large means 30 px per character
-  uint16_t text_width = air_data.device_name.size() * 30;
+  uint16_t text_width =
+      air_data.device_name.size() * EInk::getFontAdvance(FontSize::LARGE);
 
   // place text in the middle of the display
   uint16_t x = (800 - text_width) / 2;
   uint16_t y = 0;
 
-  m_eink->drawText(x, y, air_data.device_name);
+  display_list.drawText(x, y, air_data.device_name);
 
   // draw the temperature
-  m_eink->setFontSize(FontSize::LARGE);
-
-  m_eink->drawText(250, 140, convertFloatToString(air_data.temperature, 2));
-  m_eink->drawText(250, 265, convertFloatToString(air_data.humidity, 2));
-  m_eink->drawText(250, 390, std::to_string(air_data.pressure));
-  m_eink->drawText(250, 517, std::to_string(air_data.gas_resistance));
+  display_list.setFontSize(FontSize::LARGE);
+
+  display_list.drawText(250, 140,
+                        convertFloatToString(air_data.temperature, 2));
+  display_list.drawText(250, 265, convertFloatToString(air_data.humidity, 2));
+  display_list.drawText(250, 390, std::to_string(air_data.pressure));
+  display_list.drawText(250, 517, std::to_string(air_data.gas_resistance));
+
+  // draw the estimates of devices running BSEC in the right column
+  if (!std::isnan(air_data.iaq)) {
+    display_list.setFontSize(FontSize::MEDIUM);
+    display_list.drawText(560, 140,
+                          "IAQ " + convertFloatToString(air_data.iaq, 0));
+    display_list.drawText(
+        560, 265, "CO2 " + convertFloatToString(air_data.co2_equivalent, 0));
+    display_list.drawText(
+        560, 390,
+        "VOC " + convertFloatToString(air_data.breath_voc_equivalent, 2));
+  }
 
-  m_eink->updateDisplay();
+  display_list.updateDisplay();
 }
 
 void HomeUI::showTwoSensorScreen(const AirQualityData& air_data1,
-                                 const AirQualityData& air_data2) {
-  m_eink->clearDisplay();
+                                 const AirQualityData& air_data2,
+                                 DisplayList& display_list) {
+  display_list.clearDisplay();
 
-  m_eink->drawBitmap(0, 0, "hometwo.bmp");
+  display_list.drawBitmap(0, 0, "hometwo.bmp");
 
   // draw first sensor name
-  m_eink->setFontSize(FontSize::LARGE);
+  display_list.setFontSize(FontSize::LARGE);
 
   // calucate size of text, large means 30 px per character
-  uint16_t text_width = air_data1.device_name.size() * 30;
+  uint16_t text_width =
+      air_data1.device_name.size() * EInk::getFontAdvance(FontSize::LARGE);
 
   // place text in the middle of the display
   uint16_t x = (400 - text_width) / 2;
   uint16_t y = 0;
 
-  m_eink->drawText(x, y, air_data1.device_name);
+  display_list.drawText(x, y, air_data1.device_name);
 
   // draw second sensor name
-  text_width = air_data2.device_name.size() * 30;
+  text_width =
+      air_data2.device_name.size() * EInk::getFontAdvance(FontSize::LARGE);
   x = 410 + (400 - text_width) / 2;
-  m_eink->drawText(x, y, air_data2.device_name);
+  display_list.drawText(x, y, air_data2.device_name);
 
   // draw the temperature of the first sensor
-  m_eink->drawText(170, 140, convertFloatToString(air_data1.temperature, 2));
-  m_eink->drawText(170, 265, convertFloatToString(air_data1.humidity, 2));
-  m_eink->drawText(170, 390, std::to_string(air_data1.pressure));
+  display_list.drawText(170, 140,
+                        convertFloatToString(air_data1.temperature, 2));
+  display_list.drawText(170, 265, convertFloatToString(air_data1.humidity, 2));
+  display_list.drawText(170, 390, std::to_string(air_data1.pressure));
 
   if (air_data1.gas_resistance > 99999) {
-    m_eink->drawText(170, 517, std::to_string(air_data1.gas_resistance / 1000));
-    m_eink->drawText(280, 517, "k");
+    display_list.drawText(170, 517,
+                          std::to_string(air_data1.gas_resistance / 1000));
+    display_list.drawText(280, 517, "k");
   } else {
-    m_eink->drawText(170, 517, std::to_string(air_data1.gas_resistance));
+    display_list.drawText(170, 517, std::to_string(air_data1.gas_resistance));
   }
 
   // draw the temperature of the second sensor
-  m_eink->drawText(570, 140, convertFloatToString(air_data2.temperature, 2));
-  m_eink->drawText(570, 265, convertFloatToString(air_data2.humidity, 2));
-  m_eink->drawText(570, 390, std::to_string(air_data2.pressure));
+  display_list.drawText(570, 140,
+                        convertFloatToString(air_data2.temperature, 2));
+  display_list.drawText(570, 265, convertFloatToString(air_data2.humidity, 2));
+  display_list.drawText(570, 390, std::to_string(air_data2.pressure));
 
   if (air_data2.gas_resistance > 99999) {
-    m_eink->drawText(570, 517, std::to_string(air_data2.gas_resistance / 1000));
-    m_eink->drawText(680, 517, "k");
+    display_list.drawText(570, 517,
+                          std::to_string(air_data2.gas_resistance / 1000));
+    display_list.drawText(680, 517, "k");
   } else {
-    m_eink->drawText(570, 517, std::to_string(air_data2.gas_resistance));
+    display_list.drawText(570, 517, std::to_string(air_data2.gas_resistance));
   }
 
-  m_eink->updateDisplay();
+  display_list.updateDisplay();
 }
 
 void HomeUI::showThreeSensorScreen(const AirQualityData& air_data1,
                                    const AirQualityData& air_data2,
-                                   const AirQualityData& air_data3) {
-  m_eink->clearDisplay();
+                                   const AirQualityData& air_data3,
+                                   DisplayList& display_list) {
+  display_list.clearDisplay();
 
-  m_eink->drawBitmap(0, 0, "hometh.bmp");
+  display_list.drawBitmap(0, 0, "hometh.bmp");
 
   // draw first sensor name
-  m_eink->setFontSize(FontSize::MEDIUM);
+  display_list.setFontSize(FontSize::MEDIUM);
 
   // calucate size of text, medium means 15 px per character
-  uint16_t text_width = air_data1.device_name.size() * 15;
+  uint16_t text_width =
+      air_data1.device_name.size() * EInk::getFontAdvance(FontSize::MEDIUM);
 
   // place text in the middle of the display
   uint16_t x = ((250 - text_width) / 2) - 30;
   uint16_t y = 0;
 
-  m_eink->drawText(x, y, air_data1.device_name);
+  display_list.drawText(x, y, air_data1.device_name);
 
   // draw second sensor name
-  text_width = air_data2.device_name.size() * 15;
+  text_width =
+      air_data2.device_name.size() * EInk::getFontAdvance(FontSize::MEDIUM);
   x = 240 + (250 - text_width) / 2;
-  m_eink->drawText(x, y, air_data2.device_name);
+  display_list.drawText(x, y, air_data2.device_name);
 
   // draw third sensor name
-  text_width = air_data3.device_name.size() * 15;
+  text_width =
+      air_data3.device_name.size() * EInk::getFontAdvance(FontSize::MEDIUM);
   x = 500 + (250 - text_width) / 2;
-  m_eink->drawText(x, y, air_data3.device_name);
+  display_list.drawText(x, y, air_data3.device_name);
 
-  m_eink->setFontSize(FontSize::LARGE);
+  display_list.setFontSize(FontSize::LARGE);
 
   // draw the temperature of the first sensor
-  m_eink->drawText(20, 140, convertFloatToString(air_data1.temperature, 2));
-  m_eink->drawText(20, 265, convertFloatToString(air_data1.humidity, 2));
-  m_eink->drawText(20, 390, std::to_string(air_data1.pressure));
+  display_list.drawText(20, 140,
+                        convertFloatToString(air_data1.temperature, 2));
+  display_list.drawText(20, 265, convertFloatToString(air_data1.humidity, 2));
+  display_list.drawText(20, 390, std::to_string(air_data1.pressure));
 
   if (air_data1.gas_resistance > 99999) {
-    m_eink->drawText(20, 517, std::to_string(air_data1.gas_resistance / 1000));
-    m_eink->drawText(140, 517, "k");
+    display_list.drawText(20, 517,
+                          std::to_string(air_data1.gas_resistance / 1000));
+    display_list.drawText(140, 517, "k");
   } else {
-    m_eink->drawText(20, 517, std::to_string(air_data1.gas_resistance));
+    display_list.drawText(20, 517, std::to_string(air_data1.gas_resistance));
   }
 
   // draw the temperature of the second sensor
-  m_eink->drawText(285, 140, convertFloatToString(air_data2.temperature, 2));
-  m_eink->drawText(285, 265, convertFloatToString(air_data2.humidity, 2));
-  m_eink->drawText(285, 390, std::to_string(air_data2.pressure));
+  display_list.drawText(285, 140,
+                        convertFloatToString(air_data2.temperature, 2));
+  display_list.drawText(285, 265, convertFloatToString(air_data2.humidity, 2));
+  display_list.drawText(285, 390, std::to_string(air_data2.pressure));
 
   if (air_data2.gas_resistance > 99999) {
-    m_eink->drawText(285, 517, std::to_string(air_data2.gas_resistance / 1000));
-    m_eink->drawText(405, 517, "k");
+    display_list.drawText(285, 517,
+                          std::to_string(air_data2.gas_resistance / 1000));
+    display_list.drawText(405, 517, "k");
   } else {
-    m_eink->drawText(285, 517, std::to_string(air_data2.gas_resistance));
+    display_list.drawText(285, 517, std::to_string(air_data2.gas_resistance));
   }
 
   // draw the temperature of the third sensor
-  m_eink->drawText(555, 140, convertFloatToString(air_data3.temperature, 2));
-  m_eink->drawText(555, 265, convertFloatToString(air_data3.humidity, 2));
-  m_eink->drawText(555, 390, std::to_string(air_data3.pressure));
+  display_list.drawText(555, 140,
+                        convertFloatToString(air_data3.temperature, 2));
+  display_list.drawText(555, 265, convertFloatToString(air_data3.humidity, 2));
+  display_list.drawText(555, 390, std::to_string(air_data3.pressure));
 
   if (air_data3.gas_resistance > 99999) {
-    m_eink->drawText(555, 517, std::to_string(air_data3.gas_resistance / 1000));
-    m_eink->drawText(675, 517, "k");
+    display_list.drawText(555, 517,
+                          std::to_string(air_data3.gas_resistance / 1000));
+    display_list.drawText(675, 517, "k");
   } else {
-    m_eink->drawText(555, 517, std::to_string(air_data3.gas_resistance));
+    display_list.drawText(555, 517, std::to_string(air_data3.gas_resistance));
   }
 
-  m_eink->updateDisplay();
+  display_list.updateDisplay();
 }
 
 std::string HomeUI::convertFloatToString(float value, uint8_t precision) {
-  std::stringstream float_str;
-  float_str << std::fixed << std::setprecision(precision) << value;
-  return float_str.str();
+  // the short result fits into the string without a heap allocation
+  char float_str[16];
+  snprintf(float_str, sizeof(float_str), "%.*f", precision, value);
+  return float_str;
 }
\ No newline at end of file
@@ -1,59 +1,63 @@
 #pragma once
 
-#include <map>
 #include <string>
 
-#include "main/driver/eink/eink.h"
-#include "main/service/data_download_service/data_download_service.h"
+#include "main/driver/eink/display_list.h"
+#include "main/service/data_download_service/air_quality_store.h"
 
+//! @brief Records the home screens into display lists
 class HomeUI {
  public:
   //! @brief Constructor
-  //! @param eink The eink driver
-  //! @param data_download_service The data download service
-  HomeUI(EInk* eink, DataDownloadService* data_download_service);
+  HomeUI();
 
   //! @brief Destructor
   ~HomeUI();
 
-  //! @brief Show the home screen.
-  void show();
+  //! @brief Record the home screen.
+  //! @param data The air quality data
+  //! @param display_list The display list to record into
+  void recordHome(const AirQualitySnapshot& data, DisplayList& display_list);
 
-  //! @brief Show the home screen with the given sensor.
-  //! @param sensor_name The sensor id
-  void showSensorHome(const uint8_t sensor_id);
+  //! @brief Record the home screen with the given sensor.
+  //! @param data The air quality data
+  //! @param sensor_id The sensor id
+  //! @param display_list The display list to record into
+  void recordSensorHome(const AirQualitySnapshot& data,
+                        const uint8_t sensor_id, DisplayList& display_list);
 
  private:
-  //! @brief Show the home screen with zero sensors.
-  void showZeroSensorScreen();
+  //! @brief Record the home screen with zero sensors.
+  //! @param display_list The display list to record into
+  void showZeroSensorScreen(DisplayList& display_list);
 
-  //! @brief Show the home screen with one sensor.
+  //! @brief Record the home screen with one sensor.
   //! @param air_data The air quality data
-  void showOneSensorScreen(const AirQualityData& air_data);
+  //! @param display_list The display list to record into
+  void showOneSensorScreen(const AirQualityData& air_data,
+                           DisplayList& display_list);
 
-  //! @brief Show the home screen with two sensors.
+  //! @brief Record the home screen with two sensors.
   //! @param air_data1 The first air quality data
   //! @param air_data2 The second air quality data
+  //! @param display_list The display list to record into
   void showTwoSensorScreen(const AirQualityData& air_data1,
-                           const AirQualityData& air_data2);
+                           const AirQualityData& air_data2,
+                           DisplayList& display_list);
 
-  //! @brief Show the home screen with three sensors.
+  //! @brief Record the home screen with three sensors.
   //! @param air_data1 The first air quality data
   //! @param air_data2 The second air quality data
   //! @param air_data3 The third air quality data
+  //! @param display_list The display list to record into
   void showThreeSensorScreen(const AirQualityData& air_data1,
                              const AirQualityData& air_data2,
-                             const AirQualityData& air_data3);
+                             const AirQualityData& air_data3,
+                             DisplayList& display_list);
 
   //! @brief Convert a float to a string with the given precision.
   //! @param value The float value
   //! @param precision The precision
   //! @return The string representation of the float
   std::string convertFloatToString(float value, uint8_t precision);
-
-  //! @brief Pointer to the eink driver
-  EInk* m_eink;
-
-  //! @brief Pointer to the data download service
-  DataDownloadService* m_data_download_service;
 };
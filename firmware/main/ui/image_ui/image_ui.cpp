@@ -1,26 +1,49 @@
 #include "main/ui/image_ui/image_ui.h"
 
+#include <string>
+
 #include "main/logger/logger.h"
 
+//! @brief Frames drawing the images, encoded at compile time
+static constexpr auto SETUP_FRAME = encodeEInkBitmapFrame(0, 0, "setup.bmp");
+static constexpr auto CONNECTING_FRAME =
+    encodeEInkBitmapFrame(0, 0, "conn.bmp");
+static constexpr auto WRONG_WIFI_CREDENTIALS_FRAME =
+    encodeEInkBitmapFrame(0, 0, "fwifi.bmp");
+static constexpr auto WRONG_DEVICE_TOKEN_FRAME =
+    encodeEInkBitmapFrame(0, 0, "ftoken.bmp");
+static constexpr auto CONNECTED_FRAME =
+    encodeEInkBitmapFrame(0, 0, "connf.bmp");
+static constexpr auto STARTUP_FRAME = encodeEInkBitmapFrame(0, 0, "load.bmp");
+
 ImageUI::ImageUI(EInk* eink) : m_eink(eink) {}
 
 ImageUI::~ImageUI() {}
 
-void ImageUI::showSetupScreen() { showImageOnly("setup.bmp"); }
+template <size_t N>
+void ImageUI::showImageOnly(const std::array<uint8_t, N>& bitmap_frame) {
+  // the filename follows the header, the command and the coordinates
+  Logger::debug(
+      "Show Image: " +
+      std::string(reinterpret_cast<const char*>(bitmap_frame.data()) + 8,
+                  N - 13));
+  m_eink->clearDisplay();
+  m_eink->sendFrame(bitmap_frame.data(), bitmap_frame.size());
+  m_eink->updateDisplay();
+}
 
-void ImageUI::showConnectingScreen() { showImageOnly("conn.bmp"); }
+void ImageUI::showSetupScreen() { showImageOnly(SETUP_FRAME); }
 
-void ImageUI::showWrongWifiCredentialsScreen() { showImageOnly("fwifi.bmp"); }
+void ImageUI::showConnectingScreen() { showImageOnly(CONNECTING_FRAME); }
 
-void ImageUI::showWrongDeviceTokenScreen() { showImageOnly("ftoken.bmp"); }
+void ImageUI::showWrongWifiCredentialsScreen() {
+  showImageOnly(WRONG_WIFI_CREDENTIALS_FRAME);
+}
 
-void ImageUI::showConnectedScreen() { showImageOnly("connf.bmp"); }
+void ImageUI::showWrongDeviceTokenScreen() {
+  showImageOnly(WRONG_DEVICE_TOKEN_FRAME);
+}
 
-void ImageUI::showStartupScreen() { showImageOnly("load.bmp"); }
+void ImageUI::showConnectedScreen() { showImageOnly(CONNECTED_FRAME); }
 
-void ImageUI::showImageOnly(const std::string& image_name) {
-  Logger::debug("Show Image: " + image_name);
-  m_eink->clearDisplay();
-  m_eink->drawBitmap(0, 0, image_name);
-  m_eink->updateDisplay();
-}
\ No newline at end of file
+void ImageUI::showStartupScreen() { showImageOnly(STARTUP_FRAME); }
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <string>
+#include <array>
+#include <cstdint>
 
 #include "main/driver/eink/eink.h"
 
@@ -31,9 +32,11 @@ class ImageUI {
   void showStartupScreen();
 
  private:
-  //! @brief Show the image with the given name and update the display
-  //! @param image_name The name of the image to show
-  void showImageOnly(const std::string& image_name);
+  //! @brief Show the image of a bitmap frame and update the display
+  //! @param bitmap_frame The frame drawing the image, see
+  //! encodeEInkBitmapFrame
+  template <size_t N>
+  void showImageOnly(const std::array<uint8_t, N>& bitmap_frame);
 
   //! @brief Pointer to the eink driver
   EInk* m_eink;
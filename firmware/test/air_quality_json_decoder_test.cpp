@@ -0,0 +1,170 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "allocation_counter.h"
+#include "main/service/data_download_service/air_quality_json_decoder.h"
+#include "test.h"
+
+//! @brief A response with escapes, unknown members and devices without BSEC
+static const char RESPONSE[] =
+    "[{\"id\":\"65f0c2a1b3d4e5f6a7b8c9d0\",\"device\":\"Living \\\"room\\\"\","
+    "\"temperature\":21.5,\"humidity\":45.25,\"pressure\":101325,"
+    "\"gasResistance\":120000,\"iaq\":42.5,\"co2Equivalent\":612.5,"
+    "\"breathVocEquivalent\":0.75,\"owner\":\"x\",\"n\":-1},"
+    " {\"device\":\"Kitchen \\u00e4\", \"temperature\":-3e-1,"
+    "\"humidity\":50,\"pressure\":99000,\"gasResistance\":80000,"
+    "\"iaq\":null,\"co2Equivalent\":null,\"breathVocEquivalent\":null},\n"
+    "{\"id\":\"65f0c2a1b3d4e5f6a7b8c9d1\",\"device\":\"Bedroom\","
+    "\"temperature\":19,\"humidity\":60.5,\"pressure\":100500,"
+    "\"gasResistance\":90000,\"seen\":true}]";
+
+static bool decode(AirQualityJsonDecoder& decoder, AirQualityStore* store,
+                   const std::string& response, size_t chunk_size) {
+  decoder.begin(store);
+  for (size_t offset = 0; offset < response.size(); offset += chunk_size) {
+    const size_t length = std::min(chunk_size, response.size() - offset);
+    if (!decoder.feed(response.data() + offset, length)) {
+      return false;
+    }
+  }
+  return decoder.finish();
+}
+
+static bool sameData(const AirQualityData& a, const AirQualityData& b) {
+  const auto same = [](float x, float y) {
+    return x == y || (std::isnan(x) && std::isnan(y));
+  };
+  return a.device_key == b.device_key && a.device_id == b.device_id &&
+         a.device_name == b.device_name &&
+         a.temperature == b.temperature && a.humidity == b.humidity &&
+         a.pressure == b.pressure && a.gas_resistance == b.gas_resistance &&
+         same(a.iaq, b.iaq) && same(a.co2_equivalent, b.co2_equivalent) &&
+         same(a.breath_voc_equivalent, b.breath_voc_equivalent);
+}
+
+static void checkResponse(const AirQualityStore& store) {
+  CHECK(store.size() == 3);
+  const AirQualityData living_room = store.get(0);
+  CHECK(living_room.device_name == "Living \"room\"");
+  CHECK(living_room.device_id == "65f0c2a1b3d4e5f6a7b8c9d0");
+  CHECK(living_room.device_key ==
+        AirQualityStore::getDeviceKey("65f0c2a1b3d4e5f6a7b8c9d0"));
+  CHECK(living_room.iaq == 42.5f);
+  CHECK(living_room.pressure == 101325);
+
+  const AirQualityData kitchen = store.get(1);
+  CHECK(kitchen.device_name == "Kitchen \xc3\xa4");
+  CHECK(kitchen.device_id == kitchen.device_name);
+  CHECK(kitchen.device_key ==
+        AirQualityStore::getDeviceKey(kitchen.device_name));
+  CHECK(kitchen.temperature == -0.3f);
+  CHECK(std::isnan(kitchen.iaq));
+  CHECK(std::isnan(kitchen.breath_voc_equivalent));
+
+  const AirQualityData bedroom = store.get(2);
+  CHECK(bedroom.device_name == "Bedroom");
+  CHECK(std::isnan(bedroom.co2_equivalent));
+}
+
+// the chunks of the http client end anywhere, also inside of tokens
+static void testArbitraryChunkBoundaries() {
+  static AirQualityJsonDecoder decoder;
+  static AirQualityStore reference;
+  static AirQualityStore store;
+  const std::string response = RESPONSE;
+  CHECK(decode(decoder, &reference, response, response.size()));
+  checkResponse(reference);
+
+  for (size_t chunk_size = 1; chunk_size <= response.size(); chunk_size++) {
+    CHECK(decode(decoder, &store, response, chunk_size));
+    CHECK(store.size() == reference.size());
+    for (size_t i = 0; i < store.size(); i++) {
+      CHECK(sameData(store.get(i), reference.get(i)));
+    }
+  }
+
+  // one split at every position
+  for (size_t split = 0; split <= response.size(); split++) {
+    decoder.begin(&store);
+    CHECK(decoder.feed(response.data(), split));
+    CHECK(decoder.feed(response.data() + split, response.size() - split));
+    CHECK(decoder.finish());
+    checkResponse(store);
+  }
+}
+
+static void testInvalidResponses() {
+  static AirQualityJsonDecoder decoder;
+  static AirQualityStore store;
+  const std::string response = RESPONSE;
+  CHECK(!decode(decoder, &store, response.substr(0, response.size() - 1), 7));
+  CHECK(!decode(decoder, &store, "{\"device\":\"a\"}", 3));
+  CHECK(!decode(decoder, &store, "[{\"device\":\"a\",\"humidity\":1}]", 5));
+  CHECK(!decode(decoder, &store, "[{\"device\":1}]", 2));
+}
+
+// two devices whose ids share a key stay two devices and keep their order
+static void testCollidingIds() {
+  static AirQualityJsonDecoder decoder;
+  static AirQualityStore previous;
+  static AirQualityStore store;
+  const char* first_id = "65f0c2a1b3d4e5f6a704698b";
+  const char* second_id = "65f0c2a1b3d4e5f6a70858b8";
+  CHECK(AirQualityStore::getDeviceKey(first_id) ==
+        AirQualityStore::getDeviceKey(second_id));
+
+  const auto element = [](const char* id, const char* device) {
+    return std::string("{\"id\":\"") + id + "\",\"device\":\"" + device +
+           "\",\"temperature\":21.5,\"humidity\":45,\"pressure\":101325,"
+           "\"gasResistance\":120000}";
+  };
+  CHECK(decode(decoder, &previous,
+               "[" + element(first_id, "Living") + "," +
+                   element(second_id, "Kitchen") + "]",
+               16));
+  CHECK(previous.size() == 2);
+  CHECK(previous.find(first_id) == 0);
+  CHECK(previous.find(second_id) == 1);
+
+  CHECK(decode(decoder, &store,
+               "[" + element(second_id, "Kitchen") + "," +
+                   element(first_id, "Living") + "]",
+               16));
+  store.keepOrderOf(previous);
+  CHECK(store.get(0).device_name == "Living");
+  CHECK(store.get(1).device_name == "Kitchen");
+}
+
+// the memory use must not grow with the size of the response
+static void testNoAllocationsPerDevice() {
+  static AirQualityJsonDecoder decoder;
+  static AirQualityStore store;
+  std::string response = "[";
+  for (int i = 0; i < AIR_QUALITY_STORE_CAPACITY; i++) {
+    response += std::string(i > 0 ? "," : "") + "{\"id\":\"device" +
+                std::to_string(i) + "\",\"device\":\"Room number " +
+                std::to_string(i) +
+                "\",\"temperature\":21.5,\"humidity\":45,\"pressure\":101325,"
+                "\"gasResistance\":120000}";
+  }
+  response += "]";
+
+  CHECK(decode(decoder, &store, response, 16));
+  const size_t allocations = getAllocationCount();
+  CHECK(decode(decoder, &store, response, 16));
+  CHECK(store.size() == AIR_QUALITY_STORE_CAPACITY);
+  std::printf("%zu bytes in %d devices decoded with %zu allocations\n",
+              response.size(), AIR_QUALITY_STORE_CAPACITY,
+              getAllocationCount() - allocations);
+  CHECK(getAllocationCount() == allocations);
+}
+
+int main() {
+  testArbitraryChunkBoundaries();
+  testInvalidResponses();
+  testCollidingIds();
+  testNoAllocationsPerDevice();
+  std::printf("air_quality_json_decoder_test passed\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "allocation_counter.h"
+#include "main/service/data_download_service/air_quality_store.h"
+#include "test.h"
+
+//! @brief The air quality data as it was kept before the store, in a map
+//! keyed by the position of the device in the response
+struct MapAirQualityData {
+  std::string device_name;
+  float temperature;
+  float humidity;
+  uint32_t pressure;
+  uint32_t gas_resistance;
+  float iaq;
+  float co2_equivalent;
+  float breath_voc_equivalent;
+};
+
+using AirQualityMap = std::map<uint32_t, MapAirQualityData>;
+
+static constexpr int DEVICES = AIR_QUALITY_STORE_CAPACITY;
+static constexpr int CYCLES = 20000;
+
+static std::string s_ids[DEVICES];
+static std::string s_names[DEVICES];
+
+static volatile float s_sink;
+
+static double elapsedMicros(std::chrono::steady_clock::time_point start) {
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / CYCLES;
+}
+
+// one download of the map: decode into a new map, publish it by copy, the ui
+// copies it once more for every read
+static void downloadIntoMap(AirQualityMap* published, int cycle) {
+  AirQualityMap decoded;
+  for (int i = 0; i < DEVICES; i++) {
+    decoded[i] = {s_names[i], 21.5f + cycle % 7, 45.0f, 101325, 120000,
+                  42.5f, 612.5f, 0.75f};
+  }
+  *published = decoded;
+}
+
+static float readMapPages(const AirQualityMap& published) {
+  float sum = 0;
+  for (int page = 0; page < DEVICES; page++) {
+    const AirQualityMap snapshot = published;
+    sum += snapshot.at(page).temperature + snapshot.size();
+  }
+  return sum;
+}
+
+// one download of the store as the data download service does it
+static void downloadIntoStore(AirQualityStore* decoded,
+                              std::shared_ptr<const AirQualityStore>* published,
+                              int cycle) {
+  decoded->clear();
+  for (int i = 0; i < DEVICES; i++) {
+    decoded->add(s_ids[i], s_names[i], 21.5f + cycle % 7, 45.0f, 101325,
+                 120000, 42.5f, 612.5f, 0.75f);
+  }
+  decoded->keepOrderOf(**published);
+  *published = std::make_shared<const AirQualityStore>(*decoded);
+}
+
+static float readStorePages(
+    const std::shared_ptr<const AirQualityStore>& published) {
+  float sum = 0;
+  for (int page = 0; page < DEVICES; page++) {
+    const auto snapshot = published;
+    sum += snapshot->get(page).temperature + snapshot->size();
+  }
+  return sum;
+}
+
+int main() {
+  for (int i = 0; i < DEVICES; i++) {
+    s_ids[i] = "65f0c2a1b3d4e5f6a7b8c9" + std::to_string(10 + i);
+    s_names[i] = "Sensor in room number " + std::to_string(i);
+  }
+
+  AirQualityMap map;
+  size_t allocations = getAllocationCount();
+  auto start = std::chrono::steady_clock::now();
+  for (int cycle = 0; cycle < CYCLES; cycle++) {
+    downloadIntoMap(&map, cycle);
+  }
+  const double map_download = elapsedMicros(start);
+  const double map_download_allocations =
+      (double)(getAllocationCount() - allocations) / CYCLES;
+
+  allocations = getAllocationCount();
+  start = std::chrono::steady_clock::now();
+  for (int cycle = 0; cycle < CYCLES; cycle++) {
+    s_sink = readMapPages(map);
+  }
+  const double map_pages = elapsedMicros(start);
+  const double map_pages_allocations =
+      (double)(getAllocationCount() - allocations) / CYCLES;
+
+  static AirQualityStore decoded;
+  auto store = std::make_shared<const AirQualityStore>();
+  allocations = getAllocationCount();
+  start = std::chrono::steady_clock::now();
+  for (int cycle = 0; cycle < CYCLES; cycle++) {
+    downloadIntoStore(&decoded, &store, cycle);
+  }
+  const double store_download = elapsedMicros(start);
+  const double store_download_allocations =
+      (double)(getAllocationCount() - allocations) / CYCLES;
+
+  allocations = getAllocationCount();
+  start = std::chrono::steady_clock::now();
+  for (int cycle = 0; cycle < CYCLES; cycle++) {
+    s_sink = readStorePages(store);
+  }
+  const double store_pages = elapsedMicros(start);
+  const double store_pages_allocations =
+      (double)(getAllocationCount() - allocations) / CYCLES;
+
+  // both hold the same data
+  CHECK(map.size() == store->size());
+  for (int i = 0; i < DEVICES; i++) {
+    CHECK(store->get(i).device_name == map.at(i).device_name);
+    CHECK(store->get(i).temperature == map.at(i).temperature);
+  }
+
+  std::printf("%d devices, %d downloads\n", DEVICES, CYCLES);
+  std::printf("%-6s %14s %14s %14s %14s\n", "", "download us",
+              "allocations", "all pages us", "allocations");
+  std::printf("%-6s %14.2f %14.1f %14.2f %14.1f\n", "map", map_download,
+              map_download_allocations, map_pages, map_pages_allocations);
+  std::printf("%-6s %14.2f %14.1f %14.2f %14.1f\n", "store", store_download,
+              store_download_allocations, store_pages,
+              store_pages_allocations);
+  std::printf("sizeof(AirQualityStore) %zu bytes\n", sizeof(AirQualityStore));
+
+  // the store allocates only the published snapshot
+  CHECK(store_download_allocations == 1);
+  CHECK(store_pages_allocations == 0);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> s_allocations(0);
+
+size_t getAllocationCount() { return s_allocations; }
+
+void* operator new(size_t size) {
+  s_allocations++;
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete[](void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+//! @brief Get the number of heap allocations since the start of the test
+//! @note Counts the calls of the global operator new, link
+//! allocation_counter.cpp into the test to use it.
+size_t getAllocationCount();
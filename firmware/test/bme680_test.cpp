@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+
+#include "driver/i2c.h"
+#include "esp_timer.h"
+#include "main/driver/bme680/bme680.h"
+#include "main/hal/i2c/i2c.h"
+#include "test.h"
+
+//! @brief Calibration of the simulated sensor
+static constexpr uint16_t PAR_T1 = 26000;
+static constexpr int16_t PAR_T2 = 26300;
+static constexpr int8_t PAR_T3 = 3;
+static constexpr uint16_t PAR_P1 = 36000;
+
+//! @brief Raw values of every measurement
+static constexpr uint32_t ADC_TEMPERATURE = 486170;
+static constexpr uint32_t ADC_PRESSURE = 464944;
+static constexpr uint16_t ADC_GAS = 512;
+static constexpr uint8_t GAS_RANGE = 4;
+
+//! @brief Gas range of the first step of a heater profile, every further
+//! step uses the next range, so the resistance tells the steps apart
+static constexpr uint8_t PROFILE_GAS_RANGE = 9;
+
+//! @brief A BME680 register map that measures in forced, sequential and
+//! parallel mode
+//! @note The registers are written in pairs of address and value and read
+//! in bursts that increment the address, as on the real sensor. Sequential
+//! and parallel mode cycle through the steps of the heater profile until the
+//! sensor is put to sleep, every step is written to the next of the three
+//! data fields and overwrites the step measured three steps before.
+class SimulatedBME680 : public I2CStubDevice {
+ public:
+  SimulatedBME680() { reset(); }
+
+  esp_err_t write(const uint8_t* data, size_t len) override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_failing) {
+      return ESP_FAIL;
+    }
+    update();
+    m_pointer = data[0];
+    for (size_t i = 0; i + 1 < len; i += 2) {
+      writeRegister(data[i], data[i + 1]);
+    }
+    return ESP_OK;
+  }
+
+  esp_err_t read(uint8_t* data, size_t len) override {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_failing) {
+      return ESP_FAIL;
+    }
+    update();
+    for (size_t i = 0; i < len; i++) {
+      data[i] = m_registers[m_pointer++];
+    }
+    return ESP_OK;
+  }
+
+  //! @brief Set the duration of a measurement or a step of a heater profile,
+  //! negative to never finish
+  void setConversionTime(int64_t us) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // the steps measured so far are kept
+    update();
+    m_conversion_us = us;
+  }
+
+  //! @brief Stop acknowledging its address
+  void setFailing(bool failing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failing = failing;
+  }
+
+  //! @brief Get the number of started measurements
+  int getMeasurements() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_measurements;
+  }
+
+  //! @brief Get the operation mode of the sensor
+  uint8_t getMode() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    update();
+    return m_registers[BME68X_REG_CTRL_MEAS] & BME68X_MODE_MSK;
+  }
+
+ private:
+  void reset() {
+    for (uint8_t& reg : m_registers) {
+      reg = 0;
+    }
+    m_registers[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    m_registers[BME68X_REG_VARIANT_ID] = BME68X_VARIANT_GAS_LOW;
+    // the calibration indexes count from the first coefficient register
+    const auto coefficient = [this](int index) -> uint8_t& {
+      if (index < BME68X_LEN_COEFF1) {
+        return m_registers[BME68X_REG_COEFF1 + index];
+      }
+      return m_registers[BME68X_REG_COEFF2 + index - BME68X_LEN_COEFF1];
+    };
+    coefficient(BME68X_IDX_T1_LSB) = PAR_T1 & 0xFF;
+    coefficient(BME68X_IDX_T1_MSB) = PAR_T1 >> 8;
+    coefficient(BME68X_IDX_T2_LSB) = PAR_T2 & 0xFF;
+    coefficient(BME68X_IDX_T2_MSB) = PAR_T2 >> 8;
+    coefficient(BME68X_IDX_T3) = PAR_T3;
+    coefficient(BME68X_IDX_P1_LSB) = PAR_P1 & 0xFF;
+    coefficient(BME68X_IDX_P1_MSB) = PAR_P1 >> 8;
+    m_measurement_start = -1;
+  }
+
+  void writeRegister(uint8_t reg, uint8_t value) {
+    if (reg == BME68X_REG_SOFT_RESET && value == BME68X_SOFT_RESET_CMD) {
+      reset();
+      return;
+    }
+    m_registers[reg] = value;
+    if (reg != BME68X_REG_CTRL_MEAS) {
+      return;
+    }
+    m_measurement_start = -1;
+    const uint8_t mode = value & BME68X_MODE_MSK;
+    if (mode == BME68X_SLEEP_MODE) {
+      return;
+    }
+    m_measurement_start = esp_timer_get_time();
+    m_sub_measurements = 0;
+    m_measurements++;
+    for (int field = 0; field < 3; field++) {
+      m_registers[BME68X_REG_FIELD0 + field * BME68X_LEN_FIELD] &=
+          ~BME68X_NEW_DATA_MSK;
+    }
+  }
+
+  // completes the running measurement or the steps of the heater profile
+  // whose time passed
+  void update() {
+    const uint8_t mode = m_registers[BME68X_REG_CTRL_MEAS] & BME68X_MODE_MSK;
+    while (m_measurement_start >= 0 && m_conversion_us >= 0 &&
+           esp_timer_get_time() - m_measurement_start >= m_conversion_us) {
+      if (mode == BME68X_FORCED_MODE) {
+        writeField(0, m_measurements, 0, GAS_RANGE);
+        // forced mode returns to sleep after one measurement
+        m_registers[BME68X_REG_CTRL_MEAS] &= ~BME68X_MODE_MSK;
+        m_measurement_start = -1;
+        return;
+      }
+      const int steps =
+          std::max(1, m_registers[BME68X_REG_CTRL_GAS_1] & BME68X_NBCONV_MSK);
+      const uint8_t step = m_sub_measurements % steps;
+      writeField(m_sub_measurements % 3, m_sub_measurements, step,
+                 PROFILE_GAS_RANGE + step);
+      m_sub_measurements++;
+      m_measurement_start += m_conversion_us;
+    }
+  }
+
+  void writeField(int index, uint8_t meas_index, uint8_t gas_index,
+                  uint8_t gas_range) {
+    uint8_t* field = &m_registers[BME68X_REG_FIELD0 + index * BME68X_LEN_FIELD];
+    field[0] = BME68X_NEW_DATA_MSK | gas_index;
+    field[1] = meas_index;
+    field[2] = (ADC_PRESSURE >> 12) & 0xFF;
+    field[3] = (ADC_PRESSURE >> 4) & 0xFF;
+    field[4] = (ADC_PRESSURE << 4) & 0xFF;
+    field[5] = (ADC_TEMPERATURE >> 12) & 0xFF;
+    field[6] = (ADC_TEMPERATURE >> 4) & 0xFF;
+    field[7] = (ADC_TEMPERATURE << 4) & 0xFF;
+    field[13] = (ADC_GAS >> 2) & 0xFF;
+    field[14] = ((ADC_GAS << 6) & 0xFF) | BME68X_GASM_VALID_MSK |
+                BME68X_HEAT_STAB_MSK | gas_range;
+  }
+
+  std::mutex m_mutex;
+  uint8_t m_registers[256];
+  uint8_t m_pointer = 0;
+  int64_t m_measurement_start = -1;
+  int64_t m_conversion_us = 100000;
+  bool m_failing = false;
+  int m_measurements = 0;
+  int m_sub_measurements = 0;
+};
+
+static void checkResults(BME680& bme680) {
+  // the compensation of the datasheet with the simulated calibration
+  const float var1 = (ADC_TEMPERATURE / 16384.0f - PAR_T1 / 1024.0f) * PAR_T2;
+  const float var2 = std::pow(ADC_TEMPERATURE / 131072.0f - PAR_T1 / 8192.0f,
+                              2.0f) *
+                     PAR_T3 * 16.0f;
+  const float temperature = (var1 + var2) / 5120.0f;
+  const float pressure = (1048576.0f - ADC_PRESSURE) * 6250.0f / PAR_P1;
+  const float gas = 1.0f / (1.25e-7f * (1 << GAS_RANGE) * 1.001f);
+
+  CHECK(std::fabs(bme680.getTemperature() - temperature) < 0.01f);
+  CHECK(std::fabs(bme680.getPressure() - pressure) < 2.0f);
+  CHECK(std::fabs(bme680.getGas() - gas) < gas * 0.001f);
+
+  // the default heater profile has a single step
+  uint32_t resistances[BME680_HEATER_PROFILE_MAX_STEPS];
+  CHECK(bme680.getGasResistances(resistances,
+                                 BME680_HEATER_PROFILE_MAX_STEPS) == 1);
+  CHECK(resistances[0] == bme680.getGas());
+}
+
+//! @brief Gas resistance of the simulated sensor in a gas range
+static float getGasOfRange(uint8_t gas_range) {
+  return 1.0f / (1.25e-7f * (1 << gas_range));
+}
+
+//! @brief Duration of a step of the simulated heater profiles, shorter than
+//! the driver calculates, so the step is measured when it is polled
+static constexpr int64_t PROFILE_STEP_US = 30000;
+
+//! @brief Poll a measurement like a scheduler until it is no longer pending
+static BME680::ReadingState pollUntilDone(BME680& bme680) {
+  BME680::ReadingState state = BME680::READING_PENDING;
+  while (state == BME680::READING_PENDING) {
+    const int remaining_millis = bme680.remainingReadingMillis();
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(std::max(remaining_millis, 1)));
+    state = bme680.pollReading();
+  }
+  return state;
+}
+
+//! @brief Check the gas resistance of every step of a heater profile
+//! @param missed_step A step that was not measured, -1 if all were
+static void checkSteps(BME680& bme680, size_t steps, int missed_step) {
+  uint32_t resistances[BME680_HEATER_PROFILE_MAX_STEPS];
+  CHECK(bme680.getGasResistances(resistances,
+                                 BME680_HEATER_PROFILE_MAX_STEPS) == steps);
+  for (size_t step = 0; step < steps; step++) {
+    if ((int)step == missed_step) {
+      CHECK(resistances[step] == 0);
+      continue;
+    }
+    const float gas = getGasOfRange(PROFILE_GAS_RANGE + step);
+    CHECK(std::fabs(resistances[step] - gas) < gas * 0.001f);
+  }
+
+  // a caller with less room gets the first steps
+  uint32_t first_step;
+  CHECK(bme680.getGasResistances(&first_step, 1) == 1);
+  CHECK(first_step == resistances[0]);
+}
+
+//! @brief Restore the forced mode heater of the other tests
+static void resetHeaterProfile(BME680& bme680) {
+  const uint16_t temperature = 320;
+  const uint16_t duration = 150;
+  CHECK(bme680.setHeaterProfile(BME68X_FORCED_MODE, &temperature, &duration,
+                                1));
+}
+
+// a scheduler keeps running other work while the sensor measures
+static void testReadingDoesNotBlock(SimulatedBME680& sensor, BME680& bme680) {
+  sensor.setConversionTime(100000);
+  const int64_t start = esp_timer_get_time();
+  const int64_t deadline = bme680.beginReading();
+  const int64_t begin_duration = esp_timer_get_time() - start;
+  CHECK(deadline > start);
+
+  // polling before the deadline does not touch the bus
+  const uint32_t transactions = i2c_stub_get_transactions();
+  CHECK(bme680.pollReading() == BME680::READING_PENDING);
+  CHECK(bme680.beginReading() == deadline);
+  CHECK(i2c_stub_get_transactions() == transactions);
+
+  int64_t longest_poll = 0;
+  int other_work = 0;
+  BME680::ReadingState state = BME680::READING_PENDING;
+  while (state == BME680::READING_PENDING) {
+    const int64_t poll_start = esp_timer_get_time();
+    state = bme680.pollReading();
+    longest_poll = std::max(longest_poll, esp_timer_get_time() - poll_start);
+    other_work++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const int64_t done = esp_timer_get_time();
+
+  std::printf("measurement of %lld us, begin took %lld us, longest poll "
+              "%lld us, %d scheduler iterations\n",
+              (long long)(deadline - start), (long long)begin_duration,
+              (long long)longest_poll, other_work);
+  CHECK(state == BME680::READING_DONE);
+  CHECK(done >= deadline);
+  CHECK(done - deadline < 20000);
+  CHECK(begin_duration < 20000);
+  CHECK(longest_poll < 20000);
+  CHECK(other_work > 50);
+  checkResults(bme680);
+}
+
+// the sensor finishes later than calculated
+static void testLateMeasurement(SimulatedBME680& sensor, BME680& bme680) {
+  const int64_t start = esp_timer_get_time();
+  const int64_t deadline = bme680.beginReading();
+  sensor.setConversionTime(deadline - start + 200000);
+
+  int64_t longest_poll = 0;
+  BME680::ReadingState state = BME680::READING_PENDING;
+  while (state == BME680::READING_PENDING) {
+    const int64_t poll_start = esp_timer_get_time();
+    state = bme680.pollReading();
+    longest_poll = std::max(longest_poll, esp_timer_get_time() - poll_start);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  std::printf("late measurement, longest poll %lld us\n",
+              (long long)longest_poll);
+  CHECK(state == BME680::READING_DONE);
+  CHECK(esp_timer_get_time() - deadline >= 200000);
+  CHECK(longest_poll < 20000);
+  checkResults(bme680);
+}
+
+// a measurement that never finishes is given up and the next one works
+static void testMeasurementTimeout(SimulatedBME680& sensor, BME680& bme680) {
+  sensor.setConversionTime(-1);
+  const int64_t deadline = bme680.beginReading();
+  BME680::ReadingState state = BME680::READING_PENDING;
+  while (state == BME680::READING_PENDING) {
+    state = bme680.pollReading();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(state == BME680::READING_FAILED);
+  CHECK(esp_timer_get_time() - deadline >= BME680_READING_TIMEOUT_MS * 1000);
+  CHECK(bme680.pollReading() == BME680::READING_FAILED);
+
+  sensor.setConversionTime(50000);
+  CHECK(bme680.readData());
+  checkResults(bme680);
+}
+
+static void testBusFailure(SimulatedBME680& sensor, BME680& bme680) {
+  sensor.setFailing(true);
+  CHECK(bme680.beginReading() == 0);
+  CHECK(bme680.pollReading() == BME680::READING_FAILED);
+  sensor.setFailing(false);
+
+  CHECK(bme680.beginReading() != 0);
+  sensor.setFailing(true);
+  while (bme680.remainingReadingMillis() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(bme680.pollReading() == BME680::READING_FAILED);
+  sensor.setFailing(false);
+  CHECK(bme680.readData());
+}
+
+// the deadlines stay valid after 2^32 microseconds of uptime
+static void testLongUptime(SimulatedBME680& sensor, BME680& bme680) {
+  esp_timer_stub_advance(INT64_C(1) << 32);
+  sensor.setConversionTime(50000);
+  const int64_t start = esp_timer_get_time();
+  const int64_t deadline = bme680.beginReading();
+  CHECK(deadline > start);
+  CHECK(deadline - start < 1000000);
+  CHECK(bme680.remainingReadingMillis() > 0);
+  CHECK(bme680.remainingReadingMillis() <= (deadline - start + 999) / 1000);
+  CHECK(bme680.readData());
+}
+
+// more steps than data fields are read when every step is polled in time
+static void testSequentialProfile(SimulatedBME680& sensor, BME680& bme680) {
+  const uint16_t temperatures[] = {200, 250, 300, 350};
+  const uint16_t durations[] = {10, 10, 10, 10};
+  CHECK(bme680.setHeaterProfile(BME68X_SEQUENTIAL_MODE, temperatures,
+                                durations, 4));
+  sensor.setConversionTime(PROFILE_STEP_US);
+
+  const int64_t start = esp_timer_get_time();
+  const int64_t deadline = bme680.beginReading();
+  CHECK(deadline > start);
+  CHECK(sensor.getMode() == BME68X_SEQUENTIAL_MODE);
+  CHECK(pollUntilDone(bme680) == BME680::READING_DONE);
+  CHECK(esp_timer_get_time() - deadline < BME680_READING_TIMEOUT_MS * 1000);
+  checkSteps(bme680, 4, -1);
+
+  // the sensor keeps measuring the profile until it is put to sleep
+  CHECK(sensor.getMode() == BME68X_SLEEP_MODE);
+  CHECK(bme680.remainingReadingMillis() == BME680::reading_not_started);
+  resetHeaterProfile(bme680);
+}
+
+static void testParallelProfile(SimulatedBME680& sensor, BME680& bme680) {
+  const uint16_t temperatures[] = {250, 300, 350};
+  const uint16_t multipliers[] = {1, 1, 1};
+  CHECK(bme680.setHeaterProfile(BME68X_PARALLEL_MODE, temperatures,
+                                multipliers, 3, 10));
+  sensor.setConversionTime(PROFILE_STEP_US);
+
+  CHECK(bme680.beginReading() != 0);
+  CHECK(sensor.getMode() == BME68X_PARALLEL_MODE);
+  CHECK(pollUntilDone(bme680) == BME680::READING_DONE);
+  checkSteps(bme680, 3, -1);
+  CHECK(sensor.getMode() == BME68X_SLEEP_MODE);
+  resetHeaterProfile(bme680);
+}
+
+// the first step is overwritten by the fourth before it is polled, the next
+// cycle of the profile measures it again
+static void testOverwrittenStep(SimulatedBME680& sensor, BME680& bme680) {
+  const uint16_t temperatures[] = {200, 250, 300, 350};
+  const uint16_t durations[] = {10, 10, 10, 10};
+  CHECK(bme680.setHeaterProfile(BME68X_SEQUENTIAL_MODE, temperatures,
+                                durations, 4));
+  sensor.setConversionTime(PROFILE_STEP_US);
+
+  CHECK(bme680.beginReading() != 0);
+  std::this_thread::sleep_for(
+      std::chrono::microseconds(4 * PROFILE_STEP_US + PROFILE_STEP_US / 2));
+  CHECK(bme680.pollReading() == BME680::READING_PENDING);
+  CHECK(pollUntilDone(bme680) == BME680::READING_DONE);
+  checkSteps(bme680, 4, -1);
+  CHECK(sensor.getMode() == BME68X_SLEEP_MODE);
+  resetHeaterProfile(bme680);
+}
+
+// the sensor stops after the first step was overwritten, the measurement
+// times out with the steps that were read
+static void testMissedStepTimeout(SimulatedBME680& sensor, BME680& bme680) {
+  const uint16_t temperatures[] = {200, 250, 300, 350};
+  const uint16_t durations[] = {10, 10, 10, 10};
+  CHECK(bme680.setHeaterProfile(BME68X_SEQUENTIAL_MODE, temperatures,
+                                durations, 4));
+  sensor.setConversionTime(PROFILE_STEP_US);
+
+  const int64_t deadline = bme680.beginReading();
+  CHECK(deadline != 0);
+  std::this_thread::sleep_for(
+      std::chrono::microseconds(4 * PROFILE_STEP_US + PROFILE_STEP_US / 2));
+  sensor.setConversionTime(-1);
+  CHECK(pollUntilDone(bme680) == BME680::READING_DONE);
+  CHECK(esp_timer_get_time() - deadline >= BME680_READING_TIMEOUT_MS * 1000);
+  checkSteps(bme680, 4, 0);
+  CHECK(sensor.getMode() == BME68X_SLEEP_MODE);
+  CHECK(bme680.pollReading() == BME680::READING_FAILED);
+
+  resetHeaterProfile(bme680);
+  sensor.setConversionTime(50000);
+  CHECK(bme680.readData());
+  checkResults(bme680);
+}
+
+int main() {
+  static SimulatedBME680 sensor;
+  i2c_stub_attach(BME68X_DEFAULT_ADDRESS, &sensor);
+  I2C i2c(21, 22, 1000);
+  BME680 bme680(&i2c);
+
+  testReadingDoesNotBlock(sensor, bme680);
+  testLateMeasurement(sensor, bme680);
+  testMeasurementTimeout(sensor, bme680);
+  testBusFailure(sensor, bme680);
+  testLongUptime(sensor, bme680);
+  testSequentialProfile(sensor, bme680);
+  testParallelProfile(sensor, bme680);
+  testOverwrittenStep(sensor, bme680);
+  testMissedStepTimeout(sensor, bme680);
+  std::printf("%d measurements, bme680_test passed\n",
+              sensor.getMeasurements());
+  return EXIT_SUCCESS;
+}
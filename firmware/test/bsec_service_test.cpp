@@ -0,0 +1,213 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+
+#include "esp_timer.h"
+#include "main/config.h"
+#include "main/driver/bme680/libs/bsec_interface.h"
+#include "main/service/bsec_service/bsec_service.h"
+#include "test.h"
+
+// Starts and stops the BSEC service against a fake library that records when
+// a task is inside it. The state must never be read while the BSEC task
+// processes a sample, the real library is not reentrant.
+
+//! @brief Time the fake library asks to be called again, long enough that a
+//! stop has to wake the task
+static constexpr int64_t NEXT_CALL_NS = INT64_C(1000000000);
+
+//! @brief Time the fake library spends processing a sample
+static constexpr int PROCESSING_MS = 20;
+
+static std::map<std::string, std::string> s_nvs;
+
+//! @brief Number of tasks inside the library
+static std::atomic<int> s_in_library(0);
+
+//! @brief Number of tasks inside bsec_do_steps
+static std::atomic<int> s_processing(0);
+
+//! @brief Number of processed samples
+static std::atomic<int> s_samples(0);
+
+//! @brief Number of times the state was read while the library was in use
+static std::atomic<int> s_overlapping_reads(0);
+
+//! @brief Number of calls to the library
+static std::atomic<int> s_calls(0);
+
+//! @brief Marks the time a task spends inside the library
+class LibraryCall {
+ public:
+  LibraryCall() {
+    s_calls++;
+    s_in_library++;
+  }
+  ~LibraryCall() { s_in_library--; }
+};
+
+bsec_library_return_t bsec_init() { return BSEC_OK; }
+
+bsec_library_return_t bsec_update_subscription(
+    const bsec_sensor_configuration_t*, uint8_t,
+    bsec_sensor_configuration_t*, uint8_t* n_required_sensor_settings) {
+  *n_required_sensor_settings = 0;
+  return BSEC_OK;
+}
+
+bsec_library_return_t bsec_sensor_control(int64_t time_stamp,
+                                          bsec_bme_settings_t* settings) {
+  LibraryCall call;
+  settings->next_call = time_stamp + NEXT_CALL_NS;
+  settings->op_mode = BME68X_FORCED_MODE;
+  settings->trigger_measurement = 1;
+  settings->run_gas = 1;
+  settings->heater_temperature = 320;
+  settings->heater_duration = 150;
+  settings->process_data = BSEC_PROCESS_TEMPERATURE | BSEC_PROCESS_HUMIDITY |
+                           BSEC_PROCESS_PRESSURE | BSEC_PROCESS_GAS;
+  return BSEC_OK;
+}
+
+bsec_library_return_t bsec_do_steps(const bsec_input_t*, uint8_t,
+                                    bsec_output_t* outputs,
+                                    uint8_t* n_outputs) {
+  LibraryCall call;
+  s_processing++;
+  std::this_thread::sleep_for(std::chrono::milliseconds(PROCESSING_MS));
+  s_processing--;
+  s_samples++;
+  outputs[0] = {};
+  outputs[0].sensor_id = BSEC_OUTPUT_IAQ;
+  outputs[0].signal = 50.0f;
+  *n_outputs = 1;
+  return BSEC_OK;
+}
+
+bsec_library_return_t bsec_set_state(const uint8_t*, uint32_t, uint8_t*,
+                                     uint32_t) {
+  return BSEC_OK;
+}
+
+bsec_library_return_t bsec_get_state(uint8_t, uint8_t* serialized_state,
+                                     uint32_t, uint8_t*, uint32_t,
+                                     uint32_t* n_serialized_state) {
+  if (s_in_library > 0) {
+    s_overlapping_reads++;
+  }
+  LibraryCall call;
+  std::memcpy(serialized_state, "bsec", 4);
+  *n_serialized_state = 4;
+  return BSEC_OK;
+}
+
+NonVolatileStorage::NonVolatileStorage() : m_initialized(true) {}
+
+NonVolatileStorage::~NonVolatileStorage() {}
+
+bool NonVolatileStorage::getBlob(const std::string& namespace_name,
+                                 const std::string& key, void* data,
+                                 size_t* length) {
+  const auto entry = s_nvs.find(namespace_name + "/" + key);
+  if (entry == s_nvs.end() || entry->second.size() > *length) {
+    return false;
+  }
+  std::memcpy(data, entry->second.data(), entry->second.size());
+  *length = entry->second.size();
+  return true;
+}
+
+bool NonVolatileStorage::setBlob(const std::string& namespace_name,
+                                 const std::string& key, const void* data,
+                                 size_t length) {
+  s_nvs[namespace_name + "/" + key] =
+      std::string(static_cast<const char*>(data), length);
+  return true;
+}
+
+BME680::BME680(I2C*) {}
+
+BME680::~BME680() {}
+
+bool BME680::setOversampling(uint8_t, uint8_t, uint8_t) { return true; }
+
+bool BME680::setHeaterProfile(uint8_t, const uint16_t*, const uint16_t*,
+                              uint8_t, uint16_t) {
+  return true;
+}
+
+int64_t BME680::beginReading() { return esp_timer_get_time() + 1; }
+
+int BME680::remainingReadingMillis() { return 0; }
+
+BME680::ReadingState BME680::pollReading() { return READING_DONE; }
+
+float BME680::getTemperature() { return 21.5f; }
+
+float BME680::getHumidity() { return 45.5f; }
+
+float BME680::getPressure() { return 101325; }
+
+uint32_t BME680::getGas() { return 120000; }
+
+//! @brief Wait until a condition holds, at most a second
+template <typename Condition>
+static bool waitUntil(Condition condition) {
+  for (int i = 0; i < 1000 && !condition(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return condition();
+}
+
+// a stop while the task processes a sample waits for the sample, so the state
+// is read after the library returned
+static void testStopWhileProcessing(BsecService* bsec_service) {
+  CHECK(bsec_service->startBsecTask());
+  CHECK(bsec_service->isRunning());
+  CHECK(waitUntil([] { return s_processing > 0; }));
+
+  CHECK(bsec_service->stopBsecTask());
+  CHECK(!bsec_service->isRunning());
+  CHECK(s_in_library == 0);
+  CHECK(s_overlapping_reads == 0);
+  CHECK(s_nvs.count(std::string(STORAGE_USERCONFIG) + "/" + KEY_BSECSTATE));
+
+  // the stopped task does not call the library again
+  const int calls = s_calls;
+  std::this_thread::sleep_for(std::chrono::milliseconds(PROCESSING_MS * 3));
+  CHECK(s_calls == calls);
+}
+
+// a stop while the task sleeps until the next call of the library wakes it
+static void testStopWhileSleeping(BsecService* bsec_service) {
+  s_samples = 0;
+  CHECK(bsec_service->startBsecTask());
+  CHECK(waitUntil([] { return s_samples > 0 && s_in_library == 0; }));
+
+  const auto start = std::chrono::steady_clock::now();
+  CHECK(bsec_service->stopBsecTask());
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  std::printf("stop of a sleeping task took %lld ms\n",
+              (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+                  elapsed)
+                  .count());
+  CHECK(elapsed < std::chrono::nanoseconds(NEXT_CALL_NS / 4));
+  CHECK(s_overlapping_reads == 0);
+}
+
+int main() {
+  BME680 bme680(nullptr);
+  NonVolatileStorage non_volatile_storage;
+  BsecService bsec_service(&bme680, &non_volatile_storage);
+
+  CHECK(bsec_service.stopBsecTask());
+  for (int i = 0; i < 5; i++) {
+    testStopWhileProcessing(&bsec_service);
+    testStopWhileSleeping(&bsec_service);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,387 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "main/config.h"
+#include "main/hal/sample_storage/sample_storage.h"
+#include "main/hal/timer/timer.h"
+#include "main/service/data_service/data_service.h"
+#include "main/service/sample_buffer/sample_buffer.h"
+#include "spi_flash_mmu.h"
+#include "test.h"
+
+// The data service, the network service, the sample buffer and the flash
+// storage are the firmware code, the http client, the sensor, the clock and
+// the NVS are replaced by the fakes below.
+
+//! @brief Unix time of the first boot of the tests
+#define FIRST_BOOT_TIME 1700000000
+
+//! @brief Seconds between two cycles of the upload task
+#define CYCLE_S 10
+
+//! @brief URL of the request that waits for the network task
+#define SENTINEL_URL "sentinel"
+
+//! @brief Unix time of the current boot
+static std::atomic<uint32_t> s_boot_time(FIRST_BOOT_TIME);
+
+//! @brief Flag if the clock was synchronized in the current boot
+static std::atomic<bool> s_clock_synced(false);
+
+//! @brief Flag if the backend is reachable
+static std::atomic<bool> s_backend_up(false);
+
+//! @brief Flag if the next measurements fail
+static std::atomic<bool> s_measurement_fails(false);
+
+//! @brief Flag if the http client holds the uploads back
+static std::atomic<bool> s_hold_uploads(false);
+
+//! @brief Number of upload requests the http client sent
+static std::atomic<size_t> s_upload_requests(0);
+
+//! @brief Guards the recorded timestamps
+static std::mutex s_mutex;
+
+//! @brief Timestamps of the started measurements
+static std::vector<uint32_t> s_measured;
+
+//! @brief Timestamps of the samples the backend accepted
+static std::vector<uint32_t> s_uploaded;
+
+//! @brief Values stored in the NVS by namespace and key
+static std::map<std::string, std::string> s_nvs;
+
+//! @brief Get the unix time of the current boot
+static uint32_t getNow() {
+  return s_boot_time + static_cast<uint32_t>(esp_timer_get_time() / 1000000);
+}
+
+uint32_t Timer::getUnixTime() { return s_clock_synced ? getNow() : 0; }
+
+//! @brief Create a response without a body
+static HTTPResponse respond(int status_code,
+                            const std::string& content_type = "") {
+  HTTPResponse response;
+  response.httpStatusCode = status_code;
+  response.content_type = content_type;
+  return response;
+}
+
+HTTPClient::HTTPClient(bool keep_alive) : m_keep_alive(keep_alive) {}
+
+HTTPClient::~HTTPClient() {}
+
+void HTTPClient::logStatistics() {}
+
+HTTPResponse HTTPClient::request(const HTTPRequest& request) {
+  if (request.url == SENTINEL_URL) {
+    return respond(200);
+  }
+  while (s_hold_uploads) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  s_upload_requests++;
+  if (!s_backend_up) {
+    return respond(0);
+  }
+  if (request.content_type == CBOR_CONTENT_TYPE) {
+    return respond(415);
+  }
+
+  // every sample of an upload must carry its unix time
+  const std::string& body = request.data;
+  size_t samples = 0;
+  for (size_t pos = body.find("\"temp\":"); pos != std::string::npos;
+       pos = body.find("\"temp\":", pos + 1)) {
+    samples++;
+  }
+  std::vector<uint32_t> timestamps;
+  const std::string key = "\"timestamp\":";
+  for (size_t pos = body.find(key); pos != std::string::npos;
+       pos = body.find(key, pos + 1)) {
+    timestamps.push_back(std::stoul(body.substr(pos + key.size())));
+  }
+  CHECK(samples == timestamps.size());
+
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_uploaded.insert(s_uploaded.end(), timestamps.begin(), timestamps.end());
+  return respond(200, "application/json");
+}
+
+AuthenticationService::AuthenticationService(
+    NetworkService* network_service, NonVolatileStorage* non_volatile_storage)
+    : m_network_service(network_service),
+      m_non_volatile_storage(non_volatile_storage) {}
+
+AuthenticationService::~AuthenticationService() {}
+
+bool AuthenticationService::isAuthenticated() { return true; }
+
+std::string AuthenticationService::getAuthenticationToken() { return "token"; }
+
+void AuthenticationService::reset() {}
+
+NonVolatileStorage::NonVolatileStorage() : m_initialized(true) {}
+
+NonVolatileStorage::~NonVolatileStorage() {}
+
+bool NonVolatileStorage::getBlob(const std::string& namespace_name,
+                                 const std::string& key, void* data,
+                                 size_t* length) {
+  const auto entry = s_nvs.find(namespace_name + "/" + key);
+  if (entry == s_nvs.end() || entry->second.size() > *length) {
+    return false;
+  }
+  std::memcpy(data, entry->second.data(), entry->second.size());
+  *length = entry->second.size();
+  return true;
+}
+
+bool NonVolatileStorage::setBlob(const std::string& namespace_name,
+                                 const std::string& key, const void* data,
+                                 size_t length) {
+  s_nvs[namespace_name + "/" + key] =
+      std::string(static_cast<const char*>(data), length);
+  return true;
+}
+
+bool NonVolatileStorage::getValue(const std::string& namespace_name,
+                                  const std::string& key, uint32_t* value) {
+  size_t length = sizeof(*value);
+  return getBlob(namespace_name, key, value, &length) &&
+         length == sizeof(*value);
+}
+
+bool NonVolatileStorage::setValue(const std::string& namespace_name,
+                                  const std::string& key, uint32_t value) {
+  return setBlob(namespace_name, key, &value, sizeof(value));
+}
+
+BME680::BME680(I2C*) {}
+
+BME680::~BME680() {}
+
+int64_t BME680::beginReading() {
+  if (s_measurement_fails) {
+    return 0;
+  }
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_measured.push_back(getNow());
+  // the deadline of the measurement, 0 means it failed
+  return esp_timer_get_time() + 1;
+}
+
+int BME680::remainingReadingMillis() { return 0; }
+
+BME680::ReadingState BME680::pollReading() { return READING_DONE; }
+
+float BME680::getTemperature() { return 21.5f; }
+
+float BME680::getHumidity() { return 45.5f; }
+
+float BME680::getPressure() { return 101325; }
+
+uint32_t BME680::getGas() { return 120000; }
+
+bool BsecService::isRunning() { return false; }
+
+bool BsecService::getOutput(BsecOutput*) { return false; }
+
+//! @brief The firmware objects of one boot
+struct Device {
+  SampleStorage storage;
+  SampleBuffer buffer;
+  HTTPClient http_client;
+  NetworkService network;
+  NonVolatileStorage nvs;
+  AuthenticationService auth;
+  BME680 bme680;
+  DataService service;
+
+  Device()
+      : storage(SAMPLE_STORAGE_PARTITION),
+        buffer(SAMPLE_BUFFER_CAPACITY, DROP_OLDEST, &storage),
+        network(&http_client),
+        auth(&network, &nvs),
+        bme680(nullptr),
+        service(&network, &auth, &bme680, &buffer, &nvs) {
+    CHECK(storage.isAvailable());
+    CHECK(network.startNetworkTask());
+  }
+
+  //! @brief Wait until the network task sent all queued uploads
+  //! @note A response queues the next batch before the network task takes
+  //! the following request, so the uploads are done once no upload was sent
+  //! between two sentinel requests.
+  void settle() {
+    size_t requests;
+    do {
+      requests = s_upload_requests;
+      CHECK(network.postAndWait(SENTINEL_URL, "", "", PRIORITY_UPLOAD)
+                .httpStatusCode == 200);
+    } while (s_upload_requests != requests);
+  }
+
+  //! @brief Run cycles of the upload task
+  void run(size_t cycles) {
+    for (size_t cycle = 0; cycle < cycles; cycle++) {
+      service.runCycle();
+      settle();
+      esp_timer_stub_advance(CYCLE_S * 1000000LL);
+    }
+  }
+
+  //! @brief Run cycles until the buffer is empty
+  void drain() {
+    for (size_t cycle = 0; cycle < 1000 && buffer.size() > 0; cycle++) {
+      run(1);
+    }
+    CHECK(buffer.size() == 0);
+  }
+};
+
+//! @brief Start a boot with an unsynchronized clock
+static void boot(uint32_t unix_time) {
+  esp_timer_stub_advance(-esp_timer_get_time());
+  s_boot_time = unix_time;
+  s_clock_synced = false;
+}
+
+//! @brief Reset the fakes and the flash before a test
+static void reset(uint32_t partition_size) {
+  flash_stub_reset(partition_size);
+  flash_stub_on_read(nullptr);
+  s_nvs.clear();
+  s_measured.clear();
+  s_uploaded.clear();
+  s_backend_up = false;
+  s_measurement_fails = false;
+  boot(FIRST_BOOT_TIME);
+}
+
+// hours without the backend and a reboot before the clock is synchronized
+// again, every sample is uploaded once in order with its time of measurement
+static void testOutageWithReboot() {
+  reset(32 * SPI_FLASH_SEC_SIZE);
+  Device* first = new Device();
+  s_clock_synced = true;
+  s_backend_up = true;
+  first->run(180);
+  CHECK(!s_uploaded.empty());
+
+  // two hours without the backend
+  s_backend_up = false;
+  first->run(720);
+  const uint32_t reboot_time = getNow() + 30;
+  delete first;
+
+  // the network task of the first boot keeps waiting for a notification and
+  // does not touch the deleted service
+  boot(reboot_time);
+  Device* second = new Device();
+  second->run(120);
+
+  // the backend is back, but the samples of this boot have no unix time yet
+  s_backend_up = true;
+  const size_t requests = s_upload_requests;
+  second->run(60);
+  CHECK(s_upload_requests == requests);
+
+  s_clock_synced = true;
+  second->drain();
+  second->settle();
+
+  std::printf("%zu samples measured, %zu uploaded, %u dropped\n",
+              s_measured.size(), s_uploaded.size(),
+              second->buffer.getDroppedCount());
+  CHECK(second->buffer.getDroppedCount() == 0);
+  CHECK(s_uploaded == s_measured);
+}
+
+// the upload task pushes a sample that evicts the oldest flash sector while
+// the network task reads the next batch, the batch must be read before the
+// eviction, so the response does not remove samples that were never sent
+static void testEvictionWhileReadingBatch() {
+  // the partition holds two sectors of 64 samples, the 129th sample evicts
+  // the first sector
+  reset(2 * SPI_FLASH_SEC_SIZE);
+  s_clock_synced = true;
+  Device device;
+  device.run(128);
+  CHECK(device.buffer.size() == 128);
+  const uint32_t eighth = s_measured[7];
+
+  // the network task reads the samples of the second batch under the lock of
+  // the buffer, the upload task measures the 129th sample meanwhile
+  std::atomic<bool> started(false);
+  std::atomic<bool> pushed(false);
+  std::thread cycle;
+  flash_stub_on_read([&](size_t, const void* data, size_t size) {
+    uint32_t timestamp;
+    if (size < sizeof(uint32_t) + sizeof(timestamp)) {
+      return;
+    }
+    std::memcpy(&timestamp, static_cast<const uint8_t*>(data) + 4,
+                sizeof(timestamp));
+    if (timestamp != eighth || started.exchange(true)) {
+      return;
+    }
+    // the batch is sent once the sample was pushed, the lock of the buffer
+    // gives no order to the waiting push otherwise
+    s_measurement_fails = false;
+    s_hold_uploads = true;
+    cycle = std::thread([&device, &pushed] {
+      device.service.runCycle();
+      pushed = true;
+      s_hold_uploads = false;
+    });
+    // the push waits for the lock, give it the time to overtake the read
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (!pushed && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  s_backend_up = true;
+  s_measurement_fails = true;
+  device.service.runCycle();
+  while (!pushed) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  cycle.join();
+  flash_stub_on_read(nullptr);
+  s_measurement_fails = true;
+  device.settle();
+  device.drain();
+  device.settle();
+
+  // the first two batches were sent, the second one was in flight when the
+  // 58 pending samples of the first sector were dropped
+  std::vector<uint32_t> expected(s_measured.begin(), s_measured.begin() + 12);
+  expected.insert(expected.end(), s_measured.begin() + 64, s_measured.end());
+  std::printf("%zu samples measured, %zu uploaded, %u dropped\n",
+              s_measured.size(), s_uploaded.size(),
+              device.buffer.getDroppedCount());
+  CHECK(s_measured.size() == 129);
+  CHECK(device.buffer.getDroppedCount() == 58);
+  CHECK(s_uploaded == expected);
+}
+
+int main() {
+  esp_timer_stub_set_manual(true);
+  testOutageWithReboot();
+  testEvictionWhileReadingBatch();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+#include <cstdio>
+#include <vector>
+
+#include "esp_timer.h"
+#include "main/driver/eink/eink_channel.h"
+#include "test.h"
+
+//! @brief Number of frames sent per test
+#define FRAME_COUNT 10
+
+//! @brief Time the simulated display needs per frame
+#define PROCESS_TIME_US 1000
+
+//! @brief Maximum time to wait for the acknowledgement of all frames
+#define IDLE_TIMEOUT_MS 30000
+
+//! @brief Send a frame that the simulated display identifies by its id
+static void sendFrame(EInkChannel* channel, uint16_t id) {
+  const uint8_t params[] = {(uint8_t)(id >> 8), (uint8_t)id, 0, 0,
+                            0,                  0,           0, 0};
+  uint8_t frame[9 + sizeof(params)];
+  const size_t length =
+      encodeEInkFrame(frame, 0x01, params, sizeof(params), nullptr, 0);
+  CHECK(channel->sendFrame(frame, length));
+}
+
+static void sendFrames(EInkChannel* channel) {
+  for (uint16_t id = 0; id < FRAME_COUNT; id++) {
+    sendFrame(channel, id);
+  }
+  CHECK(channel->waitUntilIdle(IDLE_TIMEOUT_MS));
+}
+
+//! @brief Check that every frame was executed and the frames executed after
+//! the last recovery are in order
+static void checkExecuted(const std::vector<uint16_t>& executed,
+                          uint16_t resent_from) {
+  std::vector<bool> seen(FRAME_COUNT, false);
+  for (const uint16_t id : executed) {
+    CHECK(id < FRAME_COUNT);
+    seen[id] = true;
+  }
+  for (uint16_t id = 0; id < FRAME_COUNT; id++) {
+    CHECK(seen[id]);
+  }
+
+  size_t start = executed.size();
+  while (start > 0 && executed[start - 1] != resent_from) {
+    start--;
+  }
+  CHECK(start > 0);
+  for (size_t i = start - 1; i + 1 < executed.size(); i++) {
+    CHECK(executed[i + 1] == executed[i] + 1);
+  }
+  CHECK(executed.back() == FRAME_COUNT - 1);
+}
+
+//! @brief Measure the frames per second of the window against sending one
+//! frame at a time
+static void testThroughput(EInkChannel* channel) {
+  const int frames = 200;
+  display_stub_reset(PROCESS_TIME_US);
+  int64_t start = esp_timer_get_time();
+  for (int id = 0; id < frames; id++) {
+    sendFrame(channel, id);
+  }
+  CHECK(channel->waitUntilIdle(IDLE_TIMEOUT_MS));
+  const double window_s = (esp_timer_get_time() - start) / 1e6;
+
+  display_stub_reset(PROCESS_TIME_US);
+  start = esp_timer_get_time();
+  for (int id = 0; id < frames; id++) {
+    sendFrame(channel, id);
+    CHECK(channel->waitUntilIdle(IDLE_TIMEOUT_MS));
+  }
+  const double single_s = (esp_timer_get_time() - start) / 1e6;
+
+  CHECK(display_stub_get_executed().size() == (size_t)frames);
+  std::printf("window of %d: %.0f frames/s, stop and wait: %.0f frames/s\n",
+              EINK_WINDOW_SIZE, frames / window_s, frames / single_s);
+}
+
+// a slow frame is acknowledged after the timeout, the late "OK" must free that
+// frame and nothing may be sent twice
+static void testLateAck(EInkChannel* channel) {
+  display_stub_reset(PROCESS_TIME_US);
+  display_stub_set_reply(5, DISPLAY_STUB_LATE);
+  sendFrames(channel);
+
+  const std::vector<uint16_t> executed = display_stub_get_executed();
+  CHECK(executed.size() == FRAME_COUNT);
+  checkExecuted(executed, 0);
+}
+
+// the display rejects a frame but works on the following frames, their
+// replies can not be assigned, so all of them are sent again in order
+static void testErrorReply(EInkChannel* channel) {
+  display_stub_reset(PROCESS_TIME_US);
+  display_stub_set_reply(3, DISPLAY_STUB_ERROR);
+  sendFrames(channel);
+  checkExecuted(display_stub_get_executed(), 3);
+}
+
+// a lost "OK" shifts the following replies by one frame, the last frame is
+// sent again after the timeout
+static void testLostAck(EInkChannel* channel) {
+  display_stub_reset(PROCESS_TIME_US);
+  display_stub_set_reply(3, DISPLAY_STUB_LOST);
+  sendFrames(channel);
+
+  const std::vector<uint16_t> executed = display_stub_get_executed();
+  CHECK(executed.size() == FRAME_COUNT + 1);
+  checkExecuted(executed, FRAME_COUNT - 1);
+}
+
+int main() {
+  // the receive task keeps running, so the channel is never deleted
+  Uart* uart = new Uart(0, 0, 115200);
+  EInkChannel* channel = new EInkChannel(uart);
+
+  testThroughput(channel);
+  testLateAck(channel);
+  testErrorReply(channel);
+  testLostAck(channel);
+  CHECK(channel->getDroppedFrames() == 0);
+  std::printf("eink_channel_test passed\n");
+  return EXIT_SUCCESS;
+}
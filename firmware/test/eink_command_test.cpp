@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "allocation_counter.h"
+#include "main/driver/eink/display_list.h"
+#include "main/driver/eink/eink.h"
+#include "main/driver/eink/eink_command.h"
+#include "test.h"
+
+//! @brief Maximum time to wait for the acknowledgement of all frames
+#define IDLE_TIMEOUT_MS 60000
+
+// frames computed by hand from the display protocol
+static_assert(encodeEInkFrame(0x2E) ==
+                  std::array<uint8_t, 9>{0xA5, 0x00, 0x09, 0x2E, 0xCC, 0x33,
+                                         0xC3, 0x3C, 0x82},
+              "Clear frame does not match the display protocol");
+static_assert(encodeEInkFrame<1>(0x07, {MemoryMode::MEM_TF}) ==
+                  std::array<uint8_t, 10>{0xA5, 0x00, 0x0A, 0x07, 0x01, 0xCC,
+                                          0x33, 0xC3, 0x3C, 0xA9},
+              "Memory frame does not match the display protocol");
+static_assert(encodeEInkFrame<1>(0x1F, {FontSize::LARGE}) ==
+                  std::array<uint8_t, 10>{0xA5, 0x00, 0x0A, 0x1F, 0x03, 0xCC,
+                                          0x33, 0xC3, 0x3C, 0xB3},
+              "Font size frame does not match the display protocol");
+static_assert(encodeEInkBitmapFrame(0, 0, "A.BMP") ==
+                  std::array<uint8_t, 18>{0xA5, 0x00, 0x12, 0x70, 0x00, 0x00,
+                                          0x00, 0x00, 'A',  '.',  'B',  'M',
+                                          'P',  0xCC, 0x33, 0xC3, 0x3C, 0xF7},
+              "Bitmap frame does not match the display protocol");
+
+//! @brief Check that a command serializes to the expected frame
+template <size_t N>
+static void checkSerialize(const EInkCommand& command,
+                           const std::array<uint8_t, N>& expected) {
+  uint8_t buffer[EINK_FRAME_MAX_SIZE];
+  CHECK(command.getLength() == N);
+  CHECK(command.serialize(buffer, sizeof(buffer)) == N);
+  CHECK(std::equal(expected.begin(), expected.end(), buffer));
+}
+
+//! @brief Test that runtime commands encode like the compile time frames
+static void testSerialize() {
+  checkSerialize(EInkCommand(0x2E), encodeEInkFrame(0x2E));
+  checkSerialize(EInkCommand(0x1F, {FontSize::LARGE}),
+                 encodeEInkFrame<1>(0x1F, {FontSize::LARGE}));
+  checkSerialize(EInkCommand(0x70, {0, 0, 0, 0}, "A.BMP"),
+                 encodeEInkBitmapFrame(0, 0, "A.BMP"));
+  checkSerialize(EInkCommand(0x30, {0, 10, 0, 20}, "Hi"),
+                 std::array<uint8_t, 15>{0xA5, 0x00, 0x0F, 0x30, 0x00, 0x0A,
+                                         0x00, 0x14, 'H', 'i', 0xCC, 0x33,
+                                         0xC3, 0x3C, 0xA5});
+}
+
+//! @brief Test that frames which do not fit are not serialized
+static void testSerializeTooLarge() {
+  uint8_t buffer[EINK_FRAME_MAX_SIZE];
+  EInkCommand command(0x30, {0, 10, 0, 20}, "Hi");
+  CHECK(command.serialize(buffer, command.getLength() - 1) == 0);
+
+  // the display accepts at most 1024 bytes of command data
+  const std::string text(1024 - 4 + 1, 'x');
+  CHECK(EInkCommand(0x30, {0, 10, 0, 20}, text).serialize(
+            buffer, sizeof(buffer)) == 0);
+}
+
+//! @brief Record a screen with every kind of primitive
+static void recordScreen(DisplayList* display_list, const char* value) {
+  display_list->reset();
+  display_list->clearDisplay();
+  display_list->drawBitmap(0, 0, "hometh.bmp");
+  display_list->setFontSize(FontSize::MEDIUM);
+  display_list->drawText(10, 0, "Living");
+  display_list->setFontSize(FontSize::LARGE);
+  display_list->drawText(20, 140, value);
+  display_list->updateDisplay();
+}
+
+//! @brief Test that drawing through EInk does not allocate memory
+static void testNoAllocations(EInk* eink) {
+  DisplayList first;
+  DisplayList second;
+  recordScreen(&first, "21.50");
+  recordScreen(&second, "22.50");
+
+  // the first render sizes the copy of the rendered list
+  CHECK(eink->render(first));
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  display_stub_reset(0);
+
+  const size_t allocations = getAllocationCount();
+  eink->clearDisplay();
+  eink->drawBitmap(0, 0, "hometh.bmp");
+  eink->setFontSize(FontSize::LARGE);
+  eink->drawText(20, 140, "21.50");
+  eink->drawLine(0, 100, EINK_WIDTH - 1, 100);
+  eink->setColor(Color::BLACK, Color::WHITE);
+  eink->updateDisplay();
+  CHECK(eink->render(first));
+  CHECK(eink->render(second));
+  CHECK(!eink->render(second));
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  const size_t used = getAllocationCount() - allocations;
+
+  std::printf("%zu frames, %zu bytes, %zu allocations\n",
+              display_stub_get_received_frames(),
+              display_stub_get_received_bytes(), used);
+  CHECK(used == 0);
+}
+
+int main() {
+  testSerialize();
+  testSerializeTooLarge();
+
+  // the receive task keeps running, so the display is never deleted
+  Uart* uart = new Uart(0, 0, 115200);
+  DigitalOutputPin* wakeup_pin = new DigitalOutputPin(0);
+  EInk* eink = new EInk(uart, wakeup_pin);
+  testNoAllocations(eink);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <functional>
+
+#include "allocation_counter.h"
+#include "esp_timer.h"
+#include "main/driver/eink/eink.h"
+#include "test.h"
+
+//! @brief Number of frames sent per primitive
+#define FRAME_COUNT 200
+
+//! @brief Maximum time to wait for the acknowledgement of all frames
+#define IDLE_TIMEOUT_MS 60000
+
+//! @brief Time in microseconds the simulated line needs per byte
+#define BYTE_TIME_US 87
+
+//! @brief Send the frames of a primitive and report the frames per second,
+//! the utilization of the line and the heap allocations per frame
+static void benchmark(EInk* eink, const char* name,
+                      const std::function<void(int)>& draw) {
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  display_stub_reset(0);
+
+  const size_t allocations = getAllocationCount();
+  const int64_t start = esp_timer_get_time();
+  for (int i = 0; i < FRAME_COUNT; i++) {
+    draw(i);
+  }
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  const int64_t elapsed = esp_timer_get_time() - start;
+  const double allocations_per_frame =
+      (double)(getAllocationCount() - allocations) / FRAME_COUNT;
+
+  const size_t bytes = display_stub_get_received_bytes();
+  CHECK(display_stub_get_received_frames() == FRAME_COUNT);
+  std::printf("%-20s %6zu %10.0f %9.1f%% %12.2f\n", name,
+              bytes / FRAME_COUNT, FRAME_COUNT * 1e6 / elapsed,
+              100.0 * bytes * BYTE_TIME_US / elapsed, allocations_per_frame);
+  CHECK(allocations_per_frame == 0);
+}
+
+int main() {
+  // the receive task keeps running, so the display is never deleted
+  Uart* uart = new Uart(0, 0, 115200);
+  DigitalOutputPin* wakeup_pin = new DigitalOutputPin(0);
+  EInk* eink = new EInk(uart, wakeup_pin);
+  char filename[] = "PIC_0.BMP";
+
+  std::printf("%-20s %6s %10s %10s %12s\n", "primitive", "bytes", "frames/s",
+              "line", "allocations");
+  benchmark(eink, "drawText", [eink](int i) {
+    eink->drawText(10, i, "Temperature 21.5 C");
+  });
+  benchmark(eink, "drawBitmap", [eink, &filename](int i) {
+    filename[4] = '0' + i % 10;
+    eink->drawBitmap(0, 0, filename);
+  });
+  benchmark(eink, "drawLine", [eink](int i) {
+    eink->drawLine(0, i, EINK_WIDTH - 1, i);
+  });
+  benchmark(eink, "drawFilledRectangle", [eink](int i) {
+    eink->drawFilledRectangle(i, i, i + 10, i + 10);
+  });
+  benchmark(eink, "setColor", [eink](int i) {
+    eink->setColor((Color)(i % 4), Color::WHITE);
+  });
+  benchmark(eink, "setFontSize", [eink](int i) {
+    eink->setFontSize((FontSize)(FontSize::SMALL + i % 3));
+  });
+  benchmark(eink, "updateDisplay", [eink](int) { eink->updateDisplay(); });
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "main/config.h"
+#include "main/driver/apds9960/gesture_classifier.h"
+#include "test.h"
+
+// Replays gesture FIFO traces through the classifier and reports the accuracy
+// and the CPU time per gesture. Without arguments synthetic traces are
+// replayed, recorded ones are read from the files given as arguments. A
+// recorded trace is a line as logged by the firmware with
+// GESTURE_TRACE_ENABLED:
+//
+//   gesture_trace <gesture> <hex bytes of the U, D, L, R datasets>
+//
+// with the gesture changed to the one that was actually performed. The traces
+// in gesture_traces.log are replayed by the gesture_classifier_traces test.
+
+static constexpr int GESTURES = APDS9960_DOWN_RIGHT + 1;
+static constexpr int TRACES_PER_GESTURE = 200;
+static constexpr int CPU_REPETITIONS = 200;
+
+static const char* const GESTURE_NAMES[GESTURES] = {
+    "none", "up",      "down",     "left",      "right",     "near",
+    "far",  "up_left", "up_right", "down_left", "down_right"};
+
+struct Trace {
+  uint8_t gesture;
+  std::vector<uint8_t> datasets;
+};
+
+//! @brief Generate the trace of a hand above the four photodiodes
+//! @note A gesture is named after the side the hand enters from, like the
+//! classifier does. The diodes sit around the center of the sensor, the
+//! reflection of the hand falls off with its distance to a diode.
+static Trace generateTrace(uint8_t gesture, std::mt19937& random) {
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 3.0f);
+
+  // direction the hand comes from, x to the right and y to the top
+  float from_x = 0;
+  float from_y = 0;
+  switch (gesture) {
+    case APDS9960_UP:
+      from_y = 1;
+      break;
+    case APDS9960_DOWN:
+      from_y = -1;
+      break;
+    case APDS9960_LEFT:
+      from_x = -1;
+      break;
+    case APDS9960_RIGHT:
+      from_x = 1;
+      break;
+    case APDS9960_UP_LEFT:
+      from_x = -M_SQRT1_2;
+      from_y = M_SQRT1_2;
+      break;
+    case APDS9960_UP_RIGHT:
+      from_x = M_SQRT1_2;
+      from_y = M_SQRT1_2;
+      break;
+    case APDS9960_DOWN_LEFT:
+      from_x = -M_SQRT1_2;
+      from_y = -M_SQRT1_2;
+      break;
+    case APDS9960_DOWN_RIGHT:
+      from_x = M_SQRT1_2;
+      from_y = -M_SQRT1_2;
+      break;
+  }
+
+  // the path is turned by up to 15 degrees and passes off center
+  const float angle = unit(random) * 15.0f * M_PI / 180.0f;
+  const float direction_x = from_x * cos(angle) - from_y * sin(angle);
+  const float direction_y = from_x * sin(angle) + from_y * cos(angle);
+  const float offset = unit(random) * 0.3f;
+  const float amplitude = 160.0f + unit(random) * 60.0f;
+  const int count = 12 + random() % 20;
+
+  static const float DIODES[4][2] = {{0, 0.5f}, {0, -0.5f}, {-0.5f, 0},
+                                     {0.5f, 0}};
+  Trace trace = {gesture, {}};
+  for (int i = 0; i < count; i++) {
+    const float t = (float)i / (count - 1);
+    float x;
+    float y;
+    float intensity = amplitude;
+    if (gesture == APDS9960_NEAR || gesture == APDS9960_FAR) {
+      // the hand stays above the sensor and changes its height
+      x = offset;
+      y = offset * unit(random) * 0.2f;
+      const float closeness = gesture == APDS9960_NEAR ? t : 1.0f - t;
+      intensity = amplitude * (0.15f + 0.85f * closeness);
+    } else {
+      const float along = 2.0f - 4.0f * t;
+      x = direction_x * along - direction_y * offset;
+      y = direction_y * along + direction_x * offset;
+    }
+    for (const auto& diode : DIODES) {
+      const float dx = x - diode[0];
+      const float dy = y - diode[1];
+      const float value =
+          intensity * std::exp(-(dx * dx + dy * dy) / 2.0f) + noise(random);
+      trace.datasets.push_back(
+          (uint8_t)std::lround(std::min(255.0f, std::max(0.0f, value))));
+    }
+  }
+  return trace;
+}
+
+static bool readTraces(const char* path, std::vector<Trace>* traces) {
+  std::ifstream file(path);
+  if (!file) {
+    std::printf("Can not open %s\n", path);
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    const size_t start = line.find("gesture_trace ");
+    if (start == std::string::npos) {
+      continue;
+    }
+    std::istringstream fields(line.substr(start));
+    std::string tag;
+    unsigned gesture;
+    std::string hex;
+    if (!(fields >> tag >> gesture >> hex) || gesture >= GESTURES) {
+      continue;
+    }
+    Trace trace = {(uint8_t)gesture, {}};
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+      trace.datasets.push_back(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    traces->push_back(trace);
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  std::vector<Trace> traces;
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      if (!readTraces(argv[i], &traces)) {
+        return EXIT_FAILURE;
+      }
+    }
+  } else {
+    std::mt19937 random(1234);
+    for (uint8_t gesture = APDS9960_UP; gesture < GESTURES; gesture++) {
+      for (int i = 0; i < TRACES_PER_GESTURE; i++) {
+        traces.push_back(generateTrace(gesture, random));
+      }
+    }
+  }
+
+  GestureClassifier classifier(
+      {.noise = GESTURE_NOISE_THRESHOLD,
+       .sensitivity = GESTURE_SENSITIVITY,
+       .diagonal_ratio = GESTURE_DIAGONAL_RATIO,
+       .near_far_intensity = GESTURE_NEAR_FAR_INTENSITY,
+       .min_datasets = GESTURE_MIN_DATASETS});
+
+  int confusion[GESTURES][GESTURES] = {};
+  double cpu_ns[GESTURES] = {};
+  int datasets[GESTURES] = {};
+  int correct = 0;
+  for (const Trace& trace : traces) {
+    uint8_t result = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CPU_REPETITIONS; i++) {
+      classifier.reset();
+      classifier.addDatasets(trace.datasets.data(),
+                             trace.datasets.size() / 4);
+      result = classifier.classify();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    cpu_ns[trace.gesture] +=
+        std::chrono::duration<double, std::nano>(elapsed).count() /
+        CPU_REPETITIONS;
+    datasets[trace.gesture] += trace.datasets.size() / 4;
+    confusion[trace.gesture][result]++;
+    correct += result == trace.gesture;
+  }
+
+  std::printf("%-11s %6s %9s %8s %s\n", "gesture", "traces", "accuracy",
+              "cpu ns", "recognized as");
+  for (int gesture = 0; gesture < GESTURES; gesture++) {
+    int count = 0;
+    for (int result = 0; result < GESTURES; result++) {
+      count += confusion[gesture][result];
+    }
+    if (count == 0) {
+      continue;
+    }
+    std::printf("%-11s %6d %8.1f%% %8.0f ", GESTURE_NAMES[gesture], count,
+                100.0 * confusion[gesture][gesture] / count,
+                cpu_ns[gesture] / count);
+    for (int result = 0; result < GESTURES; result++) {
+      if (result != gesture && confusion[gesture][result] > 0) {
+        std::printf(" %s:%d", GESTURE_NAMES[result],
+                    confusion[gesture][result]);
+      }
+    }
+    std::printf("  (%.1f datasets)\n", (double)datasets[gesture] / count);
+  }
+  const double accuracy = 100.0 * correct / traces.size();
+  std::printf("accuracy %.1f%% of %zu traces\n", accuracy, traces.size());
+
+  // both the synthetic and the replayed traces are regression checks of the
+  // classifier
+  CHECK(!traces.empty());
+  CHECK(accuracy >= 90.0);
+  return EXIT_SUCCESS;
+}
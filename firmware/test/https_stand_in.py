@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Local HTTPS stand-in for the AirSense backend.
+
+Answers POST /api/v1/data and GET /api/v1/sensors/latest and logs for every
+request if it arrived on a new connection or on a reused one, and if the TLS
+session of a new connection was resumed. Point API_BASE_URL to this server
+and trust its certificate to check the connection reuse of the HTTP client:
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 30 -subj /CN=localhost \\
+        -keyout key.pem -out cert.pem
+    python3 https_stand_in.py --cert cert.pem --key key.pem
+
+With --close-after N the server closes every connection after N requests, so
+the reconnect of the client can be checked as well.
+
+The latest data carries an ETag and a Last-Modified header and is answered
+with 304 Not Modified if the request sends a matching If-None-Match or
+If-Modified-Since header. With --change-every S the data changes every S
+seconds, so the log shows a 200 after every change and 304s in between.
+"""
+
+import argparse
+import email.utils
+import hashlib
+import http.server
+import json
+import ssl
+import threading
+import time
+
+LATEST = [{
+    "id": "65f0c2a1b3d4e5f6a7b8c9d0",
+    "device": "Living room",
+    "temperature": 21.5,
+    "humidity": 45.25,
+    "pressure": 101325,
+    "gasResistance": 120000,
+    "iaq": 42.5,
+    "co2Equivalent": 612.5,
+    "breathVocEquivalent": 0.75,
+}]
+
+
+class LatestData:
+    """The latest data with the validators of its current version."""
+
+    def __init__(self, change_every):
+        self.change_every = change_every
+        self.started = time.time()
+
+    def current(self):
+        version = 0
+        if self.change_every > 0:
+            version = int((time.time() - self.started) // self.change_every)
+        data = [dict(device, temperature=device["temperature"] + version / 10)
+                for device in LATEST]
+        body = json.dumps(data).encode()
+        etag = '"' + hashlib.sha1(body).hexdigest()[:16] + '"'
+        modified = self.started + version * self.change_every
+        return body, etag, email.utils.formatdate(modified, usegmt=True)
+
+    @staticmethod
+    def not_modified(headers, etag, last_modified):
+        # If-None-Match takes precedence over If-Modified-Since (RFC 9110)
+        if_none_match = headers.get("If-None-Match")
+        if if_none_match is not None:
+            tags = [tag.strip() for tag in if_none_match.split(",")]
+            return etag in tags or "*" in tags
+        if_modified_since = headers.get("If-Modified-Since")
+        if if_modified_since is None:
+            return False
+        try:
+            since = email.utils.parsedate_to_datetime(if_modified_since)
+        except (TypeError, ValueError):
+            return False
+        return email.utils.parsedate_to_datetime(last_modified) <= since
+
+
+class Statistics:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.connections = 0
+        self.resumed = 0
+        self.requests = 0
+        self.reuses = 0
+        self.bytes_received = 0
+        self.not_modified = 0
+
+    def __str__(self):
+        return (f"connections: {self.connections} resumed: {self.resumed} "
+                f"requests: {self.requests} reuses: {self.reuses} "
+                f"bytes: {self.bytes_received} "
+                f"not modified: {self.not_modified}")
+
+
+STATISTICS = Statistics()
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    close_after = 0
+    latest = LatestData(0)
+
+    def setup(self):
+        super().setup()
+        self.requests_on_connection = 0
+        with STATISTICS.lock:
+            STATISTICS.connections += 1
+            if self.connection.session_reused:
+                STATISTICS.resumed += 1
+
+    def count_request(self, body_length):
+        self.requests_on_connection += 1
+        with STATISTICS.lock:
+            STATISTICS.requests += 1
+            STATISTICS.bytes_received += body_length
+            if self.requests_on_connection > 1:
+                STATISTICS.reuses += 1
+            print(f"{self.command} {self.path} request "
+                  f"{self.requests_on_connection} of the connection, "
+                  f"resumed session: {self.connection.session_reused}, "
+                  f"{STATISTICS}", flush=True)
+
+    def answer(self, status, body, content_type="application/json",
+               headers=None):
+        self.send_response(status)
+        if status != 304:
+            self.send_header("Content-Type", content_type)
+            self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        if self.close_after and self.requests_on_connection >= self.close_after:
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+        if status != 304:
+            self.wfile.write(body)
+
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        self.rfile.read(length)
+        self.count_request(length)
+        if self.path.startswith("/api/v1/data"):
+            self.answer(200, b"{}")
+        else:
+            self.answer(404, b"{}")
+
+    def do_GET(self):
+        self.count_request(0)
+        if self.path.startswith("/api/v1/sensors/latest"):
+            body, etag, last_modified = self.latest.current()
+            validators = {"ETag": etag, "Last-Modified": last_modified}
+            if LatestData.not_modified(self.headers, etag, last_modified):
+                with STATISTICS.lock:
+                    STATISTICS.not_modified += 1
+                print(f"304 Not Modified for {etag}", flush=True)
+                self.answer(304, b"", headers=validators)
+            else:
+                print(f"200 with {etag}", flush=True)
+                self.answer(200, body, headers=validators)
+        else:
+            self.answer(404, b"{}")
+
+    def log_message(self, format, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", required=True)
+    parser.add_argument("--key", required=True)
+    parser.add_argument("--close-after", type=int, default=0,
+                        help="close a connection after this many requests")
+    parser.add_argument("--change-every", type=float, default=0,
+                        help="change the latest data every this many seconds")
+    arguments = parser.parse_args()
+
+    Handler.close_after = arguments.close_after
+    Handler.latest = LatestData(arguments.change_every)
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+    context.load_cert_chain(arguments.cert, arguments.key)
+    server = http.server.ThreadingHTTPServer((arguments.host, arguments.port),
+                                             Handler)
+    server.socket = context.wrap_socket(server.socket, server_side=True)
+    print(f"Listening on https://{arguments.host}:{arguments.port}",
+          flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        print(STATISTICS)
+
+
+if __name__ == "__main__":
+    main()
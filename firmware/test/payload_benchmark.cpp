@@ -0,0 +1,206 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "main/libs/cJson/cJSON.h"
+#include "main/libs/cbor/cbor.h"
+#include "main/service/data_download_service/air_quality_cbor_decoder.h"
+#include "main/service/data_download_service/air_quality_json_decoder.h"
+#include "main/service/data_service/sample_encoder.h"
+#include "test.h"
+
+//! @brief Number of runs of every measured operation
+#define ITERATIONS 2000
+
+//! @brief Number of samples of an upload batch
+#define BATCH_SIZE 30
+
+//! @brief Number of devices of a /sensors/latest response
+#define DEVICE_COUNT 12
+
+//! @brief Measure the mean duration of an operation
+//! @return The duration of one run in microseconds
+template <typename Operation>
+static double measure(Operation operation) {
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; i++) {
+    operation();
+  }
+  const std::chrono::duration<double, std::micro> duration =
+      std::chrono::steady_clock::now() - start;
+  return duration.count() / ITERATIONS;
+}
+
+static void report(const char* name, size_t json_bytes, double json_us,
+                   size_t cbor_bytes, double cbor_us) {
+  std::printf("%-22s json %5zu bytes %8.2f us | cbor %5zu bytes %8.2f us\n",
+              name, json_bytes, json_us, cbor_bytes, cbor_us);
+}
+
+static AirQualitySample makeSample(uint32_t index) {
+  AirQualitySample sample = {};
+  sample.timestamp = 1700000000 + index * 60;
+  sample.temperature = 21.5f + index * 0.01f;
+  sample.humidity = 45.25f;
+  sample.pressure = 101325.0f;
+  sample.gas_resistance = 120000 + index;
+  sample.iaq = 42.0f;
+  sample.co2_equivalent = 612.5f;
+  sample.breath_voc_equivalent = 0.75f;
+  sample.iaq_accuracy = 3;
+  return sample;
+}
+
+static void benchmarkUpload() {
+  AirQualitySample samples[BATCH_SIZE];
+  for (uint32_t index = 0; index < BATCH_SIZE; index++) {
+    samples[index] = makeSample(index);
+  }
+
+  std::string body;
+  const double json_us = measure([&] {
+    body.clear();
+    body += "[";
+    for (size_t index = 0; index < BATCH_SIZE; index++) {
+      if (index > 0) {
+        body += ",";
+      }
+      SampleEncoder::appendJson(body, samples[index]);
+    }
+    body += "]";
+  });
+  cJSON* root = cJSON_Parse(body.c_str());
+  CHECK(cJSON_GetArraySize(root) == BATCH_SIZE);
+  cJSON_Delete(root);
+
+  static uint8_t buffer[BATCH_SIZE * CBOR_SAMPLE_MAX_SIZE];
+  size_t cbor_size = 0;
+  const double cbor_us = measure([&] {
+    CborWriter writer(buffer, sizeof(buffer));
+    writer.writeArray(BATCH_SIZE);
+    for (size_t index = 0; index < BATCH_SIZE; index++) {
+      SampleEncoder::writeCbor(writer, samples[index]);
+    }
+    CHECK(writer.ok());
+    cbor_size = writer.size();
+  });
+
+  report("upload encode", body.size(), json_us, cbor_size, cbor_us);
+}
+
+//! @brief Append a CBOR null, the writer has no item for it
+static void appendCborNull(uint8_t* buffer, size_t capacity, size_t* size) {
+  CHECK(*size < capacity);
+  buffer[(*size)++] = 0xF6;
+}
+
+static void checkDevice(const AirQualityStore& store, size_t index) {
+  const AirQualityData data = store.get(index);
+  CHECK(data.device_name == "Room " + std::to_string(index));
+  CHECK(data.pressure == 101325);
+  CHECK(data.gas_resistance == 120000);
+  CHECK(data.humidity == 45.25f);
+  if (index % 2 == 0) {
+    CHECK(data.iaq == 42.5f);
+    CHECK(data.breath_voc_equivalent == 0.75f);
+  } else {
+    CHECK(std::isnan(data.iaq));
+    CHECK(std::isnan(data.co2_equivalent));
+    CHECK(std::isnan(data.breath_voc_equivalent));
+  }
+}
+
+static void benchmarkDownload() {
+  // every second device runs without BSEC and sends null estimates
+  const char* estimates[] = {"iaq", "co2Equivalent", "breathVocEquivalent"};
+  const float values[] = {42.5f, 612.5f, 0.75f};
+  std::string json = "[";
+  static uint8_t cbor[DEVICE_COUNT * 160];
+  size_t cbor_size = 0;
+  {
+    CborWriter writer(cbor, sizeof(cbor));
+    writer.writeArray(DEVICE_COUNT);
+    cbor_size = writer.size();
+  }
+  for (size_t index = 0; index < DEVICE_COUNT; index++) {
+    const std::string id = "65f0c2a1b3d4e5f6a7b8" + std::to_string(10 + index);
+    const std::string device = "Room " + std::to_string(index);
+    const bool has_bsec = index % 2 == 0;
+
+    json += std::string(index > 0 ? "," : "") + "{\"id\":\"" + id +
+            "\",\"device\":\"" + device +
+            "\",\"temperature\":21.5,\"humidity\":45.25,\"pressure\":101325,"
+            "\"gasResistance\":120000";
+    for (int estimate = 0; estimate < 3; estimate++) {
+      json += std::string(",\"") + estimates[estimate] + "\":" +
+              (has_bsec ? std::to_string(values[estimate]) : "null");
+    }
+    json += "}";
+
+    CborWriter writer(cbor + cbor_size, sizeof(cbor) - cbor_size);
+    writer.writeMap(9);
+    writer.writeString("id");
+    writer.writeString(id.c_str());
+    writer.writeString("device");
+    writer.writeString(device.c_str());
+    writer.writeString("temperature");
+    writer.writeFloat(21.5f);
+    writer.writeString("humidity");
+    writer.writeFloat(45.25f);
+    writer.writeString("pressure");
+    writer.writeUInt(101325);
+    writer.writeString("gasResistance");
+    writer.writeUInt(120000);
+    CHECK(writer.ok());
+    cbor_size += writer.size();
+    for (int estimate = 0; estimate < 3; estimate++) {
+      CborWriter key_writer(cbor + cbor_size, sizeof(cbor) - cbor_size);
+      key_writer.writeString(estimates[estimate]);
+      if (has_bsec) {
+        key_writer.writeFloat(values[estimate]);
+      }
+      CHECK(key_writer.ok());
+      cbor_size += key_writer.size();
+      if (!has_bsec) {
+        appendCborNull(cbor, sizeof(cbor), &cbor_size);
+      }
+    }
+  }
+  json += "]";
+
+  static AirQualityStore store;
+  const double cjson_us = measure([&] {
+    cJSON* root = cJSON_Parse(json.c_str());
+    CHECK(cJSON_GetArraySize(root) == DEVICE_COUNT);
+    cJSON_Delete(root);
+  });
+
+  static AirQualityJsonDecoder json_decoder;
+  const double json_us = measure([&] {
+    json_decoder.begin(&store);
+    CHECK(json_decoder.feed(json.data(), json.size()));
+    CHECK(json_decoder.finish());
+  });
+  CHECK(store.size() == DEVICE_COUNT);
+  for (size_t index = 0; index < DEVICE_COUNT; index++) {
+    checkDevice(store, index);
+  }
+
+  const double cbor_us = measure([&] {
+    CHECK(AirQualityCborDecoder::decode(cbor, cbor_size, &store));
+  });
+  CHECK(store.size() == DEVICE_COUNT);
+  for (size_t index = 0; index < DEVICE_COUNT; index++) {
+    checkDevice(store, index);
+  }
+
+  report("download decode cJSON", json.size(), cjson_us, cbor_size, cbor_us);
+  report("download decode stream", json.size(), json_us, cbor_size, cbor_us);
+}
+
+int main() {
+  benchmarkUpload();
+  benchmarkDownload();
+  return EXIT_SUCCESS;
+}
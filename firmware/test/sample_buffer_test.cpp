@@ -0,0 +1,137 @@
+#include <cmath>
+#include <cstdio>
+
+#include "main/hal/sample_storage/sample_storage.h"
+#include "main/service/sample_buffer/sample_buffer.h"
+#include "spi_flash_mmu.h"
+#include "test.h"
+
+//! @brief Size of the test partition, the smallest one the storage accepts
+#define PARTITION_SIZE (2 * SPI_FLASH_SEC_SIZE)
+
+static AirQualitySample makeSample(uint32_t timestamp) {
+  AirQualitySample sample = {};
+  sample.timestamp = timestamp;
+  sample.iaq = NAN;
+  sample.co2_equivalent = NAN;
+  sample.breath_voc_equivalent = NAN;
+  return sample;
+}
+
+static uint32_t peekTimestamp(SampleBuffer& buffer, size_t index) {
+  AirQualitySample sample;
+  CHECK(buffer.peek(index, &sample));
+  return sample.timestamp;
+}
+
+static uint32_t readTimestamp(SampleStorage& storage, size_t index) {
+  AirQualitySample sample;
+  CHECK(storage.read(index, &sample));
+  return sample.timestamp;
+}
+
+// samples measured during an outage push out a batch that is being uploaded,
+// the upload response must not remove the newer samples
+static void testRamOutageKeepsUnsentSamples() {
+  SampleBuffer buffer(4, DROP_OLDEST);
+  for (uint32_t timestamp = 1; timestamp <= 3; timestamp++) {
+    CHECK(buffer.push(makeSample(timestamp)));
+  }
+  AirQualitySample batch[10];
+  CHECK(buffer.peekBatch(3, batch) == 3);
+  CHECK(batch[2].timestamp == 3);
+
+  for (uint32_t timestamp = 4; timestamp <= 6; timestamp++) {
+    CHECK(buffer.push(makeSample(timestamp)));
+  }
+  CHECK(buffer.getDroppedCount() == 2);
+
+  buffer.popInFlight();
+  CHECK(buffer.size() == 3);
+  CHECK(peekTimestamp(buffer, 0) == 4);
+  CHECK(peekTimestamp(buffer, 2) == 6);
+}
+
+static void testStorageOutageKeepsUnsentSamples() {
+  flash_stub_reset(PARTITION_SIZE);
+  SampleStorage storage("samples");
+  SampleBuffer buffer(4, DROP_OLDEST, &storage);
+  const uint32_t slots = PARTITION_SIZE / 64;
+
+  for (uint32_t timestamp = 1; timestamp <= slots; timestamp++) {
+    CHECK(buffer.push(makeSample(timestamp)));
+  }
+  AirQualitySample batch[10];
+  CHECK(buffer.peekBatch(10, batch) == 10);
+
+  // entering the first sector again drops all samples of it
+  CHECK(buffer.push(makeSample(slots + 1)));
+  CHECK(buffer.getDroppedCount() == slots / 2);
+
+  buffer.popInFlight();
+  CHECK(buffer.size() == slots / 2 + 1);
+  CHECK(peekTimestamp(buffer, 0) == slots / 2 + 1);
+}
+
+static void testFailedWriteIsSkipped() {
+  flash_stub_reset(PARTITION_SIZE);
+  SampleStorage storage("samples");
+  CHECK(storage.append(makeSample(1), true));
+  CHECK(storage.append(makeSample(2), true));
+  flash_stub_fail_next_write(8);
+  CHECK(!storage.append(makeSample(3), true));
+  CHECK(storage.append(makeSample(4), true));
+  CHECK(storage.append(makeSample(5), true));
+
+  CHECK(storage.size() == 4);
+  CHECK(readTimestamp(storage, 0) == 1);
+  CHECK(readTimestamp(storage, 2) == 4);
+  CHECK(readTimestamp(storage, 3) == 5);
+
+  // the same records are found after a reboot
+  SampleStorage reloaded("samples");
+  CHECK(reloaded.size() == 4);
+  CHECK(readTimestamp(reloaded, 1) == 2);
+  CHECK(readTimestamp(reloaded, 2) == 4);
+  reloaded.consume(3);
+  CHECK(reloaded.size() == 1);
+  CHECK(readTimestamp(reloaded, 0) == 5);
+  reloaded.consume(1);
+  CHECK(reloaded.size() == 0);
+
+  CHECK(reloaded.append(makeSample(6), true));
+  CHECK(reloaded.size() == 1);
+  CHECK(readTimestamp(reloaded, 0) == 6);
+}
+
+// power loss while a record is written, the backlog has to drain after boot
+static void testTornWriteDrainsAfterReboot() {
+  flash_stub_reset(PARTITION_SIZE);
+  {
+    SampleStorage storage("samples");
+    CHECK(storage.append(makeSample(1), true));
+    flash_stub_fail_next_write(60);
+    CHECK(!storage.append(makeSample(2), true));
+  }
+
+  SampleStorage storage("samples");
+  CHECK(storage.size() == 1);
+  CHECK(storage.append(makeSample(3), true));
+  CHECK(storage.size() == 2);
+  CHECK(readTimestamp(storage, 0) == 1);
+  CHECK(readTimestamp(storage, 1) == 3);
+  storage.consume(2);
+  CHECK(storage.size() == 0);
+
+  SampleStorage reloaded("samples");
+  CHECK(reloaded.size() == 0);
+}
+
+int main() {
+  testRamOutageKeepsUnsentSamples();
+  testStorageOutageKeepsUnsentSamples();
+  testFailedWriteIsSkipped();
+  testTornWriteDrainsAfterReboot();
+  std::printf("sample_buffer_test passed\n");
+  return EXIT_SUCCESS;
+}
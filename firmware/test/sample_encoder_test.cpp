@@ -0,0 +1,79 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include "main/libs/cJson/cJSON.h"
+#include "main/libs/cbor/cbor.h"
+#include "main/service/data_service/sample_encoder.h"
+#include "test.h"
+
+static AirQualitySample makeSample() {
+  AirQualitySample sample = {};
+  sample.timestamp = 1700000000;
+  sample.temperature = 21.5f;
+  sample.humidity = 45.25f;
+  sample.pressure = 101325.0f;
+  sample.gas_resistance = 120000;
+  sample.iaq = NAN;
+  sample.co2_equivalent = NAN;
+  sample.breath_voc_equivalent = NAN;
+  return sample;
+}
+
+//! @brief Decode a CBOR map and count its keys
+static size_t countCborKeys(const AirQualitySample& sample) {
+  uint8_t buffer[CBOR_SAMPLE_MAX_SIZE];
+  CborWriter writer(buffer, sizeof(buffer));
+  SampleEncoder::writeCbor(writer, sample);
+  CHECK(writer.ok());
+
+  CborReader reader(buffer, writer.size());
+  size_t count;
+  CHECK(reader.readMap(&count));
+  for (size_t i = 0; i < count; i++) {
+    const char* key;
+    size_t length;
+    CHECK(reader.readString(&key, &length));
+    CHECK(reader.skip());
+  }
+  CHECK(reader.atEnd());
+  return count;
+}
+
+//! @brief Encode a sample as json and count its keys
+static int countJsonKeys(const AirQualitySample& sample) {
+  std::string body;
+  SampleEncoder::appendJson(body, sample);
+  CHECK(body.find("nan") == std::string::npos);
+  cJSON* root = cJSON_Parse(body.c_str());
+  CHECK(root != nullptr);
+  const int count = cJSON_GetArraySize(root);
+  cJSON_Delete(root);
+  return count;
+}
+
+// every estimate is only written once BSEC output it
+static void testMissingEstimatesAreOmitted() {
+  AirQualitySample sample = makeSample();
+  CHECK(countJsonKeys(sample) == 5);
+  CHECK(countCborKeys(sample) == 5);
+
+  sample.iaq = 42.0f;
+  CHECK(countJsonKeys(sample) == 7);
+  CHECK(countCborKeys(sample) == 7);
+
+  sample.co2_equivalent = 612.5f;
+  CHECK(countJsonKeys(sample) == 8);
+  CHECK(countCborKeys(sample) == 8);
+
+  sample.iaq = NAN;
+  sample.breath_voc_equivalent = 0.75f;
+  CHECK(countJsonKeys(sample) == 7);
+  CHECK(countCborKeys(sample) == 7);
+}
+
+int main() {
+  testMissingEstimatesAreOmitted();
+  std::printf("sample_encoder_test passed\n");
+  return EXIT_SUCCESS;
+}
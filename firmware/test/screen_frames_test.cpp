@@ -0,0 +1,164 @@
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+#include "main/driver/eink/display_list.h"
+#include "main/driver/eink/eink.h"
+#include "main/ui/home_ui/home_ui.h"
+#include "test.h"
+
+//! @brief Maximum time to wait for the acknowledgement of all frames
+#define IDLE_TIMEOUT_MS 60000
+
+//! @brief Frames and bytes the display received for a screen
+struct ScreenCost {
+  size_t frames;
+  size_t bytes;
+};
+
+//! @brief Convert a float to a string like the home screen
+static std::string convertFloatToString(float value, uint8_t precision) {
+  std::stringstream float_str;
+  float_str << std::fixed << std::setprecision(precision) << value;
+  return float_str.str();
+}
+
+//! @brief Draw a gas resistance column like the home screen before the
+//! display list, every call is one frame
+static void drawLegacyGas(EInk* eink, uint16_t x, uint16_t k_x,
+                          uint32_t gas_resistance) {
+  if (gas_resistance > 99999) {
+    eink->drawText(x, 517, std::to_string(gas_resistance / 1000));
+    eink->drawText(k_x, 517, "k");
+  } else {
+    eink->drawText(x, 517, std::to_string(gas_resistance));
+  }
+}
+
+//! @brief Draw the home screen with the EInk calls it made before the display
+//! list
+static void drawLegacyHome(EInk* eink, const AirQualityStore& store) {
+  eink->clearDisplay();
+  if (store.empty()) {
+    eink->drawBitmap(0, 0, "serror.bmp");
+  } else if (store.size() == 1) {
+    const AirQualityData data = store.get(0);
+    eink->drawBitmap(0, 0, "homeone.bmp");
+    eink->setFontSize(FontSize::LARGE);
+    eink->drawText((800 - data.device_name.size() * 30) / 2, 0,
+                   data.device_name);
+    eink->setFontSize(FontSize::LARGE);
+    eink->drawText(250, 140, convertFloatToString(data.temperature, 2));
+    eink->drawText(250, 265, convertFloatToString(data.humidity, 2));
+    eink->drawText(250, 390, std::to_string(data.pressure));
+    eink->drawText(250, 517, std::to_string(data.gas_resistance));
+  } else if (store.size() == 2) {
+    const AirQualityData data1 = store.get(0);
+    const AirQualityData data2 = store.get(1);
+    eink->drawBitmap(0, 0, "hometwo.bmp");
+    eink->setFontSize(FontSize::LARGE);
+    eink->drawText((400 - data1.device_name.size() * 30) / 2, 0,
+                   data1.device_name);
+    eink->drawText(410 + (400 - data2.device_name.size() * 30) / 2, 0,
+                   data2.device_name);
+    eink->drawText(170, 140, convertFloatToString(data1.temperature, 2));
+    eink->drawText(170, 265, convertFloatToString(data1.humidity, 2));
+    eink->drawText(170, 390, std::to_string(data1.pressure));
+    drawLegacyGas(eink, 170, 280, data1.gas_resistance);
+    eink->drawText(570, 140, convertFloatToString(data2.temperature, 2));
+    eink->drawText(570, 265, convertFloatToString(data2.humidity, 2));
+    eink->drawText(570, 390, std::to_string(data2.pressure));
+    drawLegacyGas(eink, 570, 680, data2.gas_resistance);
+  } else {
+    const uint16_t columns[] = {20, 285, 555};
+    const uint16_t name_x[] = {0, 240, 500};
+    eink->drawBitmap(0, 0, "hometh.bmp");
+    eink->setFontSize(FontSize::MEDIUM);
+    for (size_t i = 0; i < 3; i++) {
+      const AirQualityData data = store.get(i);
+      const uint16_t x = name_x[i] + (250 - data.device_name.size() * 15) / 2;
+      eink->drawText(i == 0 ? x - 30 : x, 0, data.device_name);
+    }
+    eink->setFontSize(FontSize::LARGE);
+    for (size_t i = 0; i < 3; i++) {
+      const AirQualityData data = store.get(i);
+      eink->drawText(columns[i], 140,
+                     convertFloatToString(data.temperature, 2));
+      eink->drawText(columns[i], 265, convertFloatToString(data.humidity, 2));
+      eink->drawText(columns[i], 390, std::to_string(data.pressure));
+      drawLegacyGas(eink, columns[i], columns[i] + 120, data.gas_resistance);
+    }
+  }
+  eink->updateDisplay();
+}
+
+//! @brief Count the frames and bytes the display receives while drawing
+static ScreenCost measure(EInk* eink, const std::function<void()>& draw) {
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  display_stub_reset(0);
+  draw();
+  CHECK(eink->waitUntilIdle(IDLE_TIMEOUT_MS));
+  return {display_stub_get_received_frames(),
+          display_stub_get_received_bytes()};
+}
+
+//! @brief Fill the store with a number of devices without BSEC estimates
+static void fillStore(AirQualityStore* store, size_t devices,
+                      float temperature) {
+  const char* names[] = {"Living", "Kitchen", "Office"};
+  store->clear();
+  for (size_t i = 0; i < devices; i++) {
+    CHECK(store->add(names[i], names[i], temperature + i, 45.5f, 101325,
+                     120000 + 1000 * i, NAN, NAN, NAN));
+  }
+}
+
+int main() {
+  // the receive task keeps running, so the display is never deleted
+  Uart* uart = new Uart(0, 0, 115200);
+  DigitalOutputPin* wakeup_pin = new DigitalOutputPin(0);
+  EInk* eink = new EInk(uart, wakeup_pin);
+  HomeUI home_ui;
+  DisplayList display_list;
+  AirQualityStore store;
+
+  std::printf("%-8s %14s %14s %14s %14s\n", "sensors", "direct", "list",
+              "unchanged", "one value");
+  for (size_t devices = 0; devices <= 3; devices++) {
+    fillStore(&store, devices, 21.5f);
+    const ScreenCost direct =
+        measure(eink, [eink, &store]() { drawLegacyHome(eink, store); });
+
+    // the direct calls made the display forget the last list, so the first
+    // render draws the whole screen
+    display_list.reset();
+    home_ui.recordHome(store, display_list);
+    const ScreenCost list =
+        measure(eink, [eink, &display_list]() {
+          CHECK(eink->render(display_list));
+        });
+    const ScreenCost unchanged =
+        measure(eink, [eink, &display_list]() {
+          CHECK(!eink->render(display_list));
+        });
+
+    fillStore(&store, devices, 22.5f);
+    display_list.reset();
+    home_ui.recordHome(store, display_list);
+    const ScreenCost one_value =
+        measure(eink, [eink, &display_list]() { eink->render(display_list); });
+
+    std::printf("%-8zu %6zu/%5zuB %6zu/%5zuB %6zu/%5zuB %6zu/%5zuB\n",
+                devices, direct.frames, direct.bytes, list.frames, list.bytes,
+                unchanged.frames, unchanged.bytes, one_value.frames,
+                one_value.bytes);
+    CHECK(list.frames <= direct.frames);
+    CHECK(list.bytes <= direct.bytes);
+    CHECK(unchanged.frames == 0);
+    CHECK(one_value.frames <= list.frames);
+  }
+  return EXIT_SUCCESS;
+}
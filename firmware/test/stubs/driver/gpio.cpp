@@ -0,0 +1,7 @@
+#include "driver/gpio.h"
+
+esp_err_t gpio_reset_pin(gpio_num_t) { return ESP_OK; }
+
+esp_err_t gpio_set_direction(gpio_num_t, gpio_mode_t) { return ESP_OK; }
+
+esp_err_t gpio_set_level(gpio_num_t, uint32_t) { return ESP_OK; }
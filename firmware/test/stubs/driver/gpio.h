@@ -0,0 +1,14 @@
+#pragma once
+
+// Host stand-in for the GPIO driver, the levels of the pins are not kept
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef int gpio_num_t;
+typedef enum { GPIO_MODE_INPUT = 1, GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num);
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
@@ -0,0 +1,132 @@
+#include "driver/i2c.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+//! @brief A command of a link, a start condition has no data
+struct I2CStubCommand {
+  bool start;
+  std::vector<uint8_t> write_data;
+  uint8_t* read_data;
+  size_t read_len;
+};
+
+struct I2CStubLink {
+  std::vector<I2CStubCommand> commands;
+};
+
+static std::mutex s_mutex;
+static std::map<uint8_t, I2CStubDevice*> s_devices;
+static std::atomic<uint32_t> s_transactions(0);
+
+esp_err_t i2c_param_config(i2c_port_t, const i2c_config_t* config) {
+  return config->master.clk_speed > 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_driver_install(i2c_port_t, i2c_mode_t, size_t, size_t, int) {
+  return ESP_OK;
+}
+
+esp_err_t i2c_driver_delete(i2c_port_t) { return ESP_OK; }
+
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t*, uint32_t) {
+  return new I2CStubLink();
+}
+
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd) {
+  delete static_cast<I2CStubLink*>(cmd);
+}
+
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd) {
+  static_cast<I2CStubLink*>(cmd)->commands.push_back({true, {}, nullptr, 0});
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool) {
+  return i2c_master_write(cmd, &data, 1, true);
+}
+
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t* data,
+                           size_t data_len, bool) {
+  static_cast<I2CStubLink*>(cmd)->commands.push_back(
+      {false, std::vector<uint8_t>(data, data + data_len), nullptr, 0});
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t* data,
+                          size_t data_len, i2c_ack_type_t) {
+  static_cast<I2CStubLink*>(cmd)->commands.push_back(
+      {false, {}, data, data_len});
+  return ESP_OK;
+}
+
+esp_err_t i2c_master_stop(i2c_cmd_handle_t) { return ESP_OK; }
+
+esp_err_t i2c_master_cmd_begin(i2c_port_t, i2c_cmd_handle_t cmd, TickType_t) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_transactions++;
+
+  // every start is followed by the address byte, the bytes written up to the
+  // next start go to the device in one piece
+  I2CStubDevice* device = nullptr;
+  bool reading = false;
+  std::vector<uint8_t> written;
+  const auto flush = [&]() -> esp_err_t {
+    if (device == nullptr || reading || written.empty()) {
+      return ESP_OK;
+    }
+    const esp_err_t err = device->write(written.data(), written.size());
+    written.clear();
+    return err;
+  };
+
+  bool expect_address = false;
+  const I2CStubLink* link = static_cast<I2CStubLink*>(cmd);
+  for (const I2CStubCommand& command : link->commands) {
+    if (command.start) {
+      if (flush() != ESP_OK) {
+        return ESP_FAIL;
+      }
+      expect_address = true;
+      continue;
+    }
+    if (command.read_data != nullptr) {
+      if (device == nullptr || !reading ||
+          device->read(command.read_data, command.read_len) != ESP_OK) {
+        return ESP_FAIL;
+      }
+      continue;
+    }
+
+    size_t offset = 0;
+    if (expect_address) {
+      const uint8_t address = command.write_data[0];
+      const auto attached = s_devices.find(address >> 1);
+      if (attached == s_devices.end()) {
+        return ESP_FAIL;
+      }
+      device = attached->second;
+      reading = (address & 1) == I2C_MASTER_READ;
+      expect_address = false;
+      offset = 1;
+    }
+    written.insert(written.end(), command.write_data.begin() + offset,
+                   command.write_data.end());
+  }
+
+  // a bare address probe is acknowledged by every attached device
+  return flush();
+}
+
+void i2c_stub_attach(uint8_t address, I2CStubDevice* device) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (device == nullptr) {
+    s_devices.erase(address);
+  } else {
+    s_devices[address] = device;
+  }
+}
+
+uint32_t i2c_stub_get_transactions() { return s_transactions; }
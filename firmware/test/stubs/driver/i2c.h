@@ -0,0 +1,80 @@
+#pragma once
+
+// Host stand-in for the legacy I2C master driver, the commands of a link are
+// replayed against simulated devices attached to the bus
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum { I2C_NUM_0 = 0, I2C_NUM_1 = 1 } i2c_port_t;
+typedef enum { I2C_MODE_SLAVE = 0, I2C_MODE_MASTER = 1 } i2c_mode_t;
+typedef enum { I2C_MASTER_WRITE = 0, I2C_MASTER_READ = 1 } i2c_rw_t;
+typedef enum {
+  I2C_MASTER_ACK = 0,
+  I2C_MASTER_NACK = 1,
+  I2C_MASTER_LAST_NACK = 2
+} i2c_ack_type_t;
+typedef enum { GPIO_PULLUP_DISABLE = 0, GPIO_PULLUP_ENABLE = 1 } gpio_pullup_t;
+
+#define I2C_SCLK_SRC_FLAG_FOR_NOMAL (0)
+#define I2C_LINK_RECOMMENDED_SIZE(transactions) (64 * (transactions))
+
+typedef void* i2c_cmd_handle_t;
+
+typedef struct {
+  i2c_mode_t mode;
+  int sda_io_num;
+  int scl_io_num;
+  gpio_pullup_t sda_pullup_en;
+  gpio_pullup_t scl_pullup_en;
+  struct {
+    uint32_t clk_speed;
+  } master;
+  uint32_t clk_flags;
+} i2c_config_t;
+
+esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t* config);
+esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode,
+                             size_t slv_rx_buf_len, size_t slv_tx_buf_len,
+                             int intr_alloc_flags);
+esp_err_t i2c_driver_delete(i2c_port_t port);
+
+//! @note The link is allocated on the heap, the buffer is unused.
+i2c_cmd_handle_t i2c_cmd_link_create_static(uint8_t* buffer, uint32_t size);
+void i2c_cmd_link_delete_static(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_start(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data,
+                                bool ack_en);
+esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, const uint8_t* data,
+                           size_t data_len, bool ack_en);
+esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t* data,
+                          size_t data_len, i2c_ack_type_t ack);
+esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd);
+esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd,
+                               TickType_t ticks_to_wait);
+
+//! @brief A simulated device on the bus
+class I2CStubDevice {
+ public:
+  virtual ~I2CStubDevice() = default;
+
+  //! @brief Receive the bytes written after the address
+  //! @return ESP_OK if the device acknowledged the bytes
+  virtual esp_err_t write(const uint8_t* data, size_t len) = 0;
+
+  //! @brief Send the bytes read after the address
+  //! @return ESP_OK if the device acknowledged its address
+  virtual esp_err_t read(uint8_t* data, size_t len) = 0;
+};
+
+//! @brief Attach a simulated device to the bus, unknown addresses are not
+//! acknowledged
+//! @param address The 7 bit address of the device.
+//! @param device The device, nullptr to detach it.
+void i2c_stub_attach(uint8_t address, I2CStubDevice* device);
+
+//! @brief Get the number of command links executed on the bus.
+uint32_t i2c_stub_get_transactions();
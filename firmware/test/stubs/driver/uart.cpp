@@ -0,0 +1,184 @@
+#include "driver/uart.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "esp_timer.h"
+#include "main/config.h"
+
+//! @brief Time in microseconds to transfer a byte at 115200 baud
+#define BYTE_TIME_US 87
+
+//! @brief Extra processing time of a slow frame beyond the ack timeout
+#define LATE_EXTRA_US 500000
+
+//! @brief Capacity reserved by the display, so it does not allocate memory
+//! while the tests count the allocations of the firmware
+#define DISPLAY_STUB_RESERVED 65536
+
+//! @brief A reply of the display that is sent at a given time
+struct ScheduledReply {
+  int64_t time;
+  std::string data;
+};
+
+static std::mutex s_mutex;
+static std::condition_variable s_changed;
+static int64_t s_process_time_us = 0;
+static int64_t s_busy_until = 0;
+static int64_t s_line_free = 0;
+static size_t s_received_frames = 0;
+static std::map<size_t, DisplayStubReply> s_replies;
+static std::vector<uint8_t> s_input;
+static std::vector<ScheduledReply> s_scheduled;
+static std::vector<uint8_t> s_rx;
+static std::vector<uint16_t> s_executed;
+static size_t s_received_bytes = 0;
+
+void display_stub_reset(int64_t process_time_us) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_process_time_us = process_time_us;
+  s_busy_until = 0;
+  s_line_free = 0;
+  s_received_frames = 0;
+  s_replies.clear();
+  s_input.clear();
+  s_scheduled.clear();
+  s_rx.clear();
+  s_executed.clear();
+  s_received_bytes = 0;
+  s_input.reserve(DISPLAY_STUB_RESERVED);
+  s_scheduled.reserve(DISPLAY_STUB_RESERVED);
+  s_rx.reserve(DISPLAY_STUB_RESERVED);
+  s_executed.reserve(DISPLAY_STUB_RESERVED);
+}
+
+void display_stub_set_reply(size_t frame, DisplayStubReply reply) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_replies[frame] = reply;
+}
+
+std::vector<uint16_t> display_stub_get_executed() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  return s_executed;
+}
+
+size_t display_stub_get_received_frames() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  return s_received_frames;
+}
+
+size_t display_stub_get_received_bytes() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  return s_received_bytes;
+}
+
+//! @brief Let the display process a complete frame, the mutex has to be held
+static void processFrame(const uint8_t* frame, size_t length, int64_t now) {
+  const auto reply = s_replies.find(s_received_frames++);
+  const DisplayStubReply type =
+      reply == s_replies.end() ? DISPLAY_STUB_OK : reply->second;
+
+  // the frames are transferred one after the other on the line, the display
+  // processes a frame once it was received and the previous one is done
+  s_line_free = std::max(now, s_line_free) + (int64_t)length * BYTE_TIME_US;
+  int64_t done = std::max(s_line_free, s_busy_until) + s_process_time_us;
+  if (type == DISPLAY_STUB_LATE) {
+    done += EINK_ACK_TIMEOUT_MS * 1000 + LATE_EXTRA_US;
+  }
+  s_busy_until = done;
+
+  if (type != DISPLAY_STUB_ERROR) {
+    s_executed.push_back((uint16_t)(frame[4] << 8 | frame[5]));
+  }
+  if (type == DISPLAY_STUB_OK || type == DISPLAY_STUB_LATE) {
+    s_scheduled.push_back({done, "OK"});
+  } else if (type == DISPLAY_STUB_ERROR) {
+    s_scheduled.push_back({done, "Error"});
+  }
+}
+
+//! @brief Move the replies that were sent by now into the receive buffer
+static void deliverReplies(int64_t now) {
+  size_t delivered = 0;
+  while (delivered < s_scheduled.size() &&
+         s_scheduled[delivered].time <= now) {
+    for (const char c : s_scheduled[delivered].data) {
+      s_rx.push_back((uint8_t)c);
+    }
+    delivered++;
+  }
+  s_scheduled.erase(s_scheduled.begin(), s_scheduled.begin() + delivered);
+}
+
+esp_err_t uart_driver_install(uart_port_t, int, int, int, void*, int) {
+  return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t, const uart_config_t*) {
+  return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return ESP_OK; }
+
+esp_err_t uart_set_baudrate(uart_port_t, uint32_t) { return ESP_OK; }
+
+int uart_write_bytes(uart_port_t, const void* data, size_t size) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  s_input.insert(s_input.end(), bytes, bytes + size);
+  s_received_bytes += size;
+
+  // frame header, 16 bit frame length
+  const int64_t now = esp_timer_get_time();
+  while (s_input.size() >= 3) {
+    const size_t length = s_input[1] << 8 | s_input[2];
+    if (s_input.size() < length) {
+      break;
+    }
+    processFrame(s_input.data(), length, now);
+    s_input.erase(s_input.begin(), s_input.begin() + length);
+  }
+  s_changed.notify_all();
+  return size;
+}
+
+int uart_read_bytes(uart_port_t, void* data, uint32_t size,
+                    TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(s_mutex);
+  const int64_t deadline = esp_timer_get_time() + (int64_t)ticks * 1000;
+  while (true) {
+    const int64_t now = esp_timer_get_time();
+    deliverReplies(now);
+    if (!s_rx.empty() || now >= deadline) {
+      break;
+    }
+    const int64_t wake = s_scheduled.empty()
+                             ? deadline
+                             : std::min(deadline, s_scheduled.front().time);
+    s_changed.wait_for(lock, std::chrono::microseconds(wake - now));
+  }
+
+  uint8_t* bytes = static_cast<uint8_t*>(data);
+  const uint32_t count = std::min<size_t>(size, s_rx.size());
+  std::copy_n(s_rx.begin(), count, bytes);
+  s_rx.erase(s_rx.begin(), s_rx.begin() + count);
+  return count;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t, size_t* size) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  deliverReplies(esp_timer_get_time());
+  *size = s_rx.size();
+  return ESP_OK;
+}
+
+esp_err_t uart_flush(uart_port_t) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_rx.clear();
+  return ESP_OK;
+}
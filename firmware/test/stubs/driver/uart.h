@@ -0,0 +1,71 @@
+#pragma once
+
+// Host stand-in for the UART driver, the other end of UART_NUM_1 is a
+// simulated e-ink display that answers every frame after processing it
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef enum { UART_NUM_0 = 0, UART_NUM_1 = 1 } uart_port_t;
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+typedef enum { UART_SCLK_DEFAULT = 0 } uart_sclk_t;
+
+#define UART_PIN_NO_CHANGE (-1)
+
+typedef struct {
+  int baud_rate;
+  uart_word_length_t data_bits;
+  uart_parity_t parity;
+  uart_stop_bits_t stop_bits;
+  uart_hw_flowcontrol_t flow_ctrl;
+  uint8_t rx_flow_ctrl_thresh;
+  uart_sclk_t source_clk;
+} uart_config_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size,
+                              int tx_buffer_size, int queue_size,
+                              void* queue, int flags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate);
+int uart_write_bytes(uart_port_t port, const void* data, size_t size);
+int uart_read_bytes(uart_port_t port, void* data, uint32_t size,
+                    TickType_t ticks);
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size);
+esp_err_t uart_flush(uart_port_t port);
+
+//! @brief How the simulated display answers a frame
+enum DisplayStubReply {
+  //! executes the frame and answers "OK"
+  DISPLAY_STUB_OK = 0,
+  //! executes the frame slowly and answers "OK" after the ack timeout
+  DISPLAY_STUB_LATE = 1,
+  //! executes the frame, but the "OK" is lost on the line
+  DISPLAY_STUB_LOST = 2,
+  //! does not execute the frame and answers "Error"
+  DISPLAY_STUB_ERROR = 3
+};
+
+//! @brief Restart the simulated display.
+//! @param process_time_us The time the display needs per frame.
+void display_stub_reset(int64_t process_time_us);
+
+//! @brief Set the answer to the n-th frame the display receives.
+void display_stub_set_reply(size_t frame, DisplayStubReply reply);
+
+//! @brief Get the ids of the executed frames in order of execution.
+//! @note The id is the big endian 16 bit value of the first two parameters.
+std::vector<uint16_t> display_stub_get_executed();
+
+//! @brief Get the number of frames the display received.
+size_t display_stub_get_received_frames();
+
+//! @brief Get the number of bytes the display received.
+size_t display_stub_get_received_bytes();
@@ -0,0 +1,22 @@
+#pragma once
+
+// Host stand-in for the types of the ESP http client, the tests replace the
+// HTTPClient class that uses the client
+
+//! @brief The http methods
+typedef enum {
+  HTTP_METHOD_GET = 0,
+  HTTP_METHOD_POST,
+  HTTP_METHOD_PUT,
+  HTTP_METHOD_PATCH,
+  HTTP_METHOD_DELETE,
+  HTTP_METHOD_HEAD
+} esp_http_client_method_t;
+
+//! @brief An event of the http client
+typedef struct {
+  int event_id;
+} esp_http_client_event_t;
+
+//! @brief Handle of a http client
+typedef void* esp_http_client_handle_t;
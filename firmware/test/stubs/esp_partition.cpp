@@ -0,0 +1,77 @@
+#include "esp_partition.h"
+
+#include <cstring>
+#include <vector>
+
+static esp_partition_t s_partition = {0};
+static std::vector<uint8_t> s_flash;
+static bool s_fail_next_write = false;
+static size_t s_fail_after = 0;
+static std::function<void(size_t, const void*, size_t)> s_on_read;
+
+void flash_stub_reset(uint32_t size) {
+  s_partition.size = size;
+  s_flash.assign(size, 0xFF);
+  s_fail_next_write = false;
+}
+
+void flash_stub_fail_next_write(size_t written_bytes) {
+  s_fail_next_write = true;
+  s_fail_after = written_bytes;
+}
+
+void flash_stub_on_read(
+    std::function<void(size_t offset, const void* data, size_t size)>
+        callback) {
+  s_on_read = callback;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t,
+                                                esp_partition_subtype_t,
+                                                const char*) {
+  return s_partition.size > 0 ? &s_partition : nullptr;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t*, size_t src_offset,
+                             void* dst, size_t size) {
+  if (src_offset + size > s_flash.size()) {
+    return ESP_FAIL;
+  }
+  memcpy(dst, &s_flash[src_offset], size);
+  if (s_on_read) {
+    s_on_read(src_offset, dst, size);
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t*, size_t dst_offset,
+                              const void* src, size_t size) {
+  if (dst_offset + size > s_flash.size()) {
+    return ESP_FAIL;
+  }
+  size_t count = size;
+  if (s_fail_next_write) {
+    count = s_fail_after < size ? s_fail_after : size;
+  }
+
+  // programming NOR flash only clears bits
+  const uint8_t* bytes = static_cast<const uint8_t*>(src);
+  for (size_t i = 0; i < count; i++) {
+    s_flash[dst_offset + i] &= bytes[i];
+  }
+
+  if (s_fail_next_write) {
+    s_fail_next_write = false;
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t*, size_t offset,
+                                    size_t size) {
+  if (offset + size > s_flash.size()) {
+    return ESP_FAIL;
+  }
+  memset(&s_flash[offset], 0xFF, size);
+  return ESP_OK;
+}
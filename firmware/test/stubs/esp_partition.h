@@ -0,0 +1,41 @@
+#pragma once
+
+// RAM backed host stand-in for a data partition on NOR flash
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "esp_err.h"
+
+typedef enum { ESP_PARTITION_TYPE_DATA = 0x01 } esp_partition_type_t;
+typedef enum { ESP_PARTITION_SUBTYPE_ANY = 0xFF } esp_partition_subtype_t;
+
+typedef struct {
+  uint32_t size;
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype,
+                                                const char* label);
+
+esp_err_t esp_partition_read(const esp_partition_t* partition,
+                             size_t src_offset, void* dst, size_t size);
+
+esp_err_t esp_partition_write(const esp_partition_t* partition,
+                              size_t dst_offset, const void* src, size_t size);
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition,
+                                    size_t offset, size_t size);
+
+//! @brief Create an erased partition of the given size.
+void flash_stub_reset(uint32_t size);
+
+//! @brief Let the next write fail after the given number of bytes.
+void flash_stub_fail_next_write(size_t written_bytes);
+
+//! @brief Call a function after every read, nullptr to remove it.
+//! @note The function gets the offset and the bytes that were read.
+void flash_stub_on_read(
+    std::function<void(size_t offset, const void* data, size_t size)>
+        callback);
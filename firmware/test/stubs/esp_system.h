@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in for the ESP system API, nothing of it is used by the tests
@@ -0,0 +1,22 @@
+#include "esp_timer.h"
+
+#include <atomic>
+#include <chrono>
+
+static std::atomic<int64_t> s_offset(0);
+static std::atomic<bool> s_manual(false);
+
+int64_t esp_timer_get_time() {
+  static const auto start = std::chrono::steady_clock::now();
+  if (s_manual) {
+    return s_offset;
+  }
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+             .count() +
+         s_offset;
+}
+
+void esp_timer_stub_advance(int64_t us) { s_offset += us; }
+
+void esp_timer_stub_set_manual(bool manual) { s_manual = manual; }
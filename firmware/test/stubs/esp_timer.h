@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+//! @brief Get the time since the start of the test in microseconds
+int64_t esp_timer_get_time();
+
+//! @brief Move the time forward, e.g. to an uptime beyond 32 bit microseconds
+//! @param us The microseconds to add to the time
+void esp_timer_stub_advance(int64_t us);
+
+//! @brief Only move the time with esp_timer_stub_advance, so the time of a
+//! test does not depend on how fast the host runs it
+//! @param manual True to stop the time, false to let it run again
+void esp_timer_stub_set_manual(bool manual);
@@ -0,0 +1,199 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+//! @brief A thread waiting for a semaphore, lives on the stack of the thread
+//! so waiting does not allocate
+struct Waiter {
+  bool handed = false;
+  Waiter* next = nullptr;
+};
+
+//! @note A give hands the semaphore to the longest waiting thread, so a
+//! thread that gives and takes it again in a loop lets the waiting threads in
+//! like a waiting task of higher priority would.
+struct Semaphore {
+  std::mutex mutex;
+  std::condition_variable changed;
+  UBaseType_t count;
+  UBaseType_t max_count;
+  Waiter* first_waiter = nullptr;
+};
+
+struct Task {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t notifications = 0;
+};
+
+struct EventGroup {
+  std::mutex mutex;
+  std::condition_variable changed;
+  EventBits_t bits = 0;
+};
+
+//! @brief The task of the calling thread, nullptr outside of tasks
+static thread_local Task* s_current_task = nullptr;
+
+//! @brief Wait until a predicate holds or the ticks passed
+template <typename Predicate>
+static bool waitFor(std::condition_variable& changed,
+                    std::unique_lock<std::mutex>& lock, TickType_t ticks,
+                    Predicate predicate) {
+  if (ticks == portMAX_DELAY) {
+    changed.wait(lock, predicate);
+    return true;
+  }
+  return changed.wait_for(lock, std::chrono::milliseconds(ticks), predicate);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+  return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t*) {
+  return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count,
+                                           UBaseType_t initial_count) {
+  Semaphore* semaphore = new Semaphore();
+  semaphore->count = initial_count;
+  semaphore->max_count = max_count;
+  return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks) {
+  Semaphore* semaphore = static_cast<Semaphore*>(handle);
+  std::unique_lock<std::mutex> lock(semaphore->mutex);
+  if (semaphore->count > 0) {
+    semaphore->count--;
+    return pdTRUE;
+  }
+  Waiter waiter;
+  Waiter** link = &semaphore->first_waiter;
+  while (*link != nullptr) {
+    link = &(*link)->next;
+  }
+  *link = &waiter;
+  if (!waitFor(semaphore->changed, lock, ticks,
+               [&waiter] { return waiter.handed; })) {
+    link = &semaphore->first_waiter;
+    while (*link != &waiter) {
+      link = &(*link)->next;
+    }
+    *link = waiter.next;
+    return pdFALSE;
+  }
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle) {
+  Semaphore* semaphore = static_cast<Semaphore*>(handle);
+  std::lock_guard<std::mutex> lock(semaphore->mutex);
+  if (semaphore->first_waiter != nullptr) {
+    semaphore->first_waiter->handed = true;
+    semaphore->first_waiter = semaphore->first_waiter->next;
+    semaphore->changed.notify_all();
+    return pdTRUE;
+  }
+  if (semaphore->count == semaphore->max_count) {
+    return pdFALSE;
+  }
+  semaphore->count++;
+  return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle) {
+  delete static_cast<Semaphore*>(handle);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char*, uint32_t,
+                       void* parameters, UBaseType_t, TaskHandle_t* handle) {
+  // the task is never freed, its thread can not be stopped
+  Task* task = new Task();
+  std::thread([function, parameters, task] {
+    s_current_task = task;
+    function(parameters);
+  }).detach();
+  if (handle != nullptr) {
+    *handle = task;
+  }
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle) {
+  Task* task = static_cast<Task*>(handle);
+  std::lock_guard<std::mutex> lock(task->mutex);
+  task->notifications++;
+  task->notified.notify_one();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  Task* task = s_current_task;
+  std::unique_lock<std::mutex> lock(task->mutex);
+  waitFor(task->notified, lock, ticks,
+          [task] { return task->notifications > 0; });
+  const uint32_t notifications = task->notifications;
+  if (clear_on_exit) {
+    task->notifications = 0;
+  } else if (notifications > 0) {
+    task->notifications--;
+  }
+  return notifications;
+}
+
+EventGroupHandle_t xEventGroupCreate() { return new EventGroup(); }
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits) {
+  EventGroup* group = static_cast<EventGroup*>(handle);
+  std::lock_guard<std::mutex> lock(group->mutex);
+  group->bits |= bits;
+  group->changed.notify_all();
+  return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle,
+                                 EventBits_t bits) {
+  EventGroup* group = static_cast<EventGroup*>(handle);
+  std::lock_guard<std::mutex> lock(group->mutex);
+  const EventBits_t previous = group->bits;
+  group->bits &= ~bits;
+  return previous;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits,
+                                BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+  EventGroup* group = static_cast<EventGroup*>(handle);
+  std::unique_lock<std::mutex> lock(group->mutex);
+  waitFor(group->changed, lock, ticks, [&] {
+    return wait_for_all ? (group->bits & bits) == bits
+                        : (group->bits & bits) != 0;
+  });
+  const EventBits_t result = group->bits;
+  if (clear_on_exit) {
+    group->bits &= ~bits;
+  }
+  return result;
+}
+
+void vEventGroupDelete(EventGroupHandle_t handle) {
+  delete static_cast<EventGroup*>(handle);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in for the FreeRTOS API used by the tests, tasks are threads and
+// a tick is a millisecond
+
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef void* SemaphoreHandle_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef struct {
+  uint8_t unused;
+} StaticSemaphore_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFF
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define BIT0 0x01
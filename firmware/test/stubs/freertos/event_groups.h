@@ -0,0 +1,18 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void* EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+
+EventGroupHandle_t xEventGroupCreate();
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+                                BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks);
+
+void vEventGroupDelete(EventGroupHandle_t group);
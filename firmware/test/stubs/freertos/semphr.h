@@ -0,0 +1,19 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+
+//! @note The semaphore is allocated on the heap, the buffer is unused.
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buffer);
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count,
+                                           UBaseType_t initial_count);
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
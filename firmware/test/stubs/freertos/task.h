@@ -0,0 +1,17 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name,
+                       uint32_t stack_depth, void* parameters,
+                       UBaseType_t priority, TaskHandle_t* handle);
+
+//! @note The thread of the task can not be stopped, it keeps running.
+void vTaskDelete(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+
+//! @note Only tasks created with xTaskCreate can wait for notifications.
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+#include "esp_err.h"
+
+// Host stand-in for the types of the NVS API, the tests replace the
+// NonVolatileStorage class that uses it
+
+//! @brief Handle of an opened NVS namespace
+typedef uint32_t nvs_handle_t;
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host stand-in for the NVS flash API, nothing of it is used by the tests
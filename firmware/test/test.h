@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+//! @brief Fail the test with the location if the condition is false
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,      \
+                  #condition);                                          \
+      std::exit(EXIT_FAILURE);                                          \
+    }                                                                   \
+  } while (0)
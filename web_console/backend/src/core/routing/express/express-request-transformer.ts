@@ -1,5 +1,6 @@
 import express from 'express';
 import { HttpRequest } from '../../api';
+import { CborUtils } from '../../utils/cbor-utils';
 import { RequestTransformer } from '../request-transformer';
 
 /**
@@ -23,11 +24,30 @@ export class ExpressRequestTransformer implements RequestTransformer<express.Req
     this.transformQueryParams(request, outRequest);
     this.transformPathParams(request, outRequest);
 
-    outRequest.body = request.body;
+    outRequest.body = this.transformBody(request);
 
     return outRequest;
   }
 
+  /**
+   * Extracts the body from the request, CBOR bodies are decoded.
+   *
+   * @param request The request to transform.
+   *
+   * @returns The request body, undefined if a CBOR body could not be decoded.
+   */
+  private transformBody(request: express.Request): unknown {
+    if (!request.is(CborUtils.CONTENT_TYPE) || !Buffer.isBuffer(request.body)) {
+      return request.body;
+    }
+
+    try {
+      return CborUtils.decode(request.body);
+    } catch {
+      return undefined;
+    }
+  }
+
   /**
    * Extracts the headers from the request and adds them to the out request.
    *
@@ -1,5 +1,6 @@
 import express from 'express';
 import { IHttpResponse } from '../../api';
+import { CborUtils } from '../../utils/cbor-utils';
 import { ResponseTransformer } from '../response-transformer';
 
 /**
@@ -21,6 +22,14 @@ export class ExpressResponseTransformer implements ResponseTransformer<express.R
       }
     }
 
+    // clients that prefer CBOR get the body encoded as CBOR, everyone else gets JSON
+    const contentType = outResponse.req.accepts(['application/json', CborUtils.CONTENT_TYPE]);
+    if (contentType === CborUtils.CONTENT_TYPE && response.body !== undefined && typeof response.body !== 'string') {
+      outResponse.type(CborUtils.CONTENT_TYPE);
+      outResponse.send(CborUtils.encode(response.body));
+      return;
+    }
+
     outResponse.send(response.body);
   }
 }
@@ -2,6 +2,7 @@ import bodyParser from 'body-parser';
 import cors from 'cors';
 import express from 'express';
 import { HttpMethod } from '../../api';
+import { CborUtils } from '../../utils/cbor-utils';
 import { IRouter } from '../router';
 import { IRouterHandler } from '../router-handler';
 import { ExpressRequestTransformer } from './express-request-transformer';
@@ -16,6 +17,11 @@ export class ExpressRouter implements IRouter {
    */
   private readonly app: express.Application;
 
+  /**
+   * The body parsers, JSON and CBOR request bodies are supported.
+   */
+  private readonly bodyParsers = [bodyParser.json(), bodyParser.raw({ type: CborUtils.CONTENT_TYPE })];
+
   /**
    * The request transformer.
    */
@@ -84,7 +90,7 @@ export class ExpressRouter implements IRouter {
    * @param handler The path handler.
    */
   private get(path: string, handler: IRouterHandler): void {
-    this.app.get(path, bodyParser.json(), async (req: express.Request, res: express.Response) => {
+    this.app.get(path, this.bodyParsers, async (req: express.Request, res: express.Response) => {
       await this.handle(req, res, handler);
     });
   }
@@ -96,7 +102,7 @@ export class ExpressRouter implements IRouter {
    * @param handler The path handler.
    */
   private post(path: string, handler: IRouterHandler): void {
-    this.app.post(path, bodyParser.json(), async (req: express.Request, res: express.Response) => {
+    this.app.post(path, this.bodyParsers, async (req: express.Request, res: express.Response) => {
       await this.handle(req, res, handler);
     });
   }
@@ -108,7 +114,7 @@ export class ExpressRouter implements IRouter {
    * @param handler The path handler.
    */
   private put(path: string, handler: IRouterHandler): void {
-    this.app.put(path, bodyParser.json(), async (req: express.Request, res: express.Response) => {
+    this.app.put(path, this.bodyParsers, async (req: express.Request, res: express.Response) => {
       await this.handle(req, res, handler);
     });
   }
@@ -120,7 +126,7 @@ export class ExpressRouter implements IRouter {
    * @param handler The path handler.
    */
   private patch(path: string, handler: IRouterHandler): void {
-    this.app.patch(path, bodyParser.json(), async (req: express.Request, res: express.Response) => {
+    this.app.patch(path, this.bodyParsers, async (req: express.Request, res: express.Response) => {
       await this.handle(req, res, handler);
     });
   }
@@ -132,7 +138,7 @@ export class ExpressRouter implements IRouter {
    * @param handler The path handler.
    */
   private delete(path: string, handler: IRouterHandler): void {
-    this.app.delete(path, bodyParser.json(), async (req: express.Request, res: express.Response) => {
+    this.app.delete(path, this.bodyParsers, async (req: express.Request, res: express.Response) => {
       await this.handle(req, res, handler);
     });
   }
@@ -0,0 +1,276 @@
+/**
+ * Contains CBOR (RFC 8949) encoding and decoding functions.
+ *
+ * Supports the subset that is needed by the API: maps with string keys, arrays, strings, numbers, booleans and null.
+ * Dates are encoded as ISO strings, the same as in JSON.
+ */
+export class CborUtils {
+  /**
+   * The CBOR content type.
+   */
+  public static readonly CONTENT_TYPE = 'application/cbor';
+
+  /**
+   * Encodes the specified value.
+   *
+   * @param value The value to encode.
+   *
+   * @returns The encoded value.
+   */
+  public static encode(value: unknown): Buffer {
+    const chunks: Buffer[] = [];
+    CborUtils.encodeValue(value, chunks);
+    return Buffer.concat(chunks);
+  }
+
+  /**
+   * Decodes the specified data.
+   *
+   * @param data The data to decode.
+   *
+   * @returns The decoded value.
+   */
+  public static decode(data: Buffer): unknown {
+    const state = { data, offset: 0 };
+    const value = CborUtils.decodeValue(state);
+
+    if (state.offset !== data.length) {
+      throw new Error('unexpected data after cbor value');
+    }
+
+    return value;
+  }
+
+  /**
+   * Encodes a value and appends it to the chunks.
+   *
+   * @param value The value to encode.
+   * @param chunks The encoded chunks.
+   */
+  private static encodeValue(value: unknown, chunks: Buffer[]): void {
+    if (value === null || value === undefined) {
+      chunks.push(Buffer.from([0xf6]));
+    } else if (typeof value === 'boolean') {
+      chunks.push(Buffer.from([value ? 0xf5 : 0xf4]));
+    } else if (typeof value === 'number') {
+      CborUtils.encodeNumber(value, chunks);
+    } else if (typeof value === 'string') {
+      const text = Buffer.from(value, 'utf8');
+      CborUtils.encodeHead(3, text.length, chunks);
+      chunks.push(text);
+    } else if (value instanceof Date) {
+      CborUtils.encodeValue(value.toISOString(), chunks);
+    } else if (Array.isArray(value)) {
+      CborUtils.encodeHead(4, value.length, chunks);
+      for (const item of value) {
+        CborUtils.encodeValue(item, chunks);
+      }
+    } else if (typeof value === 'object') {
+      const entries = Object.entries(value).filter(([, item]) => item !== undefined);
+      CborUtils.encodeHead(5, entries.length, chunks);
+      for (const [key, item] of entries) {
+        CborUtils.encodeValue(key, chunks);
+        CborUtils.encodeValue(item, chunks);
+      }
+    } else {
+      throw new Error(`unsupported cbor value type: ${typeof value}`);
+    }
+  }
+
+  /**
+   * Encodes a number, integers as integers and everything else as the smallest lossless float.
+   *
+   * @param value The number to encode.
+   * @param chunks The encoded chunks.
+   */
+  private static encodeNumber(value: number, chunks: Buffer[]): void {
+    if (Number.isSafeInteger(value)) {
+      if (value >= 0) {
+        CborUtils.encodeHead(0, value, chunks);
+      } else {
+        CborUtils.encodeHead(1, -1 - value, chunks);
+      }
+      return;
+    }
+
+    if (Math.fround(value) === value || Number.isNaN(value)) {
+      const float = Buffer.alloc(5);
+      float[0] = 0xfa;
+      float.writeFloatBE(value, 1);
+      chunks.push(float);
+    } else {
+      const double = Buffer.alloc(9);
+      double[0] = 0xfb;
+      double.writeDoubleBE(value, 1);
+      chunks.push(double);
+    }
+  }
+
+  /**
+   * Encodes the head of a data item.
+   *
+   * @param major The major type.
+   * @param argument The argument, the value or the length.
+   * @param chunks The encoded chunks.
+   */
+  private static encodeHead(major: number, argument: number, chunks: Buffer[]): void {
+    const type = major << 5;
+
+    if (argument < 24) {
+      chunks.push(Buffer.from([type | argument]));
+    } else if (argument <= 0xff) {
+      chunks.push(Buffer.from([type | 24, argument]));
+    } else if (argument <= 0xffff) {
+      const head = Buffer.alloc(3);
+      head[0] = type | 25;
+      head.writeUInt16BE(argument, 1);
+      chunks.push(head);
+    } else if (argument <= 0xffffffff) {
+      const head = Buffer.alloc(5);
+      head[0] = type | 26;
+      head.writeUInt32BE(argument, 1);
+      chunks.push(head);
+    } else {
+      const head = Buffer.alloc(9);
+      head[0] = type | 27;
+      head.writeBigUInt64BE(BigInt(argument), 1);
+      chunks.push(head);
+    }
+  }
+
+  /**
+   * Decodes the data item at the current offset.
+   *
+   * @param state The data and the current offset.
+   *
+   * @returns The decoded value.
+   */
+  private static decodeValue(state: { data: Buffer; offset: number }): unknown {
+    const initial = CborUtils.readBytes(state, 1)[0];
+    const major = initial >> 5;
+    const info = initial & 0x1f;
+
+    if (major === 7) {
+      switch (info) {
+        case 20:
+          return false;
+        case 21:
+          return true;
+        case 22:
+        case 23:
+          return null;
+        case 25:
+          return CborUtils.decodeHalf(CborUtils.readBytes(state, 2).readUInt16BE(0));
+        case 26:
+          return CborUtils.readBytes(state, 4).readFloatBE(0);
+        case 27:
+          return CborUtils.readBytes(state, 8).readDoubleBE(0);
+        default:
+          throw new Error(`unsupported cbor simple value: ${info}`);
+      }
+    }
+
+    const argument = CborUtils.readArgument(state, info);
+
+    switch (major) {
+      case 0:
+        return argument;
+      case 1:
+        return -1 - argument;
+      case 2:
+        return CborUtils.readBytes(state, argument);
+      case 3:
+        return CborUtils.readBytes(state, argument).toString('utf8');
+      case 4: {
+        const array: unknown[] = [];
+        for (let index = 0; index < argument; ++index) {
+          array.push(CborUtils.decodeValue(state));
+        }
+        return array;
+      }
+      case 5: {
+        const map: Record<string, unknown> = {};
+        for (let index = 0; index < argument; ++index) {
+          const key = CborUtils.decodeValue(state);
+          if (typeof key !== 'string') {
+            throw new Error('unsupported cbor map key');
+          }
+          map[key] = CborUtils.decodeValue(state);
+        }
+        return map;
+      }
+      default:
+        // tagged values are decoded as their content
+        return CborUtils.decodeValue(state);
+    }
+  }
+
+  /**
+   * Reads the argument of a data item head.
+   *
+   * @param state The data and the current offset.
+   * @param info The additional information of the head.
+   *
+   * @returns The argument.
+   */
+  private static readArgument(state: { data: Buffer; offset: number }, info: number): number {
+    if (info < 24) {
+      return info;
+    }
+
+    switch (info) {
+      case 24:
+        return CborUtils.readBytes(state, 1)[0];
+      case 25:
+        return CborUtils.readBytes(state, 2).readUInt16BE(0);
+      case 26:
+        return CborUtils.readBytes(state, 4).readUInt32BE(0);
+      case 27:
+        return Number(CborUtils.readBytes(state, 8).readBigUInt64BE(0));
+      default:
+        throw new Error('indefinite length cbor items are not supported');
+    }
+  }
+
+  /**
+   * Reads the specified number of bytes at the current offset.
+   *
+   * @param state The data and the current offset.
+   * @param length The number of bytes.
+   *
+   * @returns The bytes.
+   */
+  private static readBytes(state: { data: Buffer; offset: number }, length: number): Buffer {
+    if (state.offset + length > state.data.length) {
+      throw new Error('unexpected end of cbor data');
+    }
+
+    const bytes = state.data.subarray(state.offset, state.offset + length);
+    state.offset += length;
+
+    return bytes;
+  }
+
+  /**
+   * Decodes a half precision float.
+   *
+   * @param half The half precision float bits.
+   *
+   * @returns The decoded number.
+   */
+  private static decodeHalf(half: number): number {
+    const exponent = (half >> 10) & 0x1f;
+    const mantissa = half & 0x3ff;
+    const sign = half & 0x8000 ? -1 : 1;
+
+    if (exponent === 0) {
+      return sign * mantissa * Math.pow(2, -24);
+    }
+
+    if (exponent === 0x1f) {
+      return mantissa ? NaN : sign * Infinity;
+    }
+
+    return sign * (mantissa + 1024) * Math.pow(2, exponent - 25);
+  }
+}
@@ -13,6 +13,11 @@ import { DataPointInfo } from '../../models/data-point.info';
 import { TriggerInfo } from '../../models/trigger.info';
 import { OnCreateDataPointInfo } from './create-data-point.request';
 
+/**
+ * The maximum number of data points of a batch.
+ */
+const MAX_BATCH_SIZE = 100;
+
 export interface ITriggerEvaluator {
   evaluate(value: number, threshold: number): boolean;
 }
@@ -110,34 +115,55 @@ export class CreateDataPointHandler implements IRouterHandler {
       return IllegalRequestBodyf('Expected a request body.');
     }
 
-    const info = new OnCreateDataPointInfo();
-    Object.assign(info, request.body);
-
-    const errors = await validate(info);
-    if (errors.length > 0) {
-      Log.warn('request body validation failed ...');
-      return IllegalRequestBodyf(errors);
+    // a batch of data points is sent as array
+    const isBatch = Array.isArray(request.body);
+    const bodies: unknown[] = isBatch ? request.body : [request.body];
+    if (bodies.length === 0 || bodies.length > MAX_BATCH_SIZE) {
+      Log.warn('invalid batch size ...');
+      return IllegalRequestBodyf(`Expected between 1 and ${MAX_BATCH_SIZE} data points.`);
     }
 
-    const dataPoint: DataPointInfo = {
-      _id: uuidv4(),
-      _userId: user.userId,
-      _deviceId: user.deviceId,
-      humidity: info.humidity,
-      pressure: info.pressure,
-      temperature: info.temp,
-      gasResistance: info.gasResistance,
-      createdOn: new Date(),
-    };
+    const dataPoints: DataPointInfo[] = [];
+    for (const body of bodies) {
+      const info = new OnCreateDataPointInfo();
+      Object.assign(info, body);
+
+      const errors = await validate(info);
+      if (errors.length > 0) {
+        Log.warn('request body validation failed ...');
+        return IllegalRequestBodyf(errors);
+      }
+
+      const dataPoint: DataPointInfo = {
+        _id: uuidv4(),
+        _userId: user.userId,
+        _deviceId: user.deviceId,
+        humidity: info.humidity,
+        pressure: info.pressure,
+        temperature: info.temp,
+        gasResistance: info.gasResistance,
+        createdOn: info.timestamp ? new Date(info.timestamp * 1000) : new Date(),
+      };
+
+      // the air quality estimates are only sent by devices running BSEC
+      if (info.iaq !== undefined) {
+        dataPoint.iaq = info.iaq;
+        dataPoint.iaqAccuracy = info.iaqAccuracy;
+        dataPoint.co2Equivalent = info.co2Equivalent;
+        dataPoint.breathVocEquivalent = info.breathVocEquivalent;
+      }
+      dataPoints.push(dataPoint);
+    }
 
     try {
-      await this.collection.insertOne(dataPoint);
+      await this.collection.insertMany(dataPoints);
     } catch (error) {
       Log.error('failed to create data point:', error);
       return InternalServerError();
     }
 
-    this.executeTriggers(user.userId, user.deviceId, dataPoint)
+    // triggers are only evaluated against the latest data point of a batch
+    this.executeTriggers(user.userId, user.deviceId, dataPoints[dataPoints.length - 1])
       .then(() => {
         Log.info('triggers successfully executed');
       })
@@ -147,7 +173,7 @@ export class CreateDataPointHandler implements IRouterHandler {
 
     return {
       statusCode: 200,
-      body: dataPoint,
+      body: isBatch ? dataPoints : dataPoints[0],
     };
   }
 
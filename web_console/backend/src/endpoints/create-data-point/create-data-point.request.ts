@@ -21,4 +21,29 @@ export class OnCreateDataPointInfo {
    * The current gas resistance (in ohms).
    */
   public gasResistance: number | undefined;
+
+  /**
+   * The indoor air quality index (0 to 500), only sent by devices with BSEC.
+   */
+  public iaq: number | undefined;
+
+  /**
+   * The accuracy of the indoor air quality index (0 to 3).
+   */
+  public iaqAccuracy: number | undefined;
+
+  /**
+   * The CO2 equivalent (in ppm).
+   */
+  public co2Equivalent: number | undefined;
+
+  /**
+   * The breath VOC equivalent (in ppm).
+   */
+  public breathVocEquivalent: number | undefined;
+
+  /**
+   * The time of the measurement (in seconds since epoch), the time of reception if not set.
+   */
+  public timestamp: number | undefined;
 }
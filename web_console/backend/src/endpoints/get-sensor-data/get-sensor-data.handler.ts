@@ -71,6 +71,9 @@ export class GetSensorDataHandler implements IRouterHandler {
           pressure: 1,
           temperature: 1,
           gasResistance: 1,
+          iaq: 1,
+          co2Equivalent: 1,
+          breathVocEquivalent: 1,
           year: { $year: '$createdOn' },
           month: { $month: '$createdOn' },
           day: { $dayOfMonth: '$createdOn' },
@@ -104,6 +107,9 @@ export class GetSensorDataHandler implements IRouterHandler {
               pressure: '$pressure',
               temperature: '$temperature',
               gasResistance: '$gasResistance',
+              iaq: '$iaq',
+              co2Equivalent: '$co2Equivalent',
+              breathVocEquivalent: '$breathVocEquivalent',
             },
           },
         },
@@ -111,11 +117,15 @@ export class GetSensorDataHandler implements IRouterHandler {
       {
         $project: {
           _id: 0,
+          id: '$_id.deviceId',
           device: '$_id.deviceName',
           humidity: '$lastest.humidity',
           pressure: '$lastest.pressure',
           temperature: '$lastest.temperature',
           gasResistance: '$lastest.gasResistance',
+          iaq: '$lastest.iaq',
+          co2Equivalent: '$lastest.co2Equivalent',
+          breathVocEquivalent: '$lastest.breathVocEquivalent',
         },
       },
       {
@@ -37,6 +37,26 @@ export interface DataPointInfo {
    */
   gasResistance: number | undefined;
 
+  /**
+   * The indoor air quality index (0 to 500).
+   */
+  iaq?: number;
+
+  /**
+   * The accuracy of the indoor air quality index (0 to 3).
+   */
+  iaqAccuracy?: number;
+
+  /**
+   * The CO2 equivalent (in ppm).
+   */
+  co2Equivalent?: number;
+
+  /**
+   * The breath VOC equivalent (in ppm).
+   */
+  breathVocEquivalent?: number;
+
   /**
    * The time when this data point was created.
    */